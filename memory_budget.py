@@ -0,0 +1,70 @@
+#!/usr/bin/python3
+
+# Adds a PlatformIO post-link step reporting flash, static RAM and retained RAM (.noinit)
+# against the env's custom_*_budget options, plus the largest RAM symbols.
+# Over-budget sections are reported as warnings, the build is not failed.
+
+import subprocess
+
+Import("env")
+
+RAM_START = 0x20000000
+TOP_SYMBOLS = 12
+
+
+def budget(name):
+    value = env.GetProjectOption(name, "")
+    return int(value, 0) if value else None
+
+
+def read_sections(elf):
+    out = subprocess.check_output([env.subst("$SIZETOOL"), "-A", elf], text=True)
+    sections = []
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) == 3 and parts[0].startswith(".") and parts[1].isdigit():
+            sections.append((parts[0], int(parts[1]), int(parts[2])))
+    return sections
+
+
+def ram_symbols(elf):
+    size_tool = env.subst("$SIZETOOL")
+    nm_tool = size_tool[:-len("size")] + "nm" if size_tool.endswith("size") else "nm"
+    out = subprocess.check_output([nm_tool, "-S", "-C", "--size-sort", elf], text=True)
+    symbols = []
+    for line in out.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) == 4 and parts[2] in "bBdD":
+            symbols.append((int(parts[1], 16), parts[3]))
+    return sorted(symbols, reverse=True)[:TOP_SYMBOLS]
+
+
+def line(label, used, limit):
+    if limit is None:
+        print(f"  {label:<9} {used:>7} bytes")
+        return
+    pct = 100.0 * used / limit
+    flag = "  WARNING: over budget" if used > limit else ""
+    print(f"  {label:<9} {used:>7} / {limit} bytes ({pct:.1f}%){flag}")
+
+
+def report_budget(source, target, env):
+    elf = str(target[0])
+    sections = read_sections(elf)
+
+    # .heap and .stack_dummy only reserve address space, the rest of RAM is the heap
+    ram = [(n, s) for n, s, a in sections if a >= RAM_START and n not in (".heap", ".stack_dummy")]
+    flash = sum(s for n, s, a in sections if 0 < a < RAM_START) + sum(s for n, s in ram if n == ".data")
+    static_ram = sum(s for n, s in ram)
+    retained = sum(s for n, s in ram if n == ".noinit")
+
+    print(f"Memory budget ({env['PIOENV']}):")
+    line("flash", flash, budget("custom_flash_budget"))
+    line("RAM", static_ram, budget("custom_ram_budget"))
+    line("retained", retained, budget("custom_retained_budget"))
+    print("  largest RAM symbols:")
+    for size, name in ram_symbols(elf):
+        print(f"    {size:>7}  {name}")
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", report_budget)
@@ -2,6 +2,7 @@
 """
 Decoder for Sleepy Sensor MQTT JSON messages
 Decodes Cayenne LPP formatted telemetry data from the 'raw' payload field
+(single readings, batches, and compact delta-encoded batches)
 """
 
 import json
@@ -16,6 +17,17 @@ try:
 except ImportError:
     CRYPTO_AVAILABLE = False
 
+# Precompiled layouts of the telemetry packet (see SensorMesh.h)
+HEADER = struct.Struct('>IB')           # RTC timestamp, flags
+BATCH_RECORD = struct.Struct('<HB')     # dt seconds after timestamp, LPP length
+HEADER_SIZE = HEADER.size
+S16 = struct.Struct('>h')
+S16X3 = struct.Struct('>hhh')
+
+# Plausible RTC timestamps: 2000-2100
+MIN_TIMESTAMP = 946684800
+MAX_TIMESTAMP = 4102444800
+
 
 class CayenneLPPDecoder:
     """Cayenne LPP (Low Power Payload) decoder"""
@@ -105,20 +117,16 @@ class CayenneLPPDecoder:
     @staticmethod
     def decode_accelerometer(data: bytes) -> Dict[str, float]:
         """Decode accelerometer data (6 bytes: x, y, z in milli-g)"""
-        x = struct.unpack('>h', data[0:2])[0] / 1000.0
-        y = struct.unpack('>h', data[2:4])[0] / 1000.0
-        z = struct.unpack('>h', data[4:6])[0] / 1000.0
+        x, y, z = S16X3.unpack_from(data)
 
-        return {"x": x, "y": y, "z": z}
+        return {"x": x / 1000.0, "y": y / 1000.0, "z": z / 1000.0}
 
     @staticmethod
     def decode_gyrometer(data: bytes) -> Dict[str, float]:
         """Decode gyrometer data (6 bytes: x, y, z in 0.01 deg/s)"""
-        x = struct.unpack('>h', data[0:2])[0] / 100.0
-        y = struct.unpack('>h', data[2:4])[0] / 100.0
-        z = struct.unpack('>h', data[4:6])[0] / 100.0
+        x, y, z = S16X3.unpack_from(data)
 
-        return {"x": x, "y": y, "z": z}
+        return {"x": x / 100.0, "y": y / 100.0, "z": z / 100.0}
 
     @staticmethod
     def decode_colour(data: bytes) -> Dict[str, int]:
@@ -187,6 +195,92 @@ class CayenneLPPDecoder:
 
         return readings
 
+    # Per-component value sizes of multi-value types (everything else is one value of TYPE_INFO size)
+    COMPONENT_SIZES = {
+        0x88: (3, 3, 3),
+        0x71: (2, 2, 2),
+        0x86: (2, 2, 2),
+    }
+
+    def _component_sizes(self, data_type: int) -> Optional[Tuple[int, ...]]:
+        if data_type in self.COMPONENT_SIZES:
+            return self.COMPONENT_SIZES[data_type]
+        if data_type in self.TYPE_INFO:
+            return (self.TYPE_INFO[data_type][0],)
+        return None
+
+    def decode_compact(self, base_time: int, body: bytes) -> Tuple[List[Tuple[int, bytes]], int]:
+        """
+        Rebuild the CayenneLPP bytes of each record of a compact batch (see CompactTelemetry.h)
+
+        Returns:
+            ([(timestamp, lpp_bytes), ...], bytes consumed)
+        """
+        records = []
+        if len(body) < 1:
+            return records, len(body)
+
+        pos = 1
+
+        def varint():
+            nonlocal pos
+            value = 0
+            shift = 0
+            while pos < len(body) and shift < 35:
+                b = body[pos]
+                pos += 1
+                value |= (b & 0x7F) << shift
+                if not (b & 0x80):
+                    return value
+                shift += 7
+            return None
+
+        layout = None
+        prev = []
+        last_time = base_time
+        for _ in range(body[0]):
+            hdr = varint()
+            if hdr is None:
+                break
+            if hdr & 1:
+                if pos >= len(body) or pos + 1 + 2 * body[pos] > len(body):
+                    break
+                n = body[pos]
+                layout = [(body[pos + 1 + 2 * f], body[pos + 2 + 2 * f]) for f in range(n)]
+                pos += 1 + 2 * n
+                prev = []
+            elif layout is None:
+                break
+
+            lpp = bytearray()
+            values = []
+            ok = True
+            for channel, data_type in layout:
+                sizes = self._component_sizes(data_type)
+                if sizes is None:
+                    ok = False
+                    break
+                lpp += bytes([channel, data_type])
+                for size in sizes:
+                    zz = varint()
+                    if zz is None:
+                        ok = False
+                        break
+                    delta = (zz >> 1) ^ -(zz & 1)
+                    raw = ((prev[len(values)] if prev else 0) + delta) & 0xFFFFFFFF
+                    values.append(raw)
+                    lpp += (raw & ((1 << (8 * size)) - 1)).to_bytes(size, byteorder='big')
+                if not ok:
+                    break
+            if not ok:
+                break
+
+            prev = values
+            last_time += hdr >> 1
+            records.append((last_time, bytes(lpp)))
+
+        return records, pos
+
 
 class MQTTPacketDecoder:
     """Decoder for Sleepy Sensor MQTT packets"""
@@ -194,6 +288,19 @@ class MQTTPacketDecoder:
     # Default PSK for public channel (all zeros, 16 bytes for AES-128)
     PUBLIC_CHANNEL_PSK = bytes(16)
 
+    # Flags byte bits (see TELEM_FLAG_* in SensorMesh.h)
+    FLAG_BATCH = 0x01
+    FLAG_LISTEN = 0x02      # node keeps RX open briefly after this packet (downlink window)
+    SCHEMA_SHIFT = 4        # bits 4-7: body schema id
+    SCHEMA_MASK = 0xF0
+    SCHEMA_LPP = 0
+    SCHEMA_COMPACT = 1      # delta-encoded batch (CompactTelemetry.h)
+    KNOWN_SCHEMAS = (SCHEMA_LPP, SCHEMA_COMPACT)
+    KNOWN_FLAGS = FLAG_BATCH | FLAG_LISTEN | SCHEMA_MASK
+
+    # Candidate offsets of the ciphertext in the 'raw' field
+    DECRYPT_OFFSETS = (0, 4, 8, 9, 12, 16)
+
     def __init__(self, psk: Optional[bytes] = None, auto_decrypt: bool = True):
         """
         Initialize decoder
@@ -207,6 +314,20 @@ class MQTTPacketDecoder:
         self.psk = psk if psk is not None else self.PUBLIC_CHANNEL_PSK
         self.auto_decrypt = auto_decrypt and CRYPTO_AVAILABLE
 
+        # Cipher objects per PSK (AES-ECB keeps no state between decrypts, so one object serves every packet)
+        self._ciphers: Dict[bytes, Any] = {}
+
+        # Offset of the ciphertext in 'raw' that last decrypted, tried first on the next packet
+        self._decrypt_offset = 0
+
+    def _cipher(self, psk: bytes):
+        """AES-ECB cipher for a PSK, created once"""
+        cipher = self._ciphers.get(psk)
+        if cipher is None:
+            cipher = AES.new(psk, AES.MODE_ECB)
+            self._ciphers[psk] = cipher
+        return cipher
+
     def decode_raw_payload(self, raw_hex: str) -> Dict[str, Any]:
         """
         Decode the raw hex payload from the MQTT message
@@ -215,8 +336,9 @@ class MQTTPacketDecoder:
         - Entire payload is encrypted if private channel is used
         - If unencrypted (public channel):
           - Bytes 0-3: RTC timestamp (32-bit, big-endian)
-          - Byte 4: Flags (reserved, currently 0x00)
-          - Bytes 5+: Cayenne LPP sensor data
+          - Byte 4: Flags (0x01 = batch)
+          - Bytes 5+: Cayenne LPP sensor data, or for a batch:
+            [count] then count x { [dt u16 LE, seconds after timestamp] [len] [LPP] }
 
         Args:
             raw_hex: Hex string of the raw payload
@@ -227,22 +349,17 @@ class MQTTPacketDecoder:
         # Convert hex string to bytes
         raw_bytes = bytes.fromhex(raw_hex)
 
-        if len(raw_bytes) < 5:
+        if len(raw_bytes) < HEADER_SIZE:
             return {
                 "error": "Payload too short (minimum 5 bytes required)",
                 "raw": raw_hex
             }
 
-        # Try to decode as unencrypted packet
-        # Extract timestamp (bytes 0-3, big-endian 32-bit)
-        timestamp = struct.unpack('>I', raw_bytes[0:4])[0]
-
-        # Extract flags (byte 4)
-        flags = raw_bytes[4]
+        # Try to decode as unencrypted packet: timestamp (big-endian 32-bit) and flags
+        timestamp, flags = HEADER.unpack_from(raw_bytes)
 
         # Extract and decode LPP data (bytes 5+)
-        lpp_data = raw_bytes[5:]
-        sensor_readings = self.lpp_decoder.decode_lpp(lpp_data)
+        sensor_readings, records = self._decode_body(timestamp, flags, raw_bytes[HEADER_SIZE:])
 
         # Detect if packet is likely encrypted
         is_encrypted = self._detect_encryption(raw_bytes, sensor_readings, timestamp)
@@ -258,16 +375,16 @@ class MQTTPacketDecoder:
             if decrypted:
                 # Successfully decrypted, re-parse the decrypted data
                 decryption_successful = True
-                timestamp = struct.unpack('>I', decrypted[0:4])[0]
-                flags = decrypted[4]
-                lpp_data = decrypted[5:]
-                sensor_readings = self.lpp_decoder.decode_lpp(lpp_data)
+                timestamp, flags = HEADER.unpack_from(decrypted)
+                sensor_readings, records = self._decode_body(timestamp, flags, decrypted[HEADER_SIZE:])
                 is_encrypted = False  # Mark as decrypted
 
         result = {
             "rtc_timestamp": timestamp,
             "rtc_datetime": datetime.fromtimestamp(timestamp, timezone.utc).isoformat() if timestamp > 0 and timestamp < 2**31 else "Not set",
             "flags": f"0x{flags:02X}",
+            "listen_window": bool(flags & self.FLAG_LISTEN),
+            "schema": "compact" if self._schema(flags) == self.SCHEMA_COMPACT else "lpp",
             "sensor_count": len(sensor_readings),
             "sensors": sensor_readings,
             "encrypted": is_encrypted,
@@ -275,6 +392,9 @@ class MQTTPacketDecoder:
             "decryption_successful": decryption_successful
         }
 
+        if records is not None:
+            result["records"] = records
+
         if is_encrypted:
             result["warning"] = "This packet appears to be ENCRYPTED (private channel). Decryption requires the PSK (Pre-Shared Key) configured on the device."
             result["decryption_help"] = {
@@ -293,6 +413,55 @@ class MQTTPacketDecoder:
 
         return result
 
+    def _schema(self, flags: int) -> int:
+        return (flags & self.SCHEMA_MASK) >> self.SCHEMA_SHIFT
+
+    def _decode_body(self, timestamp: int, flags: int, body: bytes):
+        """
+        Decode the bytes following the timestamp + flags header
+
+        Returns:
+            (sensor_readings, records) - records is None for single-reading packets,
+            otherwise one {"rtc_timestamp", "sensors"} entry per batched wake.
+            For batches, sensor_readings is the flattened list with per-reading timestamps.
+        """
+        if not (flags & self.FLAG_BATCH):
+            return self.lpp_decoder.decode_lpp(body), None
+
+        records = []
+        sensor_readings = []
+        if len(body) < 1:
+            return sensor_readings, records
+
+        if self._schema(flags) == self.SCHEMA_COMPACT:
+            for record_ts, lpp in self.lpp_decoder.decode_compact(timestamp, body)[0]:
+                readings = self.lpp_decoder.decode_lpp(lpp)
+                for reading in readings:
+                    reading["rtc_timestamp"] = record_ts
+                records.append({"rtc_timestamp": record_ts, "sensors": readings})
+                sensor_readings.extend(readings)
+            return sensor_readings, records
+
+        count = body[0]
+        pos = 1
+        for _ in range(count):
+            if pos + BATCH_RECORD.size > len(body):
+                break
+            dt, length = BATCH_RECORD.unpack_from(body, pos)
+            pos += BATCH_RECORD.size
+            if pos + length > len(body):
+                break
+            readings = self.lpp_decoder.decode_lpp(body[pos:pos + length])
+            pos += length
+
+            record_ts = timestamp + dt
+            for reading in readings:
+                reading["rtc_timestamp"] = record_ts
+            records.append({"rtc_timestamp": record_ts, "sensors": readings})
+            sensor_readings.extend(readings)
+
+        return sensor_readings, records
+
     def _detect_encryption(self, raw_bytes: bytes, sensor_readings: List, timestamp: int) -> bool:
         """
         Detect if a packet is likely encrypted
@@ -318,7 +487,7 @@ class MQTTPacketDecoder:
                 return True
 
             # Check for unrealistic timestamp (1970-2000 or > 2100)
-            if timestamp < 946684800 or timestamp > 4102444800:  # Before 2000 or after 2100
+            if timestamp < MIN_TIMESTAMP or timestamp > MAX_TIMESTAMP:
                 return True
 
             # High entropy check - encrypted data should have relatively uniform byte distribution
@@ -354,10 +523,13 @@ class MQTTPacketDecoder:
             return None
 
         psk = psk if psk is not None else self.psk
+        cipher = self._cipher(psk)
 
         # Try different offsets (the "raw" field may include headers)
         # Common offsets: 0 (no header), 4 (MAC), 9 (packet header), etc.
-        for offset in [0, 4, 8, 9, 12, 16]:
+        # One feed always uses the same framing, so the offset that worked last time goes first.
+        offsets = [self._decrypt_offset] + [o for o in self.DECRYPT_OFFSETS if o != self._decrypt_offset]
+        for offset in offsets:
             try:
                 if offset >= len(encrypted_data):
                     continue
@@ -370,7 +542,6 @@ class MQTTPacketDecoder:
                     continue
 
                 # Decrypt using AES-ECB (matches MeshCore's encrypt() function)
-                cipher = AES.new(psk, AES.MODE_ECB)
                 decrypted = cipher.decrypt(ciphertext)
 
                 # Remove zero-padding (MeshCore pads with zeros, not PKCS7)
@@ -379,10 +550,12 @@ class MQTTPacketDecoder:
 
                 # Validate: check if decrypted data looks reasonable
                 if self._is_valid_decrypted_data(decrypted_trimmed):
+                    self._decrypt_offset = offset
                     return decrypted_trimmed
 
                 # Also try without trimming (in case there are legitimate zero bytes)
                 if self._is_valid_decrypted_data(decrypted):
+                    self._decrypt_offset = offset
                     return decrypted
 
             except Exception as e:
@@ -410,6 +583,23 @@ class MQTTPacketDecoder:
         min_len = 5
         pos = 5
 
+        # Compact batch: the record count bounds the parse
+        if data[4] & self.FLAG_BATCH and self._schema(data[4]) == self.SCHEMA_COMPACT:
+            timestamp = HEADER.unpack_from(data)[0]
+            _, used = self.lpp_decoder.decode_compact(timestamp, data[5:])
+            return data[:5 + used]
+
+        # Batch body: count followed by length-prefixed records
+        if data[4] & self.FLAG_BATCH:
+            if len(data) < 6:
+                return data
+            pos = 6
+            for _ in range(data[5]):
+                if pos + 3 > len(data):
+                    return data
+                pos += 3 + data[pos + 2]
+            return data[:pos] if pos <= len(data) else data
+
         # Parse LPP data to find actual end
         while pos < len(data):
             channel = data[pos]
@@ -459,15 +649,18 @@ class MQTTPacketDecoder:
             return False
 
         # Check timestamp (bytes 0-3)
-        timestamp = struct.unpack('>I', data[0:4])[0]
-        # Reasonable timestamp: 2000-2100
-        if not (946684800 <= timestamp <= 4102444800):
+        timestamp = HEADER.unpack_from(data)[0]
+        if not (MIN_TIMESTAMP <= timestamp <= MAX_TIMESTAMP):
             return False
 
-        # Check flags byte (should be 0x00)
-        if data[4] != 0x00:
+        # Check flags byte (only known bits may be set)
+        if data[4] & ~self.KNOWN_FLAGS or self._schema(data[4]) not in self.KNOWN_SCHEMAS:
             return False
 
+        # Batch: record count must be non-zero
+        if data[4] & self.FLAG_BATCH:
+            return len(data) > 5 and data[5] > 0
+
         # Check if we have LPP data
         if len(data) > 5:
             # First LPP byte should be a channel number (0x00-0x0F typical, or end marker)
@@ -491,6 +684,18 @@ class MQTTPacketDecoder:
         except json.JSONDecodeError as e:
             return {"error": f"Invalid JSON: {e}"}
 
+        return self.decode_mqtt_message(data)
+
+    def decode_mqtt_message(self, data: Dict[str, Any]) -> Dict[str, Any]:
+        """
+        Decode an MQTT message that has already been parsed from JSON
+
+        Args:
+            data: Parsed MQTT JSON object
+
+        Returns:
+            Dictionary with packet metadata and decoded payload
+        """
         # Decode the raw payload
         decoded_payload = {}
         if "raw" in data:
@@ -567,6 +772,10 @@ def pretty_print_decoded(decoded: Dict[str, Any]) -> None:
 
             print(f"  RTC Timestamp  : {payload.get('rtc_timestamp')} ({payload.get('rtc_datetime')})")
             print(f"  Flags          : {payload.get('flags')}")
+            if payload.get('schema') == "compact":
+                print(f"  Schema         : compact (delta-encoded batch)")
+            if payload.get('listen_window'):
+                print(f"  Listen Window  : open now - send downlink immediately")
             print(f"  Encrypted      : {payload.get('encrypted', False)}")
 
             if payload.get('decryption_attempted'):
@@ -580,11 +789,16 @@ def pretty_print_decoded(decoded: Dict[str, Any]) -> None:
 
             print(f"  Sensor Count   : {payload.get('sensor_count')}")
 
+            if payload.get("records") is not None and not payload.get("encrypted"):
+                print(f"  Batch Records  : {len(payload['records'])}")
+
             if payload.get("sensors") and not payload.get("encrypted"):
                 print("\n  🔬 SENSOR READINGS:")
                 for i, sensor in enumerate(payload["sensors"], 1):
                     print(f"\n    [{i}] Channel {sensor['channel']}: {sensor['name']}")
                     print(f"        Type  : {sensor['type']}")
+                    if "rtc_timestamp" in sensor:
+                        print(f"        Time  : {sensor['rtc_timestamp']}")
 
                     if isinstance(sensor['value'], dict):
                         print(f"        Value :")
@@ -0,0 +1,342 @@
+#!/usr/bin/env python3
+"""
+Ingest pipeline for Sleepy Sensor MQTT messages
+Drops the copies of a flood heard by several observers, decodes in batches
+(optionally on a pool of worker processes) and writes the readings to a
+time-series sink in batches
+"""
+
+import json
+import queue
+import threading
+import time
+from collections import OrderedDict
+from concurrent.futures import ProcessPoolExecutor
+from typing import Any, Callable, Dict, List, Optional, Tuple
+
+from mqtt_decoder import MQTTPacketDecoder
+
+
+class DedupCache:
+    """Packet keys seen within the last `window` seconds (oldest evicted first, bounded)"""
+
+    def __init__(self, window: float = 30.0, max_entries: int = 65536):
+        self.window = window
+        self.max_entries = max_entries
+        self._entries: "OrderedDict[str, float]" = OrderedDict()
+
+    def seen(self, key: str, now: float) -> bool:
+        """
+        Check a key and remember it
+
+        Only the first sighting is timed: a flood that keeps arriving does not extend its own window.
+
+        Returns:
+            True if the key was already seen within the window
+        """
+        entries = self._entries
+        while entries:
+            oldest_key, oldest_time = next(iter(entries.items()))
+            if now - oldest_time <= self.window and len(entries) < self.max_entries:
+                break
+            entries.popitem(last=False)
+
+        if key in entries:
+            return True
+        entries[key] = now
+        return False
+
+    def __len__(self) -> int:
+        return len(self._entries)
+
+
+class LineProtocolSink:
+    """
+    Time-series sink writing InfluxDB line protocol, one append per batch
+
+    One point per reading: tags origin (first observer heard), channel and sensor name;
+    field 'value' (or one field per component for GPS/accelerometer/gyrometer/colour);
+    timestamp in seconds from the node's RTC. Load with e.g.
+    `influx write --precision s --file readings.lp`.
+    """
+
+    def __init__(self, path: str, measurement: str = "sleepy_sensor",
+                 batch_rows: int = 500, flush_interval: float = 5.0):
+        self.path = path
+        self.measurement = measurement
+        self.batch_rows = batch_rows
+        self.flush_interval = flush_interval
+        self.rows_written = 0
+        self.writes = 0
+        self._lines: List[str] = []
+        self._last_flush = time.monotonic()
+        self._file = open(path, "a", encoding="utf-8")
+
+    @staticmethod
+    def _tag(value: Any) -> str:
+        return str(value).replace("\\", "\\\\").replace(",", "\\,").replace("=", "\\=").replace(" ", "\\ ")
+
+    def add(self, decoded: Dict[str, Any]) -> None:
+        """Queue the readings of one decoded packet (undecoded or failed packets add nothing)"""
+        payload = decoded.get("payload", {})
+        if "error" in payload or payload.get("encrypted"):
+            return
+
+        origin = self._tag(decoded.get("packet_info", {}).get("origin_id") or "unknown")
+        packet_ts = payload.get("rtc_timestamp", 0)
+        for sensor in payload.get("sensors", []):
+            value = sensor["value"]
+            if isinstance(value, dict):
+                fields = ",".join(f"{self._tag(k)}={v}" for k, v in value.items())
+            else:
+                fields = f"value={value}"
+            self._lines.append(f"{self.measurement},origin={origin},channel={sensor['channel']},"
+                               f"sensor={self._tag(sensor['name'])} {fields} "
+                               f"{sensor.get('rtc_timestamp', packet_ts)}")
+
+    def maybe_flush(self) -> None:
+        """Write out when enough rows are queued or the oldest has waited flush_interval"""
+        if len(self._lines) >= self.batch_rows or \
+                (self._lines and time.monotonic() - self._last_flush >= self.flush_interval):
+            self.flush()
+
+    def flush(self) -> None:
+        self._last_flush = time.monotonic()
+        if not self._lines:
+            return
+        self._file.write("\n".join(self._lines) + "\n")
+        self._file.flush()
+        self.rows_written += len(self._lines)
+        self.writes += 1
+        self._lines = []
+
+    def close(self) -> None:
+        self.flush()
+        self._file.close()
+
+
+# Decoder of a worker process, built once by the pool initializer (keeps its cipher cache)
+_worker_decoder: Optional[MQTTPacketDecoder] = None
+
+
+def _init_worker(psk: Optional[bytes]) -> None:
+    global _worker_decoder
+    _worker_decoder = MQTTPacketDecoder(psk=psk)
+
+
+def _decode_one(decoder: MQTTPacketDecoder, message: Dict[str, Any]) -> Tuple[Optional[Dict[str, Any]], Optional[str]]:
+    """Decode one message: (decoded, None), or (None, error) if the decoder raised"""
+    try:
+        return decoder.decode_mqtt_message(message), None
+    except Exception as e:
+        return None, f"{type(e).__name__}: {e}"
+
+
+def _decode_chunk(messages: List[Dict[str, Any]]) -> List[Tuple[Optional[Dict[str, Any]], Optional[str]]]:
+    return [_decode_one(_worker_decoder, m) for m in messages]
+
+
+class IngestPipeline:
+    """
+    Receive -> dedup -> batch decode -> sink, off the MQTT network thread
+
+    submit() only timestamps and queues the message, so the paho thread never falls behind.
+    A dispatcher thread takes up to batch_size messages at a time (waiting at most batch_wait
+    for a batch to fill), parses them, drops packets whose hash was already seen within
+    dedup_window, and decodes the rest: inline, or split across `workers` processes.
+    Results go to on_decoded (in arrival order) and to the sink.
+    """
+
+    def __init__(self, psk: Optional[bytes] = None, workers: int = 0,
+                 batch_size: int = 64, batch_wait: float = 0.05, dedup_window: float = 30.0,
+                 queue_size: int = 10000, sink: Optional[LineProtocolSink] = None,
+                 on_decoded: Optional[Callable[[str, Dict[str, Any]], None]] = None,
+                 on_error: Optional[Callable[[str, str], None]] = None):
+        """
+        Initialize the pipeline
+
+        Args:
+            psk: Pre-shared key for decryption (None = all-zeros public channel)
+            workers: Decoder processes (0 = decode on the dispatcher thread)
+            batch_size: Maximum messages decoded together
+            batch_wait: Seconds to wait for a batch to fill once its first message arrived
+            dedup_window: Seconds a packet hash is remembered (0 = no dedup)
+            queue_size: Messages buffered before new ones are dropped
+            sink: Time-series sink for the decoded readings (optional)
+            on_decoded: Called with (topic, decoded) for every unique packet
+            on_error: Called with (topic, message) for messages that are not valid JSON or fail to decode
+        """
+        self.decoder = MQTTPacketDecoder(psk=psk)
+        self.workers = workers
+        self.batch_size = batch_size
+        self.batch_wait = batch_wait
+        self.dedup = DedupCache(dedup_window) if dedup_window > 0 else None
+        self.sink = sink
+        self.on_decoded = on_decoded
+        self.on_error = on_error
+
+        self._queue: "queue.Queue" = queue.Queue(maxsize=queue_size)
+        self._pool = ProcessPoolExecutor(max_workers=workers, initializer=_init_worker,
+                                         initargs=(psk,)) if workers > 0 else None
+        self._thread = threading.Thread(target=self._run, name="ingest", daemon=True)
+
+        # Statistics
+        self.received = 0
+        self.dropped = 0            # queue full
+        self.duplicates = 0
+        self.decoded = 0
+        self.failed = 0
+        self.batches = 0
+        self.lag_last = 0.0         # seconds from receive to decoded
+        self.lag_max = 0.0
+        self._lag_sum = 0.0
+        self._lag_count = 0
+        self.start_time = time.monotonic()
+
+    def start(self) -> None:
+        self._thread.start()
+
+    def submit(self, payload: bytes, topic: str) -> None:
+        """Queue a message (called on the MQTT network thread)"""
+        self.received += 1
+        try:
+            self._queue.put_nowait((time.monotonic(), topic, payload))
+        except queue.Full:
+            self.dropped += 1
+
+    def stop(self) -> None:
+        """Decode what is queued, flush the sink and shut the workers down"""
+        self._queue.put(None)
+        self._thread.join()
+        if self._pool:
+            self._pool.shutdown()
+        if self.sink:
+            self.sink.close()
+
+    def _next_batch(self) -> Optional[List]:
+        first = self._queue.get()
+        if first is None:
+            return None
+        batch = [first]
+        deadline = time.monotonic() + self.batch_wait
+        while len(batch) < self.batch_size:
+            remaining = deadline - time.monotonic()
+            try:
+                item = self._queue.get(timeout=remaining) if remaining > 0 else self._queue.get_nowait()
+            except queue.Empty:
+                break
+            if item is None:
+                self._queue.put(None)   # stop after this batch
+                break
+            batch.append(item)
+        return batch
+
+    def _decode(self, messages: List[Dict[str, Any]]) -> List[Tuple[Optional[Dict[str, Any]], Optional[str]]]:
+        """One (decoded, error) per message, in order; a message that raises only fails itself"""
+        if not self._pool or len(messages) < 2:
+            return [_decode_one(self.decoder, m) for m in messages]
+        step = -(-len(messages) // self.workers)
+        chunks = [messages[i:i + step] for i in range(0, len(messages), step)]
+        futures = [self._pool.submit(_decode_chunk, chunk) for chunk in chunks]
+        results = []
+        for chunk, future in zip(chunks, futures):
+            try:
+                results.extend(future.result())
+            except Exception:
+                # worker died or the chunk could not be sent: decode it here instead
+                results.extend(_decode_one(self.decoder, m) for m in chunk)
+        return results
+
+    def _report_error(self, topic: str, message: str, count: bool = True) -> None:
+        if count:
+            self.failed += 1
+        if self.on_error:
+            try:
+                self.on_error(topic, message)
+            except Exception:
+                pass
+
+    def _run(self) -> None:
+        """Dispatcher loop: only a stop() ends it, a bad message or callback only fails itself"""
+        while True:
+            batch = self._next_batch()
+            if batch is None:
+                break
+            try:
+                self._process(batch)
+            except Exception as e:
+                self._report_error("", f"ingest error: {type(e).__name__}: {e}")
+
+    def _process(self, batch: List) -> None:
+        # Parse and drop the copies heard by other observers before paying for the decode
+        messages, topics, received_at = [], [], []
+        for recv_time, topic, payload in batch:
+            try:
+                data = json.loads(payload)
+                if not isinstance(data, dict):
+                    raise ValueError("not a JSON object")
+            except (ValueError, UnicodeDecodeError):
+                self._report_error(topic, payload[:100].decode("utf-8", "replace"))
+                continue
+            key = data.get("hash") or data.get("raw")
+            if self.dedup is not None and isinstance(key, str) and key and self.dedup.seen(key, recv_time):
+                self.duplicates += 1
+                continue
+            messages.append(data)
+            topics.append(topic)
+            received_at.append(recv_time)
+
+        results = self._decode(messages) if messages else []
+        self.batches += 1
+
+        now = time.monotonic()
+        for topic, recv_time, (decoded, error) in zip(topics, received_at, results):
+            if error is not None:
+                self._report_error(topic, f"decode error: {error}")
+                continue
+
+            payload = decoded.get("payload", {})
+            if payload.get("decryption_successful") or not payload.get("encrypted"):
+                self.decoded += 1
+            else:
+                self.failed += 1
+
+            lag = now - recv_time
+            self.lag_last = lag
+            self.lag_max = max(self.lag_max, lag)
+            self._lag_sum += lag
+            self._lag_count += 1
+
+            try:
+                if self.sink:
+                    self.sink.add(decoded)
+                if self.on_decoded:
+                    self.on_decoded(topic, decoded)
+            except Exception as e:
+                self._report_error(topic, f"output error: {type(e).__name__}: {e}", count=False)   # already counted
+
+        if self.sink:
+            try:
+                self.sink.maybe_flush()
+            except OSError as e:
+                self._report_error("", f"sink write failed: {e}", count=False)
+
+    def stats(self) -> Dict[str, Any]:
+        """Counters, throughput and lag since start"""
+        uptime = time.monotonic() - self.start_time
+        return {
+            "uptime": uptime,
+            "received": self.received,
+            "queued": self._queue.qsize(),
+            "dropped": self.dropped,
+            "duplicates": self.duplicates,
+            "decoded": self.decoded,
+            "failed": self.failed,
+            "batches": self.batches,
+            "rate": (self.decoded + self.failed) / uptime if uptime > 0 else 0.0,
+            "lag_last": self.lag_last,
+            "lag_avg": self._lag_sum / self._lag_count if self._lag_count else 0.0,
+            "lag_max": self.lag_max,
+            "sink_rows": self.sink.rows_written if self.sink else 0,
+            "sink_writes": self.sink.writes if self.sink else 0,
+        }
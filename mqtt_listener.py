@@ -8,6 +8,7 @@ import sys
 import json
 import argparse
 import ssl
+import time
 from datetime import datetime
 
 try:
@@ -19,6 +20,7 @@ except ImportError:
     sys.exit(1)
 
 from mqtt_decoder import MQTTPacketDecoder, pretty_print_decoded, CRYPTO_AVAILABLE
+from mqtt_ingest import IngestPipeline, LineProtocolSink
 
 
 class SensorMQTTListener:
@@ -28,7 +30,9 @@ class SensorMQTTListener:
                  psk: bytes = None, username: str = None, password: str = None,
                  use_tls: bool = False, tls_insecure: bool = False,
                  ca_certs: str = None, certfile: str = None, keyfile: str = None,
-                 verbose: bool = False):
+                 verbose: bool = False, quiet: bool = False, workers: int = 0,
+                 batch_size: int = 64, dedup_window: float = 30.0, sink_path: str = None,
+                 stats_interval: float = 0):
         """
         Initialize MQTT listener
 
@@ -45,6 +49,12 @@ class SensorMQTTListener:
             certfile: Path to client certificate file
             keyfile: Path to client key file
             verbose: Show verbose output
+            quiet: Don't print each decoded packet (for large meshes; use with sink_path/stats_interval)
+            workers: Decoder processes (0 = decode on the ingest thread)
+            batch_size: Maximum messages decoded together
+            dedup_window: Seconds a packet hash is remembered to drop copies from other observers (0 = off)
+            sink_path: Append readings to this file as InfluxDB line protocol (optional)
+            stats_interval: Print statistics every this many seconds (0 = only on exit)
         """
         self.broker = broker
         self.port = port
@@ -54,15 +64,20 @@ class SensorMQTTListener:
         self.use_tls = use_tls
         self.tls_insecure = tls_insecure
         self.verbose = verbose
-
-        # Create decoder
-        self.decoder = MQTTPacketDecoder(psk=psk)
-
-        # Statistics
-        self.packets_received = 0
-        self.packets_decoded = 0
-        self.packets_failed = 0
-        self.start_time = datetime.now()
+        self.quiet = quiet
+        self.stats_interval = stats_interval
+
+        # Decode off the network thread: dedup, batch decode, batched sink writes
+        self.pipeline = IngestPipeline(
+            psk=psk,
+            workers=workers,
+            batch_size=batch_size,
+            dedup_window=dedup_window,
+            sink=LineProtocolSink(sink_path) if sink_path else None,
+            on_decoded=self.on_decoded,
+            on_error=self.on_invalid
+        )
+        self.decoder = self.pipeline.decoder
 
         # Create MQTT client
         self.client = mqtt.Client()
@@ -121,59 +136,55 @@ class SensorMQTTListener:
             print(f"\n⚠️  Unexpected disconnect (code: {rc})")
 
     def on_message(self, client, userdata, msg):
-        """Callback when a message is received"""
-        self.packets_received += 1
-
-        try:
-            # Get message payload
-            payload = msg.payload.decode('utf-8')
+        """Callback when a message is received (network thread: queue it and return)"""
+        self.pipeline.submit(msg.payload, msg.topic)
 
-            if self.verbose:
-                print(f"\n📨 Message received on topic: {msg.topic}")
-                print(f"   Packet #{self.packets_received}")
-                print(f"   Timestamp: {datetime.now().isoformat()}")
-
-            # Try to parse as JSON
-            try:
-                mqtt_json = payload
-                decoded = self.decoder.decode_mqtt_json(mqtt_json)
+        if self.verbose:
+            print(f"\n📨 Message received on topic: {msg.topic}")
+            print(f"   Packet #{self.pipeline.received}")
+            print(f"   Timestamp: {datetime.now().isoformat()}")
 
+    def on_decoded(self, topic, decoded):
+        """Called by the ingest pipeline for every unique packet"""
+        try:
+            if not self.quiet:
                 # Pretty print the decoded message
                 print()  # Blank line for separation
                 pretty_print_decoded(decoded)
 
-                # Check if decryption was successful
-                if decoded.get("payload", {}).get("decryption_successful"):
-                    self.packets_decoded += 1
-                elif decoded.get("payload", {}).get("encrypted"):
-                    self.packets_failed += 1
-                    print("⚠️  Decryption failed - check PSK configuration")
-                else:
-                    self.packets_decoded += 1
-
-                # Show statistics
-                if self.verbose:
-                    self.show_stats()
+            payload = decoded.get("payload", {})
+            if payload.get("encrypted") and not payload.get("decryption_successful"):
+                print("⚠️  Decryption failed - check PSK configuration")
 
-            except json.JSONDecodeError:
-                print(f"⚠️  Non-JSON message on {msg.topic}: {payload[:100]}...")
-                self.packets_failed += 1
+            # Show statistics
+            if self.verbose:
+                self.show_stats()
 
         except Exception as e:
             print(f"❌ Error processing message: {e}")
             if self.verbose:
                 import traceback
                 traceback.print_exc()
-            self.packets_failed += 1
+
+    def on_invalid(self, topic, text):
+        """Called by the ingest pipeline for a message that is not JSON or could not be decoded"""
+        print(f"⚠️  Bad message on {topic}: {text}")
 
     def show_stats(self):
         """Show statistics"""
-        uptime = (datetime.now() - self.start_time).total_seconds()
+        stats = self.pipeline.stats()
         print(f"\n📊 Statistics:")
-        print(f"   Uptime: {uptime:.0f}s")
-        print(f"   Total received: {self.packets_received}")
-        print(f"   Decoded: {self.packets_decoded}")
-        print(f"   Failed: {self.packets_failed}")
+        print(f"   Uptime: {stats['uptime']:.0f}s")
+        print(f"   Total received: {stats['received']}")
+        print(f"   Duplicates: {stats['duplicates']} (same packet from another observer)")
+        print(f"   Decoded: {stats['decoded']}")
+        print(f"   Failed: {stats['failed']}")
+        print(f"   Queued: {stats['queued']} (dropped: {stats['dropped']})")
+        print(f"   Throughput: {stats['rate']:.1f} msg/s in {stats['batches']} batches")
+        print(f"   Lag: {stats['lag_last'] * 1000:.0f} ms last, {stats['lag_avg'] * 1000:.0f} ms avg, "
+              f"{stats['lag_max'] * 1000:.0f} ms max")
+        if self.pipeline.sink:
+            print(f"   Sink: {stats['sink_rows']} rows in {stats['sink_writes']} writes")
         print("="*70)
 
     def run(self):
@@ -189,18 +200,28 @@ class SensorMQTTListener:
                 print(f"Certificate verification: {'Disabled (insecure)' if self.tls_insecure else 'Enabled'}")
             print(f"PSK: {'Custom' if self.decoder.psk != MQTTPacketDecoder.PUBLIC_CHANNEL_PSK else 'Public (all-zeros)'}")
             print(f"Crypto available: {CRYPTO_AVAILABLE}")
+            print(f"Decoder workers: {self.pipeline.workers or 'inline'}, dedup window: {self.pipeline.dedup.window if self.pipeline.dedup else 'off'}")
+            if self.pipeline.sink:
+                print(f"Sink: {self.pipeline.sink.path}")
             print("="*70 + "\n")
 
             # Connect to broker
             self.client.connect(self.broker, self.port, 60)
 
-            # Start listening loop
-            self.client.loop_forever()
+            # Network thread receives, ingest thread decodes; this one only reports
+            self.pipeline.start()
+            self.client.loop_start()
+            while True:
+                time.sleep(self.stats_interval or 3600)
+                if self.stats_interval:
+                    self.show_stats()
 
         except KeyboardInterrupt:
             print("\n\n⏹️  Stopping...")
-            self.show_stats()
+            self.client.loop_stop()
             self.client.disconnect()
+            self.pipeline.stop()
+            self.show_stats()
             print("✓ Disconnected")
 
         except Exception as e:
@@ -242,6 +263,9 @@ Examples:
 
   # Verbose output
   %(prog)s mqtt.example.com -v
+
+  # Large mesh: 4 decoder processes, readings to a line protocol file, stats every minute
+  %(prog)s mqtt.example.com -q --workers 4 --sink readings.lp --stats-interval 60
         """
     )
 
@@ -261,6 +285,15 @@ Examples:
     tls_group.add_argument("--keyfile", help="Path to client key file")
 
     parser.add_argument("-v", "--verbose", action="store_true", help="Verbose output")
+    parser.add_argument("-q", "--quiet", action="store_true", help="Don't print each decoded packet")
+
+    # Ingest options
+    ingest_group = parser.add_argument_group('ingest options')
+    ingest_group.add_argument("--workers", type=int, default=0, help="Decoder processes (default: 0, decode on the ingest thread)")
+    ingest_group.add_argument("--batch", type=int, default=64, help="Maximum messages decoded together (default: 64)")
+    ingest_group.add_argument("--dedup-window", type=float, default=30.0, help="Seconds to drop copies of a packet heard by other observers (default: 30, 0 = off)")
+    ingest_group.add_argument("--sink", help="Append readings to this file as InfluxDB line protocol")
+    ingest_group.add_argument("--stats-interval", type=float, default=0, help="Print statistics every N seconds (default: only on exit)")
 
     args = parser.parse_args()
 
@@ -300,7 +333,13 @@ Examples:
         ca_certs=args.ca_certs,
         certfile=args.certfile,
         keyfile=args.keyfile,
-        verbose=args.verbose
+        verbose=args.verbose,
+        quiet=args.quiet,
+        workers=args.workers,
+        batch_size=args.batch,
+        dedup_window=args.dedup_window,
+        sink_path=args.sink,
+        stats_interval=args.stats_interval
     )
 
     listener.run()
@@ -0,0 +1,135 @@
+#include "CodecCheck.h"
+#include <Arduino.h>
+#include <CayenneLPP.h>
+#include "CompactTelemetry.h"
+#include "LPPUtils.h"
+#include <string.h>
+
+#define CHECK_MAX_RECORDS   40
+#define CHECK_LPP_MAX       64
+
+// Layouts a batch draws from: scalars of every width and sign, and the multi-component types
+static const uint8_t check_types[] = {
+  LPP_VOLTAGE, LPP_TEMPERATURE, LPP_RELATIVE_HUMIDITY, LPP_BAROMETRIC_PRESSURE, LPP_ANALOG_INPUT,
+  LPP_GENERIC_SENSOR, LPP_LUMINOSITY, LPP_COLOUR, LPP_GPS, LPP_ACCELEROMETER, LPP_GYROMETER,
+};
+
+struct CheckRecord {
+  uint32_t timestamp;
+  uint8_t lpp[CHECK_LPP_MAX];
+  uint8_t len;
+};
+
+static uint32_t check_rng;
+
+static uint32_t nextRandom() {
+  check_rng ^= check_rng << 13;
+  check_rng ^= check_rng >> 17;
+  check_rng ^= check_rng << 5;
+  return check_rng;
+}
+
+// One layout: up to 5 fields on distinct channels
+static uint8_t makeLayout(uint8_t* channels, uint8_t* types) {
+  uint8_t n = 1 + nextRandom() % 5;
+  for (uint8_t f = 0; f < n; f++) {
+    channels[f] = f + 1 + (nextRandom() % 3) * 8;
+    types[f] = check_types[nextRandom() % sizeof(check_types)];
+  }
+  return n;
+}
+
+// Raw bytes of a reading: each value drifts a little from prev, or (1 in 8) jumps anywhere
+static uint8_t makeReading(uint8_t* lpp, const uint8_t* channels, const uint8_t* types, uint8_t n,
+                           const uint8_t* prev, bool have_prev) {
+  uint8_t ofs = 0;
+  for (uint8_t f = 0; f < n; f++) {
+    lpp[ofs++] = channels[f];
+    lpp[ofs++] = types[f];
+    uint8_t size = getDataSize(types[f]);
+    for (uint8_t b = 0; b < size; b++) {
+      lpp[ofs + b] = have_prev && nextRandom() % 8 ? prev[ofs + b] : nextRandom() & 0xFF;
+    }
+    if (have_prev && size > 0) lpp[ofs + size - 1] += (int8_t)(nextRandom() % 7) - 3;   // small step
+    ofs += size;
+  }
+  return ofs;
+}
+
+static void printHex(const uint8_t* p, int len) {
+  for (int i = 0; i < len; i++) printf("%02X", p[i]);
+}
+
+static bool checkBatch(uint32_t index, bool print_vectors) {
+  uint8_t body[CHECK_MAX_RECORDS * CHECK_LPP_MAX];
+  int max_len = 20 + nextRandom() % 200;   // small bodies fill up and must reject cleanly
+  uint32_t base_time = 1767225600 + nextRandom() % 1000000;
+
+  CompactTelemetryEncoder enc;
+  enc.begin(body, max_len, base_time);
+
+  CheckRecord records[CHECK_MAX_RECORDS];
+  uint8_t num = 0;
+  uint8_t channels[COMPACT_MAX_FIELDS], types[COMPACT_MAX_FIELDS];
+  uint8_t n = makeLayout(channels, types);
+  uint32_t t = base_time + nextRandom() % 3;
+  for (int i = 0; i < CHECK_MAX_RECORDS; i++) {
+    bool same_layout = num > 0;
+    if (i > 0 && nextRandom() % 10 == 0) {   // layout change mid-batch
+      n = makeLayout(channels, types);
+      same_layout = false;
+    }
+    CheckRecord& r = records[num];
+    r.len = makeReading(r.lpp, channels, types, n, same_layout ? records[num - 1].lpp : NULL, same_layout);
+    r.timestamp = t;
+    t += nextRandom() % 4 == 0 ? nextRandom() % 100000 : 300;   // regular wakes, sometimes a long gap
+
+    int before = enc.getLength();
+    if (!enc.add(r.timestamp, r.lpp, r.len)) {
+      if (enc.getLength() != before) {
+        printf("batch %lu: rejected record %d changed the body\n", (unsigned long)index, i);
+        return false;
+      }
+      break;   // full: like TelemetryBatch, the next record starts a new frame
+    }
+    num++;
+  }
+
+  bool ok = enc.getCount() == num;
+  CompactTelemetryDecoder dec(base_time, body, enc.getLength());
+  ok = ok && dec.getCount() == num;
+  for (uint8_t i = 0; ok && i < num; i++) {
+    uint32_t ts;
+    uint8_t lpp[CHECK_LPP_MAX];
+    uint8_t len;
+    ok = dec.next(ts, lpp, len, sizeof(lpp)) && ts == records[i].timestamp &&
+         len == records[i].len && memcmp(lpp, records[i].lpp, len) == 0;
+  }
+  uint32_t ts;
+  uint8_t lpp[CHECK_LPP_MAX];
+  uint8_t len;
+  ok = ok && !dec.next(ts, lpp, len, sizeof(lpp)) && dec.getPosition() == enc.getLength();
+
+  if (!ok) {
+    printf("batch %lu: round trip mismatch (%d records, %d body bytes)\n  ", (unsigned long)index, num, enc.getLength());
+  }
+  if (!ok || print_vectors) {
+    printf("%lu ", (unsigned long)base_time);
+    printHex(body, enc.getLength());
+    for (uint8_t i = 0; i < num; i++) {
+      printf(" %lu:", (unsigned long)records[i].timestamp);
+      printHex(records[i].lpp, records[i].len);
+    }
+    printf("\n");
+  }
+  return ok;
+}
+
+uint32_t runCodecCheck(uint32_t seed, uint32_t batches, bool print_vectors) {
+  check_rng = seed * 2654435761UL + 1;
+  uint32_t failed = 0;
+  for (uint32_t i = 0; i < batches; i++) {
+    if (!checkBatch(i, print_vectors)) failed++;
+  }
+  return failed;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Round trip of the compact telemetry body: CompactTelemetryEncoder -> CompactTelemetryDecoder
+ *
+ * Random batches (layout changes, signed and multi-component types, full-range and slowly moving
+ * values, bodies that fill up) are encoded by the firmware encoder and must decode back to the
+ * same timestamps and CayenneLPP bytes, using exactly the bytes encoded. CompactTelemetryDecoder
+ * is the C++ statement of the wire format that mqtt_decoder.py must match; with print_vectors each
+ * batch is also printed as "<base_time> <body hex> <ts>:<lpp hex>..." so the Python decoder can
+ * be checked against the same data.
+ *
+ * @return number of failed batches (0 = all passed)
+ */
+uint32_t runCodecCheck(uint32_t seed, uint32_t batches, bool print_vectors);
@@ -0,0 +1,25 @@
+#include <Arduino.h>
+#include "SimClock.h"
+
+uint64_t SimClock::_now = 0;
+uint64_t SimClock::_boot = 0;
+
+HostSerial Serial;
+
+uint32_t millis() {
+  return SimClock::millis();
+}
+
+void delay(uint32_t ms) {
+  SimClock::advance(ms);
+}
+
+size_t Stream::printf(const char* fmt, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  if (n < 0) return 0;
+  return write((const uint8_t*)buf, n < (int)sizeof(buf) ? n : sizeof(buf) - 1);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include "SleepMode.h"   // SLEEP_SYSTEM_*_UA, prefersSystemOnSleep(): the board's own numbers
+
+/**
+ * Timing and current model of the RAK4631 node (what MainBoard, the sensors and InternalFS cost)
+ *
+ * Phase durations are the calibration points of the simulation: take them from "wake profile"
+ * on hardware (avg column) and the benchmark tracks the firmware's own sequencing on top.
+ * Charge during a wake comes from WakeProfiler's model (ENERGY_*_MA), sleep from SleepMode.h.
+ */
+#ifndef SIM_BOOT_MS
+  #define SIM_BOOT_MS            40    // reset to board.begin() done (fast boot, no serial wait)
+#endif
+#ifndef SIM_FS_LOAD_MS
+  #define SIM_FS_LOAD_MS         180   // cold boot: InternalFS mount, identity, prefs, ACL
+#endif
+#ifndef SIM_SNAPSHOT_MS
+  #define SIM_SNAPSHOT_MS        2     // warm boot: restoreBootSnapshot()
+#endif
+#ifndef SIM_SENSORS_BEGIN_MS
+  #define SIM_SENSORS_BEGIN_MS   150   // cold boot: full I2C probe (warm boots trust the presence map)
+#endif
+#ifndef SIM_SENSORS_WARM_MS
+  #define SIM_SENSORS_WARM_MS    10
+#endif
+#ifndef SIM_RADIO_INIT_MS
+  #define SIM_RADIO_INIT_MS      8     // SX1262 power-up to dispatcher in RX
+#endif
+#ifndef SIM_SAMPLE_MS
+  #define SIM_SAMPLE_MS          1     // one SampleScheduler read (SAADC burst, cached sensor)
+#endif
+#ifndef SIM_FS_MOUNT_MS
+  #define SIM_FS_MOUNT_MS        15    // ensureFS() on a warm wake, first flash access
+#endif
+#ifndef SIM_FLASH_COMMIT_MS
+  #define SIM_FLASH_COMMIT_MS    5     // LittleFS append: data program + metadata commit
+#endif
+#ifndef SIM_FLASH_ERASE_MS
+  #define SIM_FLASH_ERASE_MS     85    // nRF52840 page erase (log segment recycled)
+#endif
+#ifndef SIM_SLEEP_ENTRY_MS
+  #define SIM_SLEEP_ENTRY_MS     2
+#endif
+
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Simulated time of the node being stepped
+ *
+ * Nodes are simulated one after another, each on its own timeline from t = 0, and never read
+ * each other's clocks; only their transmissions meet, on the shared SimChannel. Time is true
+ * (reference) time in ms; the node's own RTC runs off it with drift (SimRTC). millis() counts
+ * from the last simulated reset, as on the nRF52, and keeps counting through System ON sleep.
+ */
+class SimClock {
+public:
+  static uint64_t now() { return _now; }
+  static void advance(uint32_t ms) { _now += ms; }
+  static void advanceTo(uint64_t t) { if (t > _now) _now = t; }
+  static void reset() { _boot = _now; }   // System OFF wake: millis() restarts at 0
+  static void start() { _now = _boot = 0; }   // next node
+  static uint32_t millis() { return (uint32_t)(_now - _boot); }
+
+private:
+  static uint64_t _now;
+  static uint64_t _boot;
+};
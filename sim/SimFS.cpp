@@ -0,0 +1,56 @@
+#include "SimFS.h"
+
+int File::read(uint8_t* buf, size_t len) {
+  if (_data == NULL) return -1;
+  size_t n = _pos < _data->size() ? std::min(len, _data->size() - _pos) : 0;
+  memcpy(buf, _data->data() + _pos, n);
+  _pos += n;
+  return n;
+}
+
+size_t File::write(const uint8_t* buf, size_t len) {
+  if (_data == NULL) return 0;
+  if (_pos + len > _data->size()) _data->resize(_pos + len);
+  memcpy(_data->data() + _pos, buf, len);
+  _pos += len;
+  _dirty = true;
+  _stats->bytes_written += len;
+  return len;
+}
+
+bool File::seek(uint32_t pos) {
+  if (_data == NULL || pos > _data->size()) return false;
+  _pos = pos;
+  return true;
+}
+
+void File::close() {
+  if (_dirty) _stats->commits++;
+  _dirty = false;
+  _data = NULL;
+}
+
+File SimFS::open(const char* name, const char* mode, bool create) {
+  (void)create;   // ESP32 signature: "w" and "a" always create here
+  auto it = _files.find(name);
+  if (mode[0] == 'r') {
+    return it == _files.end() ? File() : File(&it->second, false, &_stats);
+  }
+  std::vector<uint8_t>& data = _files[name];
+  if (mode[0] == 'w') data.clear();
+  return File(&data, mode[0] == 'a', &_stats);
+}
+
+bool SimFS::remove(const char* name) {
+  auto it = _files.find(name);
+  if (it == _files.end()) return false;
+  _files.erase(it);
+  _stats.erases++;
+  return true;
+}
+
+uint32_t SimFS::getUsedBytes() const {
+  uint32_t n = 0;
+  for (auto& f : _files) n += f.second.size();
+  return n;
+}
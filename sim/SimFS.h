@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * In-memory filesystem standing in for InternalFS (FILESYSTEM in the firmware modules)
+ *
+ * Files live in a map for the lifetime of the node, so they survive simulated resets the way
+ * flash does. Every byte written and every file committed (closed after a write, which is a
+ * LittleFS metadata commit) is counted; removes count as block erases. SimNode turns the
+ * counts into flash time and the benchmark reports them per wake cycle.
+ */
+struct SimFlashStats {
+  uint32_t bytes_written;
+  uint32_t commits;
+  uint32_t erases;
+};
+
+class File {
+public:
+  File() : _data(NULL), _pos(0), _dirty(false), _stats(NULL) { }
+  File(std::vector<uint8_t>* data, bool append, SimFlashStats* stats)
+    : _data(data), _pos(append ? data->size() : 0), _dirty(false), _stats(stats) { }
+
+  operator bool() const { return _data != NULL; }
+
+  int read(uint8_t* buf, size_t len);
+  size_t write(const uint8_t* buf, size_t len);
+  bool seek(uint32_t pos);
+  uint32_t position() const { return _pos; }
+  uint32_t size() const { return _data ? _data->size() : 0; }
+  int available() const { return _data ? (int)(_data->size() - _pos) : 0; }
+  void close();
+
+private:
+  std::vector<uint8_t>* _data;
+  uint32_t _pos;
+  bool _dirty;
+  SimFlashStats* _stats;
+};
+
+class SimFS {
+public:
+  SimFS() { memset(&_stats, 0, sizeof(_stats)); }
+
+  // mode "r" reads from the start, "w" truncates, "a" appends; create is implied for "w"/"a"
+  File open(const char* name, const char* mode = "r", bool create = false);
+  bool exists(const char* name) const { return _files.count(name) > 0; }
+  bool remove(const char* name);
+  void format() { _files.clear(); }
+
+  const SimFlashStats& getStats() const { return _stats; }
+  uint32_t getUsedBytes() const;
+
+private:
+  std::map<std::string, std::vector<uint8_t> > _files;
+  SimFlashStats _stats;
+};
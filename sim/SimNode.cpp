@@ -0,0 +1,393 @@
+#include "SimNode.h"
+#include "SimBoard.h"
+#include "SimClock.h"
+#include "CompactTelemetry.h"
+#include "WakeCycle.h"
+#include "WakeSchedule.h"
+
+#define TELEM_CHANNEL_BATTERY     10    // as in main.cpp
+#define TELEM_CHANNEL_TEMPERATURE 11    // the application sensors of the modelled node
+#define TELEM_CHANNEL_HUMIDITY    12
+
+#define SIM_EPOCH            1767225600   // RTC time at power-up (2026-01-01), set by a time sync
+
+SimNode::SimNode(const SimConfig& cfg, uint16_t id, uint32_t seed, SimChannel& channel)
+  : _cfg(cfg), _id(id), _rng(seed * 2654435761UL + id * 40503UL + 1), _radio(channel, id), _reading(TELEM_READING_MAX) {
+  // the pub_key hash behind getWakePhase(), and this node's RTC crystal
+  _key_hash = random();
+  _drift_ppm = ((int32_t)(random() % 2001) - 1000) * _cfg.drift_ppm / 1000.0f;
+
+  _radio.configure(_cfg.bw_khz, _cfg.sf, _cfg.cr);
+  _sampler.addChannel(TELEM_CHANNEL_BATTERY, LPP_VOLTAGE, readBattery, this);
+  _battery_v = 4.10f;
+  _temperature = 18.0f + (random() % 100) / 10.0f;
+}
+
+uint32_t SimNode::random() {
+  // xorshift32: fast, and the same sequence on every host
+  _rng ^= _rng << 13;
+  _rng ^= _rng >> 17;
+  _rng ^= _rng << 5;
+  return _rng;
+}
+
+float SimNode::readBattery(void* ctx) {
+  SimNode* self = (SimNode*) ctx;
+  self->_battery_v -= 0.00001f;
+  return self->_battery_v + ((int32_t)(self->random() % 21) - 10) / 1000.0f;   // +/- 10 mV of noise
+}
+
+void SimNode::run(uint32_t cycles, SimCycleFn on_cycle, void* ctx) {
+  _on_cycle = on_cycle;
+  _on_cycle_ctx = ctx;
+  _cycles_left = cycles;
+  _cycles_done = 0;
+
+  SimClock::start();
+  _rtc.begin(SIM_EPOCH, _drift_ppm);
+  _wakeup_count = 0;
+  _have_period = false;
+  _tx_since_listen = _cfg.listen_every ? _cfg.listen_every - 1 : 0;   // first TX after power-up listens
+  boot(true);
+  while (_cycles_left > 0) {
+    step();
+  }
+}
+
+void SimNode::work(WakePhase phase, uint32_t ms) {
+  SimClock::advance(ms);
+  _profiler.add(phase, ms);
+}
+
+void SimNode::beginCycle() {
+  _state = SAMPLING;
+  _state_start = _awake_start = millis();
+  _sampler.reset();
+  _listen_pending = false;
+  _tx_jitter_ms = -1;
+  _flash_base = _fs.getStats();
+  _flash_charged = _flash_base;
+  _packets_base = _radio.getPacketsSent();
+  _bytes_base = _radio.getBytesSent();
+  _airtime_base = _radio.getTotalAirTime();
+}
+
+// setup(): a reset from power-up (cold) or from System OFF on the RTC alarm (warm)
+void SimNode::boot(bool cold) {
+  SimClock::reset();
+  _radio.reset();
+  _radio_powered = false;
+
+  _profiler.begin();
+  work(WAKE_PHASE_BOOT, SIM_BOOT_MS);
+  _warm = _rtc.checkWakeup() && !cold;
+  _wakeup_count++;
+
+  // warm: restoreBootSnapshot(), InternalFS stays unmounted until something is written
+  work(WAKE_PHASE_FS_LOAD, _warm ? SIM_SNAPSHOT_MS : SIM_FS_LOAD_MS);
+  _fs_mounted = !_warm;
+  if (!(_warm && _cfg.lazy_radio)) bringUpRadio();
+
+  _batch.begin(getTelemBatchCapacity(_cfg.telemetry_format));
+  _log.begin(&_fs);
+  work(WAKE_PHASE_SENSORS_BEGIN, _warm ? SIM_SENSORS_WARM_MS : SIM_SENSORS_BEGIN_MS);
+  beginCycle();
+}
+
+void SimNode::beginSystemOnWake() {
+  _wakeup_count++;
+  _profiler.beginWake();
+  beginCycle();
+  if (!_cfg.lazy_radio) bringUpRadio();
+}
+
+void SimNode::bringUpRadio() {
+  if (_radio_powered) return;
+  _radio_powered = true;
+  _radio_on_ms = millis();
+  work(WAKE_PHASE_RADIO_INIT, SIM_RADIO_INIT_MS);
+}
+
+void SimNode::ensureFS() {
+  if (_fs_mounted) return;
+  SimClock::advance(SIM_FS_MOUNT_MS);
+  _fs_mounted = true;
+}
+
+// Flash program/erase time of what the filesystem did since the last call
+void SimNode::chargeFlash() {
+  const SimFlashStats& st = _fs.getStats();
+  SimClock::advance((st.commits - _flash_charged.commits) * SIM_FLASH_COMMIT_MS + (st.erases - _flash_charged.erases) * SIM_FLASH_ERASE_MS);
+  _flash_charged = st;
+}
+
+// One pass of main.cpp's loop(), with its transitions from WakeCycle.h
+void SimNode::step() {
+  uint32_t now = millis();
+  if (isAwakeTooLong(now, _awake_start)) {
+    _state = READY_TO_SLEEP;
+  }
+
+  switch (_state) {
+    case SAMPLING: {
+      if (!_sampler.isRunning()) {
+        _sampler.configure(_cfg.samples_per_wake, _cfg.sample_spacing_ms, NULL, 0);
+        _sampler.start(now);
+      }
+      int n = _sampler.poll(now);
+      if (n > 0) work(WAKE_PHASE_SAMPLE, n * SIM_SAMPLE_MS);
+      if (_sampler.isDone()) {
+        _state = PROCESSING;
+        _state_start = millis();
+      }
+      break;
+    }
+
+    case PROCESSING: {
+      bool telemetry_sent = broadcastTelemetry();
+      bool advert_due = isAdvertDue(_wakeup_count, _cfg.wakeups_per_advert);
+      _state = stateAfterProcessing(advert_due, telemetry_sent);
+      if (advert_due) _wakeup_count = 0;
+      _state_start = millis();
+      break;
+    }
+
+    case ADVERTISING:
+      bringUpRadio();
+      sendSelfAdvertisement(ADVERT_TX_DELAY_MS);
+      _state = WAITING_FOR_TX;
+      _state_start = millis();
+      break;
+
+    case WAITING_FOR_TX:
+      if (!_radio.hasPendingWork()) {
+        _profiler.add(WAKE_PHASE_TX_QUEUE, now - _state_start);
+        _state = stateAfterTx(_listen_pending);   // takeListenWindow()
+        _listen_pending = false;
+        _state_start = now;
+      } else if (isTxDrainTimedOut(now, _state_start)) {
+        _profiler.add(WAKE_PHASE_TX_QUEUE, now - _state_start);
+        _state = READY_TO_SLEEP;
+        _state_start = now;
+      }
+      break;
+
+    case LISTENING:
+      // no gateway in the simulation: the window always runs out
+      if (isListenWindowOver(now, _state_start, _cfg.listen_window_ms)) {
+        _state = READY_TO_SLEEP;
+        _state_start = now;
+      }
+      break;
+
+    case INTERACTIVE_MODE:
+      // only entered on a downlink, and the simulation has none
+      break;
+
+    case READY_TO_SLEEP:
+      sleep();
+      return;
+  }
+
+  _radio.loop();
+  idle();
+}
+
+// Where main.cpp idles the core the clock jumps to the next event instead
+void SimNode::idle() {
+  uint32_t now = millis();
+  uint32_t target;
+  if (_state == SAMPLING && _sampler.isRunning() && !_sampler.isDone()) {
+    target = _sampler.getNextDue();
+  } else if (_state == WAITING_FOR_TX && _radio.hasPendingWork()) {
+    target = _radio.getNextEventMillis();
+    if ((int32_t)(target - (_state_start + TX_DRAIN_TIMEOUT_MS)) > 0) target = _state_start + TX_DRAIN_TIMEOUT_MS;
+  } else if (_state == LISTENING) {
+    target = _state_start + _cfg.listen_window_ms;
+  } else {
+    return;
+  }
+  if ((int32_t)(target - (_awake_start + MAX_AWAKE_TIME_MS)) > 0) target = _awake_start + MAX_AWAKE_TIME_MS;
+  if ((int32_t)(target - now) > 0) SimClock::advance(target - now);
+}
+
+// READY_TO_SLEEP: close the wake's accounting, sleep to the next slot and wake up from it
+void SimNode::sleep() {
+  work(WAKE_PHASE_SLEEP_ENTRY, SIM_SLEEP_ENTRY_MS);
+  uint32_t air_ms = _radio.getTotalAirTime() - _airtime_base;
+  _profiler.add(WAKE_PHASE_TX_AIRTIME, air_ms);
+  _profiler.endWake(_radio_powered ? millis() - _radio_on_ms : 0);
+
+  uint32_t interval = _cfg.sleep_interval_secs;
+  uint32_t rtc_now = _rtc.getCurrentTime();
+  uint32_t woke_at = wakeStartTime(rtc_now, millis() - _awake_start);
+  uint32_t wake_time = nextWakeSlot(rtc_now, woke_at, interval, _key_hash, _cfg.slot_width_secs, _cfg.tx_slotting, false);
+  bool system_on = prefersSystemOnSleep(interval, _profiler.getRebootMicroAh());
+  _rtc.setAlarmAt(wake_time, rtc_now);
+  uint64_t wake_at = _rtc.getAlarmTrueTime();
+  uint64_t sleep_ms = wake_at > SimClock::now() ? wake_at - SimClock::now() : 0;
+
+  const SimFlashStats& flash = _fs.getStats();
+  SimCycleStats c;
+  c.awake_ms = _profiler.getLastAwakeMillis();
+  c.system_on = system_on;
+  c.packets = _radio.getPacketsSent() - _packets_base;
+  c.bytes = _radio.getBytesSent() - _bytes_base;
+  c.air_ms = air_ms;
+  c.flash_bytes = flash.bytes_written - _flash_base.bytes_written;
+  c.flash_commits = flash.commits - _flash_base.commits;
+  c.flash_erases = flash.erases - _flash_base.erases;
+  c.wake_uah = _profiler.getLastWakeMicroAh();
+  c.sleep_uah = (system_on ? SLEEP_SYSTEM_ON_UA : SLEEP_SYSTEM_OFF_UA) * sleep_ms / 3600000.0f;
+  c.sleep_ms = sleep_ms;
+
+  // every period gets exactly one wake
+  uint32_t period = wake_time / interval;
+  c.periods_skipped = _have_period && period > _last_period + 1 ? period - _last_period - 1 : 0;
+  c.period_repeated = _have_period && period <= _last_period;
+  _last_period = period;
+  _have_period = true;
+  if (_on_cycle) _on_cycle(_on_cycle_ctx, _id, _cycles_done, c);
+  _cycles_done++;
+  _cycles_left--;
+
+  _radio_powered = false;
+  SimClock::advanceTo(wake_at);
+  _rtc.fire();
+  if (system_on) {
+    _rtc.checkWakeup();
+    beginSystemOnWake();
+  } else {
+    boot(false);
+  }
+}
+
+/* ------------------------------ SensorMesh telemetry path -------------------------------- */
+
+uint8_t SimNode::collectReading(uint32_t timestamp) {
+  _reading.reset();
+  _sampler.addTelemetry(_reading);   // addSampledTelemetry()
+
+  // addSensorTelemetry(): an environment sensor drifting slowly between wakes
+  _temperature += ((int32_t)(random() % 21) - 10) / 100.0f;
+  _reading.addTemperature(TELEM_CHANNEL_TEMPERATURE, _temperature);
+  _reading.addRelativeHumidity(TELEM_CHANNEL_HUMIDITY, 55.0f + ((int32_t)(random() % 11) - 5) / 10.0f);
+
+  uint8_t len = _reading.getSize();
+  if (len == 0) return 0;
+
+  if (_cfg.telemetry_log) {   // SensorMesh::logTelemetry()
+    if (!_log.fits(len)) {
+      ensureFS();
+      _log.flush();
+      chargeFlash();
+    }
+    _log.append(timestamp, _reading.getBuffer(), len);
+  }
+  return len;
+}
+
+bool SimNode::broadcastTelemetry() {
+  uint32_t timestamp = _rtc.getCurrentTime();
+  uint8_t len = collectReading(timestamp);
+  if (len == 0) return false;
+  const uint8_t* lpp = _reading.getBuffer();
+
+  if (_cfg.batch_wakes <= 1) {
+    if (!_batch.isEmpty()) flushTelemetryBatch();
+    return sendTelemetryReading(timestamp, lpp, len);
+  }
+
+  _batch.setCapacity(getTelemBatchCapacity(_cfg.telemetry_format));
+  bool sent = false;
+  if (!_batch.append(timestamp, lpp, len)) {
+    sent = flushTelemetryBatch();
+    if (!_batch.append(timestamp, lpp, len)) {
+      return sendTelemetryReading(timestamp, lpp, len) || sent;
+    }
+  }
+  if (isTelemBatchDue(_batch.getWakes(), _cfg.batch_wakes, _batch.fits(len))) {
+    sent |= flushTelemetryBatch();
+  }
+  return sent;
+}
+
+bool SimNode::flushTelemetryBatch() {
+  if (_batch.isEmpty()) return false;
+
+  bool sent;
+  if (_cfg.telemetry_format == TELEM_SCHEMA_COMPACT) {
+    CompactTelemetryEncoder enc;
+    sent = sendTelemetryBatch(enc);
+  } else {
+    LppBatchEncoder enc;
+    sent = sendTelemetryBatch(enc);
+  }
+  _batch.clear();
+  return sent;
+}
+
+bool SimNode::sendTelemetryBatch(TelemetryEncoder& enc) {
+  uint8_t body[TELEM_BODY_MAX];
+  enc.begin(body, sizeof(body), _batch.getBaseTime());
+
+  bool sent = false;
+  uint32_t ts;
+  const uint8_t* lpp;
+  uint8_t len;
+  for (int pos = 0; (pos = _batch.next(pos, ts, lpp, len)) >= 0; ) {
+    if (enc.add(ts, lpp, len)) continue;
+    if (enc.getCount() > 0) {
+      sent |= sendTelemetryFrame(enc);
+      enc.begin(body, sizeof(body), ts);
+      if (enc.add(ts, lpp, len)) continue;
+    }
+    sent |= sendTelemetryReading(ts, lpp, len);
+  }
+  if (enc.getCount() > 0) {
+    sent |= sendTelemetryFrame(enc);
+  }
+  return sent;
+}
+
+bool SimNode::sendTelemetryReading(uint32_t timestamp, const uint8_t* lpp, uint8_t len) {
+  uint8_t body[TELEM_BODY_MAX];
+  LppTelemetryEncoder enc;
+  enc.begin(body, sizeof(body), timestamp);
+  if (!enc.add(timestamp, lpp, len)) return false;
+  return sendTelemetryFrame(enc);
+}
+
+// Header + encrypted body (padded to the cipher block) in a flood packet on the group channel
+bool SimNode::sendTelemetryFrame(const TelemetryEncoder& enc) {
+  bringUpRadio();   // prepareRadio(): lazy radio powers up on the first packet
+  if (!_listen_pending && claimListenWindow()) {
+    _listen_pending = true;
+  }
+
+  int plain = TELEM_FRAME_HDR + enc.getLength();
+  int cipher = (plain + CIPHER_BLOCK_SIZE - 1) / CIPHER_BLOCK_SIZE * CIPHER_BLOCK_SIZE;
+  int len = SIM_PKT_OVERHEAD + (_cfg.zone ? SIM_TRANSPORT_CODES : 0) + SIM_GRP_DATA_HDR + cipher;
+  _radio.queue(len, getTelemetryJitter());
+  return true;
+}
+
+// SensorMesh::getTelemetryJitter(): one delay within the slot for the whole wake
+uint32_t SimNode::getTelemetryJitter() {
+  if (!_cfg.tx_slotting) return 0;
+  if (_tx_jitter_ms < 0) {
+    _tx_jitter_ms = random() % telemJitterRangeMs(_cfg.slot_width_secs);
+  }
+  return _tx_jitter_ms;
+}
+
+void SimNode::sendSelfAdvertisement(uint32_t delay_ms) {
+  _radio.queue(SIM_PKT_OVERHEAD + SIM_ADVERT_LEN, delay_ms);
+}
+
+bool SimNode::claimListenWindow() {
+  if (_cfg.listen_every == 0) return false;
+  bool listen = ++_tx_since_listen >= _cfg.listen_every;
+  if (listen) _tx_since_listen = 0;
+  return listen;
+}
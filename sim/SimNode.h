@@ -0,0 +1,147 @@
+#pragma once
+
+#include <Arduino.h>
+#include <CayenneLPP.h>
+#include "SampleScheduler.h"
+#include "TelemetryBatch.h"
+#include "TelemetryEncoder.h"
+#include "TelemetryLog.h"
+#include "WakeCycle.h"
+#include "WakeProfiler.h"
+#include "SimFS.h"
+#include "SimRadio.h"
+#include "SimRTC.h"
+
+/**
+ * Node configuration: the SensorExtendedPrefs fields the wake cycle depends on, plus radio
+ * and model parameters. Defaults are the firmware defaults (SensorMesh constructor).
+ */
+struct SimConfig {
+  uint32_t sleep_interval_secs = 300;
+  uint8_t wakeups_per_advert = 12;
+  uint8_t batch_wakes = 1;
+  uint8_t telemetry_format = 0;     // TELEM_SCHEMA_LPP / TELEM_SCHEMA_COMPACT
+  uint8_t telemetry_log = 1;
+  uint8_t lazy_radio = 0;
+  uint8_t tx_slotting = 1;
+  uint16_t slot_width_secs = 0;
+  uint8_t listen_every = 0;
+  uint16_t listen_window_ms = 500;
+  uint8_t samples_per_wake = 5;
+  uint16_t sample_spacing_ms = 1000;
+  bool zone = false;                // broadcast zone set: transport codes on every flood
+
+  float bw_khz = 62.5f;             // RAK_4631_sleeping_sensor env radio settings
+  uint8_t sf = 8;
+  uint8_t cr = 5;
+  float drift_ppm = 20.0f;          // RTC drift, each node gets a value in +/- this range
+};
+
+// What one wake cycle cost, wake to the next wake
+struct SimCycleStats {
+  uint32_t awake_ms;
+  uint8_t system_on;                // slept in System ON after this wake
+  uint32_t packets;
+  uint32_t bytes;                   // on air
+  uint32_t air_ms;
+  uint32_t flash_bytes;
+  uint32_t flash_commits;
+  uint32_t flash_erases;
+  float wake_uah;                   // WakeProfiler's estimate of the wake
+  uint64_t sleep_ms;                // the sleep that followed
+  float sleep_uah;
+  uint32_t periods_skipped;         // periods between the previous scheduled wake and this one with no wake
+  uint8_t period_repeated;          // this wake falls in the same period as the previous one
+};
+
+typedef void (*SimCycleFn)(void* ctx, uint16_t node, uint32_t cycle, const SimCycleStats& stats);
+
+/**
+ * One node running the loop() sleep/wake state machine of main.cpp against the mocks
+ *
+ * The transitions (SAMPLING, PROCESSING, ADVERTISING, WAITING_FOR_TX, LISTENING, READY_TO_SLEEP)
+ * and batching limits come from WakeCycle.h, the wake slots from WakeSchedule.h and the sleep
+ * mode choice from SleepMode.h, the same code main.cpp runs; the telemetry path follows
+ * SensorMesh::broadcastTelemetry(), without send-on-delta. The firmware modules themselves
+ * run unchanged: SampleScheduler, TelemetryBatch and the encoders build the packets,
+ * TelemetryLog writes the flash log and WakeProfiler keeps the phase histograms.
+ * Instead of spinning, each pass of the state machine advances the clock to the next event.
+ */
+class SimNode {
+public:
+  SimNode(const SimConfig& cfg, uint16_t id, uint32_t seed, SimChannel& channel);
+
+  void run(uint32_t cycles, SimCycleFn on_cycle, void* ctx);   // from power-up
+
+  const WakeProfiler& getProfiler() const { return _profiler; }
+  uint32_t getWakeKey() const { return _key_hash; }
+  float getDriftPpm() const { return _drift_ppm; }
+
+private:
+  void boot(bool cold);         // setup(): reset from power-up (cold) or an RTC alarm
+  void beginSystemOnWake();
+  void beginCycle();            // per-wake state and the baselines of this cycle's stats
+  void step();                  // one pass of loop()
+  void idle();                  // advance to the next event of the current state
+  void sleep();                 // READY_TO_SLEEP: schedule the next wake, account the cycle
+
+  void bringUpRadio();
+  void work(WakePhase phase, uint32_t ms);   // time spent busy in a phase
+  void ensureFS();
+  void chargeFlash();
+
+  // SensorMesh telemetry path
+  uint8_t collectReading(uint32_t timestamp);
+  bool broadcastTelemetry();
+  bool flushTelemetryBatch();
+  bool sendTelemetryBatch(TelemetryEncoder& enc);
+  bool sendTelemetryReading(uint32_t timestamp, const uint8_t* lpp, uint8_t len);
+  bool sendTelemetryFrame(const TelemetryEncoder& enc);
+  void sendSelfAdvertisement(uint32_t delay_ms);
+  bool claimListenWindow();
+  uint32_t getTelemetryJitter();
+
+  uint32_t random();
+  static float readBattery(void* ctx);
+
+  SimConfig _cfg;
+  uint16_t _id;
+  uint32_t _rng;
+  uint32_t _key_hash;           // pub_key hash behind the wake slots
+  float _drift_ppm;
+
+  SimFS _fs;
+  SimRadio _radio;
+  SimRTC _rtc;
+  SampleScheduler _sampler;
+  TelemetryBatch _batch;
+  TelemetryLog _log;
+  WakeProfiler _profiler;
+  CayenneLPP _reading;
+
+  SensorNodeState _state;
+  uint32_t _state_start;
+  uint32_t _awake_start;
+  uint8_t _wakeup_count;        // GPREGRET2
+  bool _warm;
+  bool _fs_mounted;
+  bool _radio_powered;
+  uint32_t _radio_on_ms;        // millis() the radio was powered
+  bool _listen_pending;
+  int32_t _tx_jitter_ms;
+  uint8_t _tx_since_listen;
+  float _battery_v;
+  float _temperature;
+
+  SimCycleFn _on_cycle;
+  void* _on_cycle_ctx;
+  uint32_t _cycles_left;
+  uint32_t _cycles_done;
+  SimFlashStats _flash_base;    // at the start of the cycle
+  SimFlashStats _flash_charged; // last chargeFlash()
+  uint32_t _packets_base;
+  uint32_t _bytes_base;
+  uint32_t _airtime_base;
+  uint32_t _last_period;        // period of the last scheduled wake
+  bool _have_period;            // not until the first one: the power-up wake is not in a slot
+};
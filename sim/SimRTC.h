@@ -0,0 +1,45 @@
+#pragma once
+
+#include "RTCWakeup.h"
+#include "SimClock.h"
+
+/**
+ * Simulated external RTC with an alarm, running off true time with a fixed drift
+ *
+ * getCurrentTime() is the node's wall clock (what nextWakeSlot() schedules against);
+ * getAlarmTrueTime() is when the alarm really goes off, which is where drift between nodes
+ * sharing an interval shows up as their slots sliding into each other.
+ */
+class SimRTC : public RTCWakeup {
+public:
+  SimRTC() : _epoch(0), _drift_ppm(0), _alarm(0), _fired(false) { }
+
+  void begin(uint32_t epoch, float drift_ppm) { _epoch = epoch; _drift_ppm = drift_ppm; _alarm = 0; _fired = false; }
+
+  uint32_t getCurrentTime() const { return _epoch + (uint32_t)(SimClock::now() * (1.0 + _drift_ppm * 1e-6) / 1000); }
+
+  bool checkWakeup() override {
+    bool fired = _fired;
+    _fired = false;
+    return fired;
+  }
+  bool setAlarm(uint32_t seconds) override { return setAlarmAt(getCurrentTime() + seconds, getCurrentTime()); }
+  bool setAlarmAt(uint32_t wake_time, uint32_t now) override {
+    if (wake_time <= now) return false;
+    _alarm = wake_time;
+    return true;
+  }
+
+  // true time (ms) of the armed alarm, 0 = none
+  uint64_t getAlarmTrueTime() const {
+    if (_alarm == 0) return 0;
+    return (uint64_t)((_alarm - _epoch) * 1000.0 / (1.0 + _drift_ppm * 1e-6));
+  }
+  void fire() { _alarm = 0; _fired = true; }
+
+private:
+  uint32_t _epoch;
+  float _drift_ppm;
+  uint32_t _alarm;
+  bool _fired;
+};
@@ -0,0 +1,82 @@
+#include "SimRadio.h"
+#include <Arduino.h>
+#include "SimClock.h"
+#include <math.h>
+#include <algorithm>
+
+uint32_t SimChannel::countCollisions() const {
+  std::vector<SimTx> txs(_log);
+  std::sort(txs.begin(), txs.end(), [](const SimTx& a, const SimTx& b) { return a.start < b.start; });
+
+  std::vector<bool> hit(txs.size(), false);
+  for (size_t i = 0; i < txs.size(); i++) {
+    // sorted by start: only later TX starting before this one ends can overlap it
+    for (size_t j = i + 1; j < txs.size() && txs[j].start < txs[i].end; j++) {
+      if (txs[j].node == txs[i].node) continue;
+      hit[i] = hit[j] = true;
+    }
+  }
+  return std::count(hit.begin(), hit.end(), true);
+}
+
+uint32_t SimRadio::getEstAirtimeFor(int len_bytes) const {
+  float t_sym = (1 << _sf) / _bw_khz;   // ms
+  int de = t_sym >= 16.0f ? 1 : 0;
+  float num = 8.0f * len_bytes - 4.0f * _sf + 28 + 16;   // CRC on, explicit header
+  float payload_syms = 8 + std::max(ceilf(num / (4.0f * (_sf - 2 * de))) * _cr, 0.0f);
+  return (uint32_t) ceilf((SIM_LORA_PREAMBLE + 4.25f + payload_syms) * t_sym);
+}
+
+void SimRadio::reset() {
+  _num_queued = 0;
+  _tx_end = 0;
+}
+
+void SimRadio::queue(int len, uint32_t delay_ms) {
+  if (_num_queued >= (int)(sizeof(_queue) / sizeof(_queue[0]))) return;   // pool exhausted, dropped
+  _queue[_num_queued].len = len;
+  _queue[_num_queued].due = millis() + delay_ms;
+  _num_queued++;
+}
+
+bool SimRadio::isTxDue() const {
+  if (_tx_end != 0) return true;
+  for (int i = 0; i < _num_queued; i++) {
+    if ((int32_t)(millis() - _queue[i].due) >= 0) return true;
+  }
+  return false;
+}
+
+uint32_t SimRadio::getNextEventMillis() const {
+  if (_tx_end != 0) return _tx_end;
+  uint32_t next = millis();
+  for (int i = 0; i < _num_queued; i++) {
+    if (i == 0 || (int32_t)(_queue[i].due - next) < 0) next = _queue[i].due;
+  }
+  return next;
+}
+
+void SimRadio::loop() {
+  uint32_t now = millis();
+  if (_tx_end != 0) {
+    if ((int32_t)(now - _tx_end) < 0) return;
+    _tx_end = 0;
+  }
+
+  // one TX at a time, the earliest due first
+  int next = -1;
+  for (int i = 0; i < _num_queued; i++) {
+    if ((int32_t)(now - _queue[i].due) < 0) continue;
+    if (next < 0 || (int32_t)(_queue[i].due - _queue[next].due) < 0) next = i;
+  }
+  if (next < 0) return;
+
+  int len = _queue[next].len;
+  _queue[next] = _queue[--_num_queued];
+  uint32_t air_ms = getEstAirtimeFor(len);
+  _channel.add(_node, SimClock::now(), air_ms);
+  _tx_end = now + air_ms;
+  _total_air_ms += air_ms;
+  _packets++;
+  _bytes += len;
+}
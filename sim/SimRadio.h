@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Simulated SX1262 and MeshCore's outbound queue (the parts of mesh::Radio and Dispatcher the
+ * wake cycle depends on)
+ *
+ * Packets are queued with a delay and sent one at a time; each TX takes the LoRa time on air
+ * for its length (Semtech AN1200.13, explicit header, CRC on, low data rate optimisation when
+ * a symbol is 16 ms or longer) and is logged on the SimChannel with the true time it occupied.
+ * Nothing is received: the channel log is only used afterwards to count overlapping TX.
+ */
+#define SIM_LORA_PREAMBLE    16    // MeshCore's preamble length (symbols)
+
+// On-air sizes of the MeshCore packets the node sends (header 1 + path length 1, flood, no path yet)
+#define SIM_PKT_OVERHEAD     2
+#define SIM_TRANSPORT_CODES  4     // zone flood: two 16-bit transport codes
+#define SIM_GRP_DATA_HDR     3     // channel hash (PATH_HASH_SIZE) + MAC (CIPHER_MAC_SIZE)
+#define SIM_ADVERT_LEN       (32 + 4 + 64 + 1 + 8 + 20)   // pub key, timestamp, signature, flags, lat/lon, name
+
+struct SimTx {
+  uint16_t node;
+  uint64_t start;   // true time, ms
+  uint64_t end;
+};
+
+class SimChannel {
+public:
+  void add(uint16_t node, uint64_t start, uint32_t air_ms) { _log.push_back({ node, start, start + air_ms }); }
+  void clear() { _log.clear(); }
+
+  /**
+   * Count transmissions overlapping another node's TX (both are lost to a receiver in range of
+   * both, no capture effect)
+   */
+  uint32_t countCollisions() const;
+  uint32_t getNumTx() const { return _log.size(); }
+
+private:
+  std::vector<SimTx> _log;
+};
+
+class SimRadio {
+public:
+  SimRadio(SimChannel& channel, uint16_t node)
+    : _channel(channel), _node(node), _bw_khz(250), _sf(11), _cr(5), _total_air_ms(0), _packets(0), _bytes(0) { reset(); }
+
+  void configure(float bw_khz, uint8_t sf, uint8_t cr) { _bw_khz = bw_khz; _sf = sf; _cr = cr; }   // cr: 5-8 (4/5-4/8)
+  uint32_t getEstAirtimeFor(int len_bytes) const;
+
+  void reset();   // power-up: queue empty (the totals below are kept for the whole run)
+
+  /**
+   * Queue an outbound packet of len on-air bytes, sent delay_ms from now
+   */
+  void queue(int len, uint32_t delay_ms);
+  void loop();                          // start the next due TX, finish the current one
+  bool hasPendingWork() const { return _num_queued > 0 || _tx_end != 0; }
+  bool isTxDue() const;
+  int getPendingTxCount() const { return _num_queued; }
+  uint32_t getTotalAirTime() const { return _total_air_ms; }
+  uint32_t getNextEventMillis() const;  // millis() when loop() has something to do (TX due or done)
+
+  uint32_t getPacketsSent() const { return _packets; }
+  uint32_t getBytesSent() const { return _bytes; }
+
+private:
+  struct Queued {
+    int len;
+    uint32_t due;   // millis()
+  };
+
+  SimChannel& _channel;
+  uint16_t _node;
+  float _bw_khz;
+  uint8_t _sf;
+  uint8_t _cr;
+  Queued _queue[8];
+  int _num_queued;
+  uint32_t _tx_end;   // millis() the TX in progress completes, 0 = idle
+  uint32_t _total_air_ms;
+  uint32_t _packets;
+  uint32_t _bytes;
+};
@@ -0,0 +1,60 @@
+#include <RetainedRAM.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "SimRetainedRAM.h"
+
+/**
+ * RetainedRAM for the host: same CRC, retention bits replaced by a list of registered regions
+ *
+ * Host statics survive a simulated reset anyway, which is what System OFF retention gives the
+ * node. simPowerLoss() is the other case: it zeroes every registered region, so each
+ * RetainedBlock fails its magic check and starts over like after a power cycle.
+ */
+struct RetainedRegion {
+  void* start;
+  size_t len;
+};
+
+static RetainedRegion regions[RETAINED_RAM_MAX_REGIONS];
+static uint8_t num_regions = 0;
+
+uint32_t RetainedRAM::crc32(const void* data, size_t len, uint32_t crc) {
+  const uint8_t* p = (const uint8_t*) data;
+  crc = ~crc;
+  while (len--) {
+    crc ^= *p++;
+    for (int k = 0; k < 8; k++) {
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+void RetainedRAM::retain(const void* addr, size_t len) {
+  for (int i = 0; i < num_regions; i++) {
+    if (regions[i].start == addr) return;   // already registered
+  }
+  if (num_regions >= RETAINED_RAM_MAX_REGIONS) {
+    fprintf(stderr, "RetainedRAM: more than %d regions, raise RETAINED_RAM_MAX_REGIONS\n", RETAINED_RAM_MAX_REGIONS);
+    abort();   // on the node this region would silently not survive System OFF
+  }
+  regions[num_regions].start = (void*) addr;
+  regions[num_regions].len = len;
+  num_regions++;
+}
+
+void RetainedRAM::applyRetention() {
+}
+
+void simPowerLoss() {
+  for (int i = 0; i < num_regions; i++) {
+    memset(regions[i].start, 0, regions[i].len);
+  }
+}
+
+int simRetainedBytes() {
+  int n = 0;
+  for (int i = 0; i < num_regions; i++) n += regions[i].len;
+  return n;
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+void simPowerLoss();       // zero every retained region, as a power cycle leaves them invalid
+int simRetainedBytes();    // bytes registered with RetainedRAM::retain() so far
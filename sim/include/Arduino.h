@@ -0,0 +1,51 @@
+#pragma once
+
+/**
+ * Host stand-in for the Arduino core: the subset the portable firmware modules use
+ *
+ * millis() reads the simulated clock of the node being stepped (SimClock in SimArduino.cpp),
+ * which only moves when the simulation advances it, so a run is repeatable to the millisecond.
+ * Serial writes to stdout; the sim builds with SENSOR_LOG_LEVEL 0, so it is only used for dumps.
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+#define constrain(amt, low, high)   ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+uint32_t millis();
+void delay(uint32_t ms);
+
+class Stream {
+public:
+  virtual ~Stream() { }
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t len) {
+    for (size_t i = 0; i < len; i++) write(buf[i]);
+    return len;
+  }
+  virtual int available() { return 0; }
+  virtual int read() { return -1; }
+  virtual void flush() { }
+
+  size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t println(const char* s = "") { return print(s) + print("\n"); }
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class HostSerial : public Stream {
+public:
+  size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+  size_t write(const uint8_t* buf, size_t len) override { return fwrite(buf, 1, len, stdout); }
+  void flush() override { fflush(stdout); }
+};
+
+extern HostSerial Serial;
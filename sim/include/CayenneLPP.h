@@ -0,0 +1,83 @@
+#pragma once
+
+/**
+ * Host stand-in for CayenneLPP: type codes and the add* calls the firmware uses
+ *
+ * Values are encoded with the LPPUtils size/multiplier tables, the same tables the node uses to
+ * walk its readings, so the bytes (and the packet sizes built from them) match what it sends.
+ */
+#include <Arduino.h>
+
+#define LPP_DIGITAL_INPUT         0
+#define LPP_DIGITAL_OUTPUT        1
+#define LPP_ANALOG_INPUT          2
+#define LPP_ANALOG_OUTPUT         3
+#define LPP_GENERIC_SENSOR        100
+#define LPP_LUMINOSITY            101
+#define LPP_PRESENCE              102
+#define LPP_TEMPERATURE           103
+#define LPP_RELATIVE_HUMIDITY     104
+#define LPP_ACCELEROMETER         113
+#define LPP_BAROMETRIC_PRESSURE   115
+#define LPP_VOLTAGE               116
+#define LPP_CURRENT               117
+#define LPP_FREQUENCY             118
+#define LPP_PERCENTAGE            120
+#define LPP_ALTITUDE              121
+#define LPP_CONCENTRATION         125
+#define LPP_POWER                 128
+#define LPP_DISTANCE              130
+#define LPP_ENERGY                131
+#define LPP_DIRECTION             132
+#define LPP_UNIXTIME              133
+#define LPP_GYROMETER             134
+#define LPP_COLOUR                135
+#define LPP_GPS                   136
+#define LPP_SWITCH                142
+#define LPP_POLYLINE              240
+
+// LPPUtils.h (which includes this header)
+uint8_t getDataSize(uint8_t type);
+uint32_t getMultiplier(uint8_t type);
+bool isSigned(uint8_t type);
+uint8_t putFloat(uint8_t* dest, float value, uint8_t size, uint32_t multiplier, bool is_signed);
+
+class CayenneLPP {
+public:
+  CayenneLPP(uint8_t size) : _max_size(size < sizeof(_buffer) ? size : sizeof(_buffer)), _cursor(0) { }
+
+  void reset() { _cursor = 0; }
+  uint8_t getSize() const { return _cursor; }
+  uint8_t* getBuffer() { return _buffer; }
+
+  uint8_t addDigitalInput(uint8_t ch, uint32_t v)        { return addField(ch, LPP_DIGITAL_INPUT, v); }
+  uint8_t addAnalogInput(uint8_t ch, float v)            { return addField(ch, LPP_ANALOG_INPUT, v); }
+  uint8_t addGenericSensor(uint8_t ch, uint32_t v)       { return addField(ch, LPP_GENERIC_SENSOR, v); }
+  uint8_t addLuminosity(uint8_t ch, uint32_t v)          { return addField(ch, LPP_LUMINOSITY, v); }
+  uint8_t addPresence(uint8_t ch, uint32_t v)            { return addField(ch, LPP_PRESENCE, v); }
+  uint8_t addTemperature(uint8_t ch, float v)            { return addField(ch, LPP_TEMPERATURE, v); }
+  uint8_t addRelativeHumidity(uint8_t ch, float v)       { return addField(ch, LPP_RELATIVE_HUMIDITY, v); }
+  uint8_t addBarometricPressure(uint8_t ch, float v)     { return addField(ch, LPP_BAROMETRIC_PRESSURE, v); }
+  uint8_t addVoltage(uint8_t ch, float v)                { return addField(ch, LPP_VOLTAGE, v); }
+  uint8_t addCurrent(uint8_t ch, float v)                { return addField(ch, LPP_CURRENT, v); }
+  uint8_t addPercentage(uint8_t ch, uint32_t v)          { return addField(ch, LPP_PERCENTAGE, v); }
+  uint8_t addAltitude(uint8_t ch, float v)               { return addField(ch, LPP_ALTITUDE, v); }
+  uint8_t addPower(uint8_t ch, uint32_t v)               { return addField(ch, LPP_POWER, v); }
+  uint8_t addDistance(uint8_t ch, float v)               { return addField(ch, LPP_DISTANCE, v); }
+  uint8_t addConcentration(uint8_t ch, uint32_t v)       { return addField(ch, LPP_CONCENTRATION, v); }
+
+private:
+  // returns the new size, 0 if the field does not fit (same as the library)
+  uint8_t addField(uint8_t ch, uint8_t type, float v) {
+    uint8_t size = getDataSize(type);
+    if (_cursor + 2 + size > _max_size) return 0;
+    _buffer[_cursor++] = ch;
+    _buffer[_cursor++] = type;
+    _cursor += putFloat(&_buffer[_cursor], v, size, getMultiplier(type), isSigned(type));
+    return _cursor;
+  }
+
+  uint8_t _buffer[255];
+  uint8_t _max_size;
+  uint8_t _cursor;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+/**
+ * Host stand-in for MeshCore.h: packet size constants and the helpers the portable modules use
+ *
+ * Values match MeshCore's MeshCore.h, so frame and batch capacities come out as on the node.
+ */
+#include <Arduino.h>
+
+#define MAX_HASH_SIZE        8
+#define PUB_KEY_SIZE        32
+#define SIGNATURE_SIZE      64
+#define MAX_ADVERT_DATA_SIZE  32
+#define CIPHER_KEY_SIZE     16
+#define CIPHER_BLOCK_SIZE   16
+#define CIPHER_MAC_SIZE      2
+#define PATH_HASH_SIZE       1
+#define MAX_PACKET_PAYLOAD  184
+#define MAX_PATH_SIZE        64
+#define MAX_TRANS_UNIT      255
+
+namespace mesh {
+
+class Utils {
+public:
+  static void printHex(Stream& s, const uint8_t* src, size_t len) {
+    for (size_t i = 0; i < len; i++) s.printf("%02X", src[i]);
+  }
+};
+
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+/**
+ * Host stand-in for MeshCore's helpers/IdentityStore.h: FILESYSTEM is the in-memory SimFS
+ *
+ * Only the filesystem type is provided; TelemetryLog and ConfigJournal include this header
+ * for FILESYSTEM and nothing else.
+ */
+#include <SimFS.h>
+
+#define FILESYSTEM   SimFS
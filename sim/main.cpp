@@ -0,0 +1,212 @@
+#include <Arduino.h>
+#include "SimNode.h"
+#include "SimRetainedRAM.h"
+#include "CodecCheck.h"
+
+/**
+ * Host-native benchmark of the sleep/wake cycle
+ *
+ *   sim [--cycles N] [--nodes N] [--seed N] [--interval S] [--advert N] [--batch K] [--compact]
+ *       [--no-log] [--lazy] [--no-slotting] [--slot-width S] [--listen N] [--zone] [--samples N]
+ *       [--spacing MS] [--sf N] [--bw KHZ] [--cr N] [--drift PPM] [--csv] [--profile]
+ *   sim --codec-check N [--seed N] [--codec-vectors]
+ *   sim --help
+ *
+ * Every node runs the given number of wake cycles from power-up; the report gives the mean and
+ * max cost of a cycle over all of them, and how many TX overlapped another node's. The same
+ * arguments and seed always give the same output, so two builds can be compared line by line.
+ *
+ * --codec-check runs N random batches through the compact telemetry encoder and decoder instead
+ * (see CodecCheck.h) and exits 1 if any of them does not round-trip. --check-periods exits 1 if
+ * any node skipped a period of the interval or woke twice in one.
+ */
+struct Metric {
+  double sum;
+  double max;
+  void add(double v) {
+    sum += v;
+    if (v > max) max = v;
+  }
+};
+
+struct Report {
+  bool csv;
+  uint32_t cycles;
+  uint32_t system_on;
+  uint32_t periods_skipped, periods_repeated;
+  Metric awake_ms, packets, bytes, air_ms, flash_bytes, flash_commits, flash_erases, wake_uah;
+  double total_uah;
+  double total_ms;
+};
+
+static void onCycle(void* ctx, uint16_t node, uint32_t cycle, const SimCycleStats& c) {
+  Report* r = (Report*) ctx;
+  r->cycles++;
+  r->system_on += c.system_on;
+  r->periods_skipped += c.periods_skipped;
+  r->periods_repeated += c.period_repeated;
+  r->awake_ms.add(c.awake_ms);
+  r->packets.add(c.packets);
+  r->bytes.add(c.bytes);
+  r->air_ms.add(c.air_ms);
+  r->flash_bytes.add(c.flash_bytes);
+  r->flash_commits.add(c.flash_commits);
+  r->flash_erases.add(c.flash_erases);
+  r->wake_uah.add(c.wake_uah);
+  r->total_uah += c.wake_uah + c.sleep_uah;
+  r->total_ms += c.awake_ms + c.sleep_ms;
+
+  if (r->csv) {
+    printf("%u,%lu,%lu,%u,%lu,%lu,%lu,%lu,%lu,%lu,%.2f,%.2f\n", node, (unsigned long)cycle, (unsigned long)c.awake_ms,
+           c.system_on, (unsigned long)c.packets, (unsigned long)c.bytes, (unsigned long)c.air_ms,
+           (unsigned long)c.flash_bytes, (unsigned long)c.flash_commits, (unsigned long)c.flash_erases,
+           c.wake_uah, c.sleep_uah);
+  }
+}
+
+static void printMetric(const char* name, const Metric& m, uint32_t n) {
+  printf("  %-16s %10.2f %10.0f\n", name, n ? m.sum / n : 0.0, m.max);
+}
+
+static void printUsage() {
+  printf("usage: sim [options]\n"
+         "  --cycles N        wake cycles per node (1000)\n"
+         "  --nodes N         nodes sharing the channel (1)\n"
+         "  --seed N          random seed (1)\n"
+         "  --interval S      sleep interval in seconds (300)\n"
+         "  --advert N        advert every N wakes (12)\n"
+         "  --batch K         batch K wakes per telemetry send (1 = off, max %d)\n"
+         "  --compact         compact delta-encoded batches instead of CayenneLPP\n"
+         "  --no-log          no flash telemetry log\n"
+         "  --lazy            lazy radio: power up on the first packet\n"
+         "  --no-slotting     wake at the start of each interval, no TX jitter\n"
+         "  --slot-width S    wake slot width in seconds (0 = 1 s)\n"
+         "  --listen N        downlink window after every Nth telemetry TX (0 = never)\n"
+         "  --zone            broadcast zone set: transport codes on every flood\n"
+         "  --samples N       battery samples per wake (5)\n"
+         "  --spacing MS      time between samples (1000)\n"
+         "  --sf N --bw KHZ --cr N   LoRa settings (SF8, 62.5 kHz, CR4/5)\n"
+         "  --drift PPM       RTC drift range, +/- (20)\n"
+         "  --csv             one CSV row per cycle instead of the report\n"
+         "  --profile         print node 0's wake profile\n"
+         "  --check-periods   exit 1 unless every interval period got exactly one wake\n"
+         "  --codec-check N   round-trip N random compact batches instead, exit 1 on a mismatch\n"
+         "  --codec-vectors   with --codec-check: print every batch for mqtt_decoder.py\n"
+         "  --help            this text\n", MAX_BATCH_WAKES);
+}
+
+static bool parseArgs(int argc, char** argv, SimConfig& cfg, uint32_t& cycles, uint32_t& nodes, uint32_t& seed,
+                      bool& csv, bool& profile, bool& check_periods, uint32_t& codec_batches, bool& codec_vectors) {
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    const char* v = i + 1 < argc ? argv[i + 1] : NULL;
+    bool has_value = true;
+    if (strcmp(a, "--cycles") == 0 && v) cycles = atol(v);
+    else if (strcmp(a, "--nodes") == 0 && v) nodes = atol(v);
+    else if (strcmp(a, "--seed") == 0 && v) seed = atol(v);
+    else if (strcmp(a, "--interval") == 0 && v) cfg.sleep_interval_secs = atol(v);
+    else if (strcmp(a, "--advert") == 0 && v) cfg.wakeups_per_advert = atoi(v);
+    else if (strcmp(a, "--batch") == 0 && v) cfg.batch_wakes = atoi(v);
+    else if (strcmp(a, "--slot-width") == 0 && v) cfg.slot_width_secs = atoi(v);
+    else if (strcmp(a, "--listen") == 0 && v) cfg.listen_every = atoi(v);
+    else if (strcmp(a, "--samples") == 0 && v) cfg.samples_per_wake = atoi(v);
+    else if (strcmp(a, "--spacing") == 0 && v) cfg.sample_spacing_ms = atoi(v);
+    else if (strcmp(a, "--sf") == 0 && v) cfg.sf = atoi(v);
+    else if (strcmp(a, "--bw") == 0 && v) cfg.bw_khz = atof(v);
+    else if (strcmp(a, "--cr") == 0 && v) cfg.cr = atoi(v);
+    else if (strcmp(a, "--drift") == 0 && v) cfg.drift_ppm = atof(v);
+    else if (strcmp(a, "--codec-check") == 0 && v) codec_batches = atol(v);
+    else {
+      has_value = false;
+      if (strcmp(a, "--compact") == 0) cfg.telemetry_format = TELEM_SCHEMA_COMPACT;
+      else if (strcmp(a, "--no-log") == 0) cfg.telemetry_log = 0;
+      else if (strcmp(a, "--lazy") == 0) cfg.lazy_radio = 1;
+      else if (strcmp(a, "--no-slotting") == 0) cfg.tx_slotting = 0;
+      else if (strcmp(a, "--zone") == 0) cfg.zone = true;
+      else if (strcmp(a, "--csv") == 0) csv = true;
+      else if (strcmp(a, "--profile") == 0) profile = true;
+      else if (strcmp(a, "--check-periods") == 0) check_periods = true;
+      else if (strcmp(a, "--codec-vectors") == 0) codec_vectors = true;
+      else if (strcmp(a, "--help") == 0 || strcmp(a, "-h") == 0) {
+        printUsage();
+        exit(0);
+      } else {
+        fprintf(stderr, "unknown or incomplete option: %s (see --help)\n", a);
+        return false;
+      }
+    }
+    if (has_value) i++;
+  }
+  if (cycles == 0 || nodes == 0 || nodes > 0xFFFF || cfg.sleep_interval_secs == 0 || cfg.wakeups_per_advert == 0 ||
+      cfg.batch_wakes > MAX_BATCH_WAKES ||
+      cfg.sf < 5 || cfg.sf > 12 || cfg.cr < 5 || cfg.cr > 8 || cfg.bw_khz <= 0) {
+    fprintf(stderr, "invalid configuration (see --help)\n");
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  SimConfig cfg;
+  uint32_t cycles = 1000, nodes = 1, seed = 1;
+  uint32_t codec_batches = 0;
+  bool csv = false, profile = false, check_periods = false, codec_vectors = false;
+  if (!parseArgs(argc, argv, cfg, cycles, nodes, seed, csv, profile, check_periods, codec_batches, codec_vectors)) return 2;
+
+  if (codec_batches > 0) {
+    uint32_t failed = runCodecCheck(seed, codec_batches, codec_vectors);
+    if (!codec_vectors || failed) {
+      fprintf(stderr, "codec check, seed %lu: %lu of %lu batches failed\n", (unsigned long)seed,
+              (unsigned long)failed, (unsigned long)codec_batches);
+    }
+    return failed ? 1 : 0;
+  }
+
+  Report r;
+  memset(&r, 0, sizeof(r));
+  r.csv = csv;
+  if (csv) {
+    printf("node,cycle,awake_ms,system_on,packets,bytes,air_ms,flash_bytes,flash_commits,flash_erases,wake_uah,sleep_uah\n");
+  }
+
+  SimChannel channel;
+  for (uint32_t n = 0; n < nodes; n++) {
+    simPowerLoss();   // every node powers up with empty retained RAM and an empty filesystem
+    SimNode* node = new SimNode(cfg, n, seed, channel);
+    node->run(cycles, onCycle, &r);
+    if (profile && n == 0 && !csv) {
+      printf("node 0: wake key %08lx, RTC drift %+.1f ppm\n", (unsigned long)node->getWakeKey(), node->getDriftPpm());
+      node->getProfiler().print(Serial);
+      printf("\n");
+    }
+    delete node;
+  }
+  bool periods_ok = r.periods_skipped == 0 && r.periods_repeated == 0;
+  if (csv) return check_periods && !periods_ok ? 1 : 0;
+
+  printf("%lu node(s) x %lu cycles, seed %lu: interval %lu s, SF%d BW%g CR4/%d, advert every %d, batch %d (%s), log %s%s%s\n",
+         (unsigned long)nodes, (unsigned long)cycles, (unsigned long)seed, (unsigned long)cfg.sleep_interval_secs,
+         cfg.sf, cfg.bw_khz, cfg.cr, cfg.wakeups_per_advert, cfg.batch_wakes,
+         cfg.telemetry_format == TELEM_SCHEMA_COMPACT ? "compact" : "lpp", cfg.telemetry_log ? "on" : "off",
+         cfg.tx_slotting ? ", slotting" : "", cfg.lazy_radio ? ", lazy radio" : "");
+  printf("  per cycle              mean        max\n");
+  printMetric("awake ms", r.awake_ms, r.cycles);
+  printMetric("packets", r.packets, r.cycles);
+  printMetric("bytes on air", r.bytes, r.cycles);
+  printMetric("airtime ms", r.air_ms, r.cycles);
+  printMetric("flash bytes", r.flash_bytes, r.cycles);
+  printMetric("flash commits", r.flash_commits, r.cycles);
+  printMetric("flash erases", r.flash_erases, r.cycles);
+  printMetric("wake uAh", r.wake_uah, r.cycles);
+  printf("  System ON sleeps: %lu of %lu, average current %.2f uA\n", (unsigned long)r.system_on, (unsigned long)r.cycles,
+         r.total_ms > 0 ? r.total_uah / (r.total_ms / 3600000.0) : 0.0);
+  printf("  wake periods: %lu skipped, %lu with a second wake\n", (unsigned long)r.periods_skipped,
+         (unsigned long)r.periods_repeated);
+  if (nodes > 1) {
+    uint32_t tx = channel.getNumTx();
+    uint32_t hit = channel.countCollisions();
+    printf("  collisions: %lu of %lu TX overlap another node's (%.2f%%)\n", (unsigned long)hit, (unsigned long)tx,
+           tx ? 100.0 * hit / tx : 0.0);
+  }
+  return check_periods && !periods_ok ? 1 : 0;
+}
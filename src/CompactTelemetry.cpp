@@ -0,0 +1,179 @@
+#include "CompactTelemetry.h"
+#include "LPPUtils.h"
+#include <string.h>
+
+static uint32_t zigzag(int32_t v) {
+  return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v) {
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static int putVarint(uint8_t* dest, int ofs, int max_len, uint32_t v) {
+  do {
+    if (ofs >= max_len) return -1;
+    uint8_t b = v & 0x7F;
+    v >>= 7;
+    dest[ofs++] = v ? (b | 0x80) : b;
+  } while (v);
+  return ofs;
+}
+
+static int32_t readRaw(const uint8_t* p, uint8_t size, bool is_signed) {
+  uint32_t v = 0;
+  for (uint8_t i = 0; i < size; i++) {
+    v = (v << 8) | p[i];
+  }
+  if (is_signed && size < 4 && (v & (1ul << (size * 8 - 1)))) {
+    v |= ~0ul << (size * 8);   // sign-extend
+  }
+  return (int32_t)v;
+}
+
+static void writeRaw(uint8_t* p, uint8_t size, int32_t raw) {
+  uint32_t v = (uint32_t)raw;
+  for (uint8_t i = size; i > 0; i--) {
+    p[i - 1] = v & 0xFF;
+    v >>= 8;
+  }
+}
+
+/* ------------------------------ Encoder -------------------------------- */
+
+void CompactTelemetryEncoder::begin(uint8_t* dest, int max_len, uint32_t base_time) {
+  _dest = dest;
+  _max_len = max_len;
+  _len = max_len > 0 ? 1 : 0;
+  _count = 0;
+  _last_time = base_time;
+  _num_fields = 0;
+  if (_len) _dest[0] = 0;
+}
+
+bool CompactTelemetryEncoder::add(uint32_t timestamp, const uint8_t* lpp, uint8_t len) {
+  if (_len == 0 || _count == 0xFF) return false;
+
+  // layout of this reading
+  uint8_t n = 0;
+  uint8_t channels[COMPACT_MAX_FIELDS];
+  uint8_t types[COMPACT_MAX_FIELDS];
+  for (uint8_t i = 0; i + 2 <= len; ) {
+    if (n >= COMPACT_MAX_FIELDS || lpp[i + 1] == LPP_POLYLINE) return false;   // variable length
+    channels[n] = lpp[i];
+    types[n] = lpp[i + 1];
+    i += 2 + getDataSize(types[n]);
+    if (i > len) return false;
+    n++;
+  }
+  bool new_layout = _count == 0 || n != _num_fields ||
+      memcmp(channels, _channels, n) != 0 || memcmp(types, _types, n) != 0;
+
+  uint32_t dt = timestamp >= _last_time ? timestamp - _last_time : 0;
+  if (dt > 0x7FFFFFFF) return false;
+  int ofs = putVarint(_dest, _len, _max_len, (dt << 1) | (new_layout ? 1 : 0));
+  if (ofs < 0) return false;
+
+  if (new_layout) {
+    if (ofs + 1 + 2 * n > _max_len) return false;
+    _dest[ofs++] = n;
+    for (uint8_t f = 0; f < n; f++) {
+      _dest[ofs++] = channels[f];
+      _dest[ofs++] = types[f];
+    }
+  }
+
+  int32_t values[COMPACT_MAX_VALUES];
+  int v = 0;
+  uint8_t i = 0;
+  for (uint8_t f = 0; f < n; f++) {
+    i += 2;
+    uint8_t sizes[3];
+    uint32_t multipliers[3];
+    uint8_t nc = getComponents(types[f], sizes, multipliers);
+    for (uint8_t c = 0; c < nc; c++) {
+      values[v] = readRaw(&lpp[i], sizes[c], isSigned(types[f]));
+      int32_t prev = new_layout ? 0 : _prev[v];
+      ofs = putVarint(_dest, ofs, _max_len, zigzag((int32_t)((uint32_t)values[v] - (uint32_t)prev)));
+      if (ofs < 0) return false;
+      i += sizes[c];
+      v++;
+    }
+  }
+
+  // commit
+  if (new_layout) {
+    _num_fields = n;
+    memcpy(_channels, channels, n);
+    memcpy(_types, types, n);
+  }
+  memcpy(_prev, values, v * sizeof(int32_t));
+  _last_time = timestamp;
+  _len = ofs;
+  _dest[0] = ++_count;
+  return true;
+}
+
+/* ------------------------------ Decoder -------------------------------- */
+
+CompactTelemetryDecoder::CompactTelemetryDecoder(uint32_t base_time, const uint8_t* body, int len)
+  : _body(body), _len(len), _pos(0), _count(0), _done(0), _last_time(base_time), _num_fields(0) {
+  if (_len > 0) _count = _body[_pos++];
+}
+
+bool CompactTelemetryDecoder::getVarint(uint32_t& v) {
+  v = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    if (_pos >= _len) return false;
+    uint8_t b = _body[_pos++];
+    v |= (uint32_t)(b & 0x7F) << shift;
+    if ((b & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+bool CompactTelemetryDecoder::next(uint32_t& timestamp, uint8_t* lpp, uint8_t& lpp_len, int lpp_max) {
+  if (_done >= _count) return false;
+
+  uint32_t hdr;
+  if (!getVarint(hdr)) return false;
+  bool new_layout = hdr & 1;
+  if (new_layout) {
+    if (_pos >= _len) return false;
+    uint8_t n = _body[_pos++];
+    if (n > COMPACT_MAX_FIELDS || _pos + 2 * n > _len) return false;
+    for (uint8_t f = 0; f < n; f++) {
+      _channels[f] = _body[_pos++];
+      _types[f] = _body[_pos++];
+    }
+    _num_fields = n;
+  } else if (_done == 0) {
+    return false;   // first record must carry the layout
+  }
+
+  int ofs = 0;
+  int v = 0;
+  for (uint8_t f = 0; f < _num_fields; f++) {
+    if (ofs + 2 + getDataSize(_types[f]) > lpp_max) return false;
+    lpp[ofs++] = _channels[f];
+    lpp[ofs++] = _types[f];
+    uint8_t sizes[3];
+    uint32_t multipliers[3];
+    uint8_t nc = getComponents(_types[f], sizes, multipliers);
+    for (uint8_t c = 0; c < nc; c++) {
+      uint32_t delta;
+      if (!getVarint(delta)) return false;
+      int32_t prev = new_layout ? 0 : _prev[v];
+      _prev[v] = (int32_t)((uint32_t)prev + (uint32_t)unzigzag(delta));
+      writeRaw(&lpp[ofs], sizes[c], _prev[v]);
+      ofs += sizes[c];
+      v++;
+    }
+  }
+
+  _last_time += hdr >> 1;
+  timestamp = _last_time;
+  lpp_len = ofs;
+  _done++;
+  return true;
+}
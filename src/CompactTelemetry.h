@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+#include "TelemetryEncoder.h"
+
+/**
+ * Compact telemetry body (TELEM_SCHEMA_COMPACT): delta-encoded alternative to a CayenneLPP batch
+ *
+ * A CayenneLPP batch repeats the channel/type header of every value in every record. Here the
+ * layout is sent once and each record only carries the change of each raw LPP integer since the
+ * previous record, so slowly moving readings cost about one byte per value.
+ *
+ * Body (after the [timestamp u32][flags u8] header):
+ *   [count u8] then count x record
+ * Record:
+ *   [varint (dt << 1) | L]      dt = seconds after the previous record (first: after the timestamp)
+ *   if L: [n u8] n x { [channel u8][LPP type u8] }   new layout, previous values restart at 0
+ *   one zigzag varint per value component (GPS/accelerometer/gyrometer: 3): raw - previous raw
+ *
+ * Raw values are the LPP big-endian integers (sign-extended for signed types), so a decoder
+ * rebuilds the original CayenneLPP bytes of every record exactly.
+ */
+#define COMPACT_MAX_FIELDS   16
+#define COMPACT_MAX_VALUES   (COMPACT_MAX_FIELDS * 3)
+
+class CompactTelemetryEncoder : public TelemetryEncoder {
+public:
+  uint8_t getFlags() const override { return TELEM_FLAG_BATCH | (TELEM_SCHEMA_COMPACT << TELEM_SCHEMA_SHIFT); }
+
+  /**
+   * Start a body in dest (writes the count byte)
+   * @param base_time  timestamp placed in the packet header
+   */
+  void begin(uint8_t* dest, int max_len, uint32_t base_time) override;
+
+  /**
+   * Append one reading
+   * @return false if it does not fit or holds a type the format cannot carry (body unchanged)
+   */
+  bool add(uint32_t timestamp, const uint8_t* lpp, uint8_t len) override;
+
+  int getLength() const override { return _len; }
+  uint8_t getCount() const override { return _count; }
+
+private:
+  uint8_t* _dest;
+  int _max_len;
+  int _len;
+  uint8_t _count;
+  uint32_t _last_time;
+  uint8_t _num_fields;
+  uint8_t _channels[COMPACT_MAX_FIELDS];
+  uint8_t _types[COMPACT_MAX_FIELDS];
+  int32_t _prev[COMPACT_MAX_VALUES];
+};
+
+/**
+ * Reference decoder of the compact body: the firmware only encodes, but this is the C++ statement
+ * of the wire format that mqtt_decoder.py decode_compact() must match (checked by sim --codec-check)
+ */
+class CompactTelemetryDecoder {
+public:
+  CompactTelemetryDecoder(uint32_t base_time, const uint8_t* body, int len);
+
+  uint8_t getCount() const { return _count; }
+
+  /**
+   * Rebuild the next record as CayenneLPP bytes
+   * @return false at the end of the body or on malformed data
+   */
+  bool next(uint32_t& timestamp, uint8_t* lpp, uint8_t& lpp_len, int lpp_max);
+
+  // bytes consumed so far (whole body once next() has returned false at the end)
+  int getPosition() const { return _pos; }
+
+private:
+  const uint8_t* _body;
+  int _len;
+  int _pos;
+  uint8_t _count;
+  uint8_t _done;
+  uint32_t _last_time;
+  uint8_t _num_fields;
+  uint8_t _channels[COMPACT_MAX_FIELDS];
+  uint8_t _types[COMPACT_MAX_FIELDS];
+  int32_t _prev[COMPACT_MAX_VALUES];
+
+  bool getVarint(uint32_t& v);
+};
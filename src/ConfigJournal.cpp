@@ -0,0 +1,166 @@
+#include "ConfigJournal.h"
+#include <MeshCore.h>
+#include <RetainedRAM.h>
+#include <LogLevel.h>
+#include "FSUtils.h"
+
+#define CFG_JOURNAL_MAGIC        0x4C4E524A   // 'JRNL'
+#define CFG_JOURNAL_FILE         "/cfg_journal"
+#define CFG_JOURNAL_MAX_RANGES   16
+
+struct ConfigJournalState {
+  uint8_t scanned;          // file size has been read since power-up
+  uint32_t size;            // bytes in the journal file (0 = none)
+};
+
+static RETAINED_RAM RetainedBlock<ConfigJournalState, CFG_JOURNAL_MAGIC> journal_state;
+
+static void writeRecordHeader(File& f, uint8_t kind, uint16_t offset, uint16_t len) {
+  uint8_t hdr[CFG_JOURNAL_RECORD_HDR];
+  hdr[0] = kind;
+  memcpy(&hdr[1], &offset, 2);
+  memcpy(&hdr[3], &len, 2);
+  f.write(hdr, sizeof(hdr));
+}
+
+void ConfigJournal::begin(FILESYSTEM* fs, uint32_t layout) {
+  _fs = fs;
+  _layout = layout;
+  journal_state.retain();
+  if (!journal_state.isValid()) {
+    memset(&journal_state.data, 0, sizeof(journal_state.data));   // size is read on first flash access
+    journal_state.commit();
+  }
+}
+
+void ConfigJournal::scan() {
+  ConfigJournalState& st = journal_state.data;
+  if (st.scanned) return;
+
+  st.size = 0;
+  if (_fs->exists(CFG_JOURNAL_FILE)) {
+    File f = openRead(_fs, CFG_JOURNAL_FILE);
+    if (f) {
+      st.size = f.size();
+      f.close();
+    }
+  }
+  st.scanned = 1;
+  journal_state.commit();
+}
+
+uint32_t ConfigJournal::getSize() {
+  if (_fs == NULL) return 0;
+  scan();
+  return journal_state.data.size;
+}
+
+void ConfigJournal::clear() {
+  if (_fs == NULL) return;
+  _fs->remove(CFG_JOURNAL_FILE);
+  File f = openAppend(_fs, CFG_JOURNAL_FILE);
+  uint32_t size = 0;
+  if (f) {
+    uint32_t magic = CFG_JOURNAL_MAGIC;
+    f.write((uint8_t*)&magic, 4);
+    f.write((uint8_t*)&_layout, 4);
+    f.close();
+    size = CFG_JOURNAL_HDR;
+  }
+  journal_state.data.size = size;
+  journal_state.data.scanned = 1;
+  journal_state.commit();
+}
+
+bool ConfigJournal::appendDiff(uint8_t kind, const void* before, const void* after, uint16_t size) {
+  const uint8_t* a = (const uint8_t*) before;
+  const uint8_t* b = (const uint8_t*) after;
+
+  // changed ranges, merging gaps shorter than a record header
+  uint16_t starts[CFG_JOURNAL_MAX_RANGES], ends[CFG_JOURNAL_MAX_RANGES];
+  int n = 0;
+  uint32_t total = 0;
+  for (uint16_t i = 0; i < size; i++) {
+    if (a[i] == b[i]) continue;
+    if (n > 0 && i - ends[n - 1] <= CFG_JOURNAL_RECORD_HDR) {
+      ends[n - 1] = i + 1;
+      continue;
+    }
+    if (n == CFG_JOURNAL_MAX_RANGES) return false;   // scattered change, cheaper as a compaction
+    starts[n] = i;
+    ends[n] = i + 1;
+    n++;
+  }
+  if (n == 0) return true;
+  for (int r = 0; r < n; r++) total += CFG_JOURNAL_RECORD_HDR + ends[r] - starts[r];
+
+  if (_fs == NULL) return false;
+  scan();
+  ConfigJournalState& st = journal_state.data;
+  if (st.size < CFG_JOURNAL_HDR) clear();
+  if (st.size < CFG_JOURNAL_HDR || st.size + total > CFG_JOURNAL_MAX_SIZE) return false;
+
+  File f = openAppend(_fs, CFG_JOURNAL_FILE);
+  if (!f) return false;
+  for (int r = 0; r < n; r++) {
+    writeRecordHeader(f, kind, starts[r], ends[r] - starts[r]);
+    f.write(&b[starts[r]], ends[r] - starts[r]);
+  }
+  f.close();
+
+  st.size += total;
+  journal_state.commit();
+  return true;
+}
+
+bool ConfigJournal::append(uint8_t kind, uint16_t offset, const void* data, uint16_t len) {
+  if (_fs == NULL) return false;
+  scan();
+  ConfigJournalState& st = journal_state.data;
+  if (st.size < CFG_JOURNAL_HDR) clear();
+  if (st.size < CFG_JOURNAL_HDR || st.size + CFG_JOURNAL_RECORD_HDR + len > CFG_JOURNAL_MAX_SIZE) return false;
+
+  File f = openAppend(_fs, CFG_JOURNAL_FILE);
+  if (!f) return false;
+  writeRecordHeader(f, kind, offset, len);
+  f.write((const uint8_t*)data, len);
+  f.close();
+
+  st.size += CFG_JOURNAL_RECORD_HDR + len;
+  journal_state.commit();
+  return true;
+}
+
+int ConfigJournal::replay(ApplyFn apply, void* ctx) {
+  if (_fs == NULL || !_fs->exists(CFG_JOURNAL_FILE)) return 0;
+
+  File f = openRead(_fs, CFG_JOURNAL_FILE);
+  if (!f) return -1;
+
+  uint32_t hdr[2];
+  if (f.read((uint8_t*)hdr, sizeof(hdr)) != sizeof(hdr) || hdr[0] != CFG_JOURNAL_MAGIC || hdr[1] != _layout) {
+    f.close();
+    LOG_WARN("Config journal: unknown header/layout, not replayed");
+    return -1;
+  }
+
+  int n = 0;
+  bool truncated = false;
+  uint8_t rec[CFG_JOURNAL_RECORD_HDR];
+  uint8_t buf[CFG_JOURNAL_MAX_SIZE];
+  int got;
+  while ((got = f.read(rec, sizeof(rec))) == sizeof(rec)) {
+    uint16_t offset, len;
+    memcpy(&offset, &rec[1], 2);
+    memcpy(&len, &rec[3], 2);
+    if (len > sizeof(buf) || f.read(buf, len) != len) {   // truncated tail (power loss during write)
+      truncated = true;
+      break;
+    }
+    apply(ctx, rec[0], offset, buf, len);
+    n++;
+  }
+  f.close();
+  LOG_DEBUG("Config journal: %d records replayed%s", n, truncated || got > 0 ? ", tail truncated" : "");
+  return truncated || got > 0 ? -1 : n;   // records after a bad tail would never be read, caller compacts
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Arduino.h>
+#include <helpers/IdentityStore.h>   // FILESYSTEM
+
+/**
+ * Append-only journal of config changes on the internal filesystem
+ *
+ * Instead of removing and rewriting the prefs/ACL files on every change, changed byte ranges
+ * are appended as small records and replayed over the base files on a cold boot. Only when
+ * the journal would grow past CFG_JOURNAL_MAX_SIZE does the caller compact: rewrite the base
+ * files and clear() the journal.
+ *
+ * File:   [magic u32][layout u32] then records
+ * Record: [kind u8][offset u16 LE][len u16 LE][bytes]
+ * 'layout' identifies the in-RAM structs the offsets refer to; a journal written by a build
+ * with a different layout cannot be replayed, so replay() rejects it.
+ */
+#ifndef CFG_JOURNAL_MAX_SIZE
+  #define CFG_JOURNAL_MAX_SIZE   1024
+#endif
+#define CFG_JOURNAL_HDR          8    // magic(4) + layout(4)
+#define CFG_JOURNAL_RECORD_HDR   5    // kind(1) + offset(2) + len(2)
+
+class ConfigJournal {
+public:
+  ConfigJournal() : _fs(NULL) { }
+
+  typedef void (*ApplyFn)(void* ctx, uint8_t kind, uint16_t offset, const uint8_t* data, uint16_t len);
+
+  void begin(FILESYSTEM* fs, uint32_t layout);   // no flash access
+
+  /**
+   * Append the ranges where 'after' differs from 'before' (filesystem must be mounted)
+   * @return false if they would not fit (nothing written, caller compacts)
+   */
+  bool appendDiff(uint8_t kind, const void* before, const void* after, uint16_t size);
+  bool append(uint8_t kind, uint16_t offset, const void* data, uint16_t len);
+
+  /**
+   * Apply every record in order
+   * @return number of records applied, or -1 if the journal is unreadable, from another layout or
+   *         has a truncated tail (records before it are still applied; caller compacts)
+   */
+  int replay(ApplyFn apply, void* ctx);
+
+  void clear();          // truncate to an empty journal (after the base files were rewritten)
+  uint32_t getSize();    // bytes used, 0 if there is no journal
+
+private:
+  FILESYSTEM* _fs;
+  uint32_t _layout;
+
+  void scan();
+};
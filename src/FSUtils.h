@@ -0,0 +1,39 @@
+#pragma once
+
+#include <helpers/IdentityStore.h>   // FILESYSTEM
+
+/**
+ * File open modes per platform core, in one place
+ *
+ * InternalFS (nRF52/STM32) takes FILE_O_WRITE and appends; LittleFS on RP2040 takes stdio modes;
+ * SPIFFS on ESP32 needs the create flag for a new file.
+ */
+inline File openAppend(FILESYSTEM* fs, const char* fname) {
+  #if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
+    return fs->open(fname, FILE_O_WRITE);
+  #elif defined(RP2040_PLATFORM)
+    return fs->open(fname, "a");
+  #else
+    return fs->open(fname, "a", true);
+  #endif
+}
+
+inline File openRead(FILESYSTEM* fs, const char* fname) {
+  #if defined(RP2040_PLATFORM)
+    return fs->open(fname, "r");
+  #else
+    return fs->open(fname);
+  #endif
+}
+
+// Replace the file's contents (InternalFS has no truncating mode, so the old file is removed first)
+inline File openTruncate(FILESYSTEM* fs, const char* fname) {
+  #if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
+    fs->remove(fname);
+    return fs->open(fname, FILE_O_WRITE);
+  #elif defined(RP2040_PLATFORM)
+    return fs->open(fname, "w");
+  #else
+    return fs->open(fname, "w", true);
+  #endif
+}
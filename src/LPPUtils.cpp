@@ -0,0 +1,155 @@
+#include "LPPUtils.h"
+
+uint8_t getDataSize(uint8_t type) {
+    switch (type) {
+      case LPP_GPS:
+        return 9;
+      case LPP_POLYLINE:
+        return 8;  // TODO: this is MINIMIUM
+      case LPP_GYROMETER:
+      case LPP_ACCELEROMETER:
+        return 6;
+      case LPP_GENERIC_SENSOR:
+      case LPP_FREQUENCY:
+      case LPP_DISTANCE:
+      case LPP_ENERGY:
+      case LPP_UNIXTIME:
+        return 4;
+      case LPP_COLOUR:
+        return 3;
+      case LPP_ANALOG_INPUT:
+      case LPP_ANALOG_OUTPUT:
+      case LPP_LUMINOSITY:
+      case LPP_TEMPERATURE:
+      case LPP_CONCENTRATION:
+      case LPP_BAROMETRIC_PRESSURE:
+      case LPP_ALTITUDE:
+      case LPP_VOLTAGE:
+      case LPP_CURRENT:
+      case LPP_DIRECTION:
+      case LPP_POWER:
+        return 2;
+    }
+    return 1;
+}
+
+uint32_t getMultiplier(uint8_t type) {
+    switch (type) {
+      case LPP_CURRENT:
+      case LPP_DISTANCE:
+      case LPP_ENERGY:
+        return 1000;
+      case LPP_VOLTAGE:
+      case LPP_ANALOG_INPUT:
+      case LPP_ANALOG_OUTPUT:
+        return 100;
+      case LPP_TEMPERATURE:
+      case LPP_BAROMETRIC_PRESSURE:
+      case LPP_RELATIVE_HUMIDITY:
+        return 10;
+    }
+    return 1;
+}
+
+bool isSigned(uint8_t type) {
+  return type == LPP_ALTITUDE || type == LPP_TEMPERATURE || type == LPP_GYROMETER ||
+      type == LPP_ANALOG_INPUT || type == LPP_ANALOG_OUTPUT || type == LPP_GPS || type == LPP_ACCELEROMETER;
+}
+
+float getFloat(const uint8_t * buffer, uint8_t size, uint32_t multiplier, bool is_signed) {
+  uint32_t value = 0;
+  for (uint8_t i = 0; i < size; i++) {
+    value = (value << 8) + buffer[i];
+  }
+
+  int sign = 1;
+  if (is_signed) {
+    uint32_t bit = 1ul << ((size * 8) - 1);
+    if ((value & bit) == bit) {
+      value = (bit << 1) - value;
+      sign = -1;
+    }
+  }
+  return sign * ((float) value / multiplier);
+}
+
+uint8_t putFloat(uint8_t * dest, float value, uint8_t size, uint32_t multiplier, bool is_signed) {
+  // check sign
+  bool sign = value < 0;
+  if (sign) value = -value;
+
+  // get value to store
+  uint32_t v = value * multiplier;
+
+  // format an uint32_t as if it was an int32_t
+  if (is_signed & sign) {
+    uint32_t mask = (1 << (size * 8)) - 1;
+    v = v & mask;
+    if (sign) v = mask - v + 1;
+  }
+
+  // add bytes (MSB first)
+  for (uint8_t i=1; i<=size; i++) {
+    dest[size - i] = (v & 0xFF);
+    v >>= 8;
+  }
+  return size;
+}
+
+uint8_t getComponents(uint8_t type, uint8_t* sizes, uint32_t* multipliers) {
+  switch (type) {
+    case LPP_GPS:
+      sizes[0] = sizes[1] = sizes[2] = 3;
+      multipliers[0] = multipliers[1] = 10000;
+      multipliers[2] = 100;
+      return 3;
+    case LPP_ACCELEROMETER:
+    case LPP_GYROMETER:
+      sizes[0] = sizes[1] = sizes[2] = 2;
+      multipliers[0] = multipliers[1] = multipliers[2] = (type == LPP_ACCELEROMETER) ? 1000 : 100;
+      return 3;
+  }
+  sizes[0] = getDataSize(type);
+  multipliers[0] = getMultiplier(type);
+  return 1;
+}
+
+float getLPPValue(const uint8_t* buf, uint8_t size, uint8_t channel, uint8_t type) {
+  uint8_t i = 0;
+
+  while (i + 2 < size) {
+    // Get channel #
+    uint8_t ch = buf[i++];
+    // Get data type
+    uint8_t t = buf[i++];
+    uint8_t sz = getDataSize(t);
+
+    if (ch == channel && t == type) {
+      return getFloat(&buf[i], sz, getMultiplier(t), isSigned(t));
+    }
+    i += sz;  // skip
+  }
+  return 0.0f;   // not found
+}
+
+bool addLPPValue(CayenneLPP& lpp, uint8_t channel, uint8_t type, float value) {
+  uint32_t u = value > 0 ? (uint32_t)(value + 0.5f) : 0;   // unsigned integer types
+  switch (type) {
+    case LPP_DIGITAL_INPUT:       return lpp.addDigitalInput(channel, u) != 0;
+    case LPP_ANALOG_INPUT:        return lpp.addAnalogInput(channel, value) != 0;
+    case LPP_GENERIC_SENSOR:      return lpp.addGenericSensor(channel, u) != 0;
+    case LPP_LUMINOSITY:          return lpp.addLuminosity(channel, u) != 0;
+    case LPP_PRESENCE:            return lpp.addPresence(channel, u) != 0;
+    case LPP_TEMPERATURE:         return lpp.addTemperature(channel, value) != 0;
+    case LPP_RELATIVE_HUMIDITY:   return lpp.addRelativeHumidity(channel, value) != 0;
+    case LPP_BAROMETRIC_PRESSURE: return lpp.addBarometricPressure(channel, value) != 0;
+    case LPP_VOLTAGE:             return lpp.addVoltage(channel, value) != 0;
+    case LPP_CURRENT:             return lpp.addCurrent(channel, value) != 0;
+    case LPP_PERCENTAGE:          return lpp.addPercentage(channel, u) != 0;
+    case LPP_ALTITUDE:            return lpp.addAltitude(channel, value) != 0;
+    case LPP_POWER:               return lpp.addPower(channel, u) != 0;
+    case LPP_DISTANCE:            return lpp.addDistance(channel, value) != 0;
+    case LPP_CONCENTRATION:       return lpp.addConcentration(channel, u) != 0;
+  }
+  return false;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Arduino.h>
+#include <CayenneLPP.h>   // LPP_* type codes
+
+/**
+ * Raw CayenneLPP field helpers shared by the telemetry, statistics and compact codec paths
+ *
+ * An LPP buffer is a sequence of [channel u8][type u8][value, big-endian]; these give the
+ * value layout per type so buffers can be walked without the CayenneLPP decoder.
+ */
+uint8_t getDataSize(uint8_t type);
+uint32_t getMultiplier(uint8_t type);
+bool isSigned(uint8_t type);
+float getFloat(const uint8_t * buffer, uint8_t size, uint32_t multiplier, bool is_signed);
+uint8_t putFloat(uint8_t * dest, float value, uint8_t size, uint32_t multiplier, bool is_signed);
+
+// Split multi-value LPP types into components so each is compared on its own scale
+// @return number of components (1 for scalar types, 3 for GPS/accelerometer/gyrometer)
+uint8_t getComponents(uint8_t type, uint8_t* sizes, uint32_t* multipliers);
+
+// First value of channel/type in an LPP buffer (live telemetry or a decoded CompactTelemetry record), 0 if absent
+float getLPPValue(const uint8_t* buf, uint8_t size, uint8_t channel, uint8_t type);
+
+// Add one scalar value through the typed CayenneLPP API
+// @return false for multi-value or unsupported types, or when the buffer is full
+bool addLPPValue(CayenneLPP& lpp, uint8_t channel, uint8_t type, float value);
@@ -0,0 +1,127 @@
+#include "LinkAdapter.h"
+#include <MeshCore.h>
+#include <RetainedRAM.h>
+#include <LogLevel.h>
+
+#define LINK_ADAPT_MAGIC   0x4B4E494C   // 'LINK'
+
+struct LinkAdaptState {
+  int8_t max_dbm;
+  int8_t tx_dbm;
+  uint8_t samples;          // saturates at 255
+  uint8_t tx_since_sample;
+  float snr_db;             // estimated SNR at max_dbm
+  float saved_mas;          // mA x ms
+};
+
+static RETAINED_RAM RetainedBlock<LinkAdaptState, LINK_ADAPT_MAGIC> link_state;
+
+// SX1262 HP PA supply current (datasheet points at +14..+22 dBm, extrapolated below)
+static float txCurrentMa(int8_t dbm) {
+  static const int8_t pts_dbm[] = { 2, 10, 14, 17, 20, 22 };
+  static const float pts_ma[] = { 40.0f, 65.0f, 90.0f, 95.0f, 102.0f, 118.0f };
+  if (dbm <= pts_dbm[0]) return pts_ma[0];
+  for (int i = 1; i < (int)sizeof(pts_dbm); i++) {
+    if (dbm <= pts_dbm[i]) {
+      return pts_ma[i - 1] + (pts_ma[i] - pts_ma[i - 1]) * (dbm - pts_dbm[i - 1]) / (pts_dbm[i] - pts_dbm[i - 1]);
+    }
+  }
+  return pts_ma[sizeof(pts_dbm) - 1];
+}
+
+// LoRa demodulation floor (SX126x): SF7 -7.5 dB, 2.5 dB lower per SF step
+static float snrFloorDb(uint8_t sf) {
+  return -2.5f * ((int)sf - 4);
+}
+
+void LinkAdapter::begin(int8_t max_dbm) {
+  link_state.retain();
+  if (!link_state.isValid()) {
+    memset(&link_state.data, 0, sizeof(link_state.data));
+    link_state.data.max_dbm = link_state.data.tx_dbm = max_dbm;
+    link_state.commit();
+  } else {
+    LOG_DEBUG("Link adapt restored: %d dBm, SNR %.1f dB (%d samples)", link_state.data.tx_dbm,
+                       link_state.data.snr_db, link_state.data.samples);
+  }
+  setMaxPower(max_dbm);
+}
+
+void LinkAdapter::setMaxPower(int8_t max_dbm) {
+  LinkAdaptState& st = link_state.data;
+  if (st.max_dbm == max_dbm) return;
+  st.max_dbm = max_dbm;
+  if (st.tx_dbm > max_dbm) st.tx_dbm = max_dbm;
+  link_state.commit();
+}
+
+void LinkAdapter::reset() {
+  int8_t max_dbm = link_state.data.max_dbm;
+  memset(&link_state.data, 0, sizeof(link_state.data));
+  link_state.data.max_dbm = link_state.data.tx_dbm = max_dbm;
+  link_state.commit();
+}
+
+void LinkAdapter::addSample(int8_t snr_x4, bool uplink) {
+  LinkAdaptState& st = link_state.data;
+  float snr = snr_x4 / 4.0f;
+  if (uplink) snr += st.max_dbm - st.tx_dbm;   // what full power would have given
+
+  if (st.samples == 0) {
+    st.snr_db = snr;
+  } else if (snr < st.snr_db) {
+    st.snr_db = (st.snr_db + snr) / 2;         // fades are followed quickly
+  } else {
+    st.snr_db = (st.snr_db * 3 + snr) / 4;     // improvements slowly
+  }
+  if (st.samples < 255) st.samples++;
+  st.tx_since_sample = 0;
+  link_state.commit();
+  LOG_DEBUG("Link adapt: %s SNR %.2f dB, estimate %.1f dB at %d dBm", uplink ? "uplink" : "inbound",
+                     snr_x4 / 4.0f, st.snr_db, st.max_dbm);
+}
+
+bool LinkAdapter::update(uint8_t sf, uint8_t margin_db) {
+  LinkAdaptState& st = link_state.data;
+  if (st.samples == 0) return false;
+
+  // power we could drop from max and still keep margin_db above the floor
+  float excess = st.snr_db - snrFloorDb(sf) - margin_db;
+  int want = st.max_dbm - (excess > 0 ? (int)excess : (int)floorf(excess));
+  want = constrain(want, LINK_ADAPT_MIN_DBM, st.max_dbm);
+
+  int8_t prev = st.tx_dbm;
+  if (want > st.tx_dbm) {
+    st.tx_dbm = want;                                  // short of margin: straight back up
+  } else if (want <= st.tx_dbm - LINK_ADAPT_HYST_DB) {
+    st.tx_dbm = max(want, st.tx_dbm - LINK_ADAPT_STEP_DB);
+  }
+  if (st.tx_dbm == prev) return false;
+
+  link_state.commit();
+  LOG_DEBUG("Link adapt: TX power %d -> %d dBm", prev, st.tx_dbm);
+  return true;
+}
+
+bool LinkAdapter::onTransmit(uint32_t air_ms) {
+  LinkAdaptState& st = link_state.data;
+  if (air_ms == 0) return false;
+
+  st.saved_mas += air_ms * (txCurrentMa(st.max_dbm) - txCurrentMa(st.tx_dbm));
+
+  bool changed = false;
+  if (st.tx_since_sample < 255) st.tx_since_sample++;
+  if (st.tx_since_sample >= LINK_ADAPT_STALE_TX && st.tx_dbm < st.max_dbm) {
+    st.tx_dbm = min((int)st.max_dbm, st.tx_dbm + LINK_ADAPT_STEP_DB);
+    st.tx_since_sample = 0;
+    changed = true;
+    LOG_DEBUG("Link adapt: no samples, TX power up to %d dBm", st.tx_dbm);
+  }
+  link_state.commit();
+  return changed;
+}
+
+int8_t LinkAdapter::getTxPower() const { return link_state.data.tx_dbm; }
+bool LinkAdapter::hasSamples() const { return link_state.data.samples > 0; }
+float LinkAdapter::getLinkSNR() const { return link_state.data.snr_db; }
+float LinkAdapter::getSavedMilliAh() const { return link_state.data.saved_mas / 3600000.0f; }   // mA.ms -> mAh
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * TX power link adaptation, state kept in retained RAM across system-off
+ *
+ * SNR samples are folded into an estimate of the link SNR at full power (the configured
+ * tx_power_dbm). TX power then steps down while the estimate stays more than the target margin
+ * above the demodulation floor of the current SF, and goes straight back up when it does not.
+ *   - uplink samples: SNR a neighbour measured for our own TX (discover response), corrected
+ *     for the power we used
+ *   - inbound samples: SNR of packets we received, taken as-is (peer assumed at full power,
+ *     which errs towards keeping our power up)
+ * With no samples for LINK_ADAPT_STALE_TX transmitting wakes, power drifts back up, so a
+ * node that lost its link does not stay quiet.
+ */
+#ifndef LINK_ADAPT_MIN_DBM
+  #define LINK_ADAPT_MIN_DBM     2
+#endif
+#define LINK_ADAPT_STEP_DB       2    // largest step down per update
+#define LINK_ADAPT_HYST_DB       3    // headroom needed before stepping down
+#define LINK_ADAPT_STALE_TX      8    // transmitting wakes without a sample before stepping up
+
+class LinkAdapter {
+public:
+  void begin(int8_t max_dbm);
+  void setMaxPower(int8_t max_dbm);   // configured tx_power_dbm, the ceiling
+  void reset();                       // forget samples, back to full power
+
+  /**
+   * Add an SNR sample
+   * @param snr_x4  SNR in 0.25 dB units (packet->_snr)
+   * @param uplink  true if measured by the peer for our TX, false for a packet we received
+   */
+  void addSample(int8_t snr_x4, bool uplink);
+
+  /**
+   * Re-evaluate the TX power against the SF's demodulation floor
+   * @return true if getTxPower() changed
+   */
+  bool update(uint8_t sf, uint8_t margin_db);
+
+  /**
+   * Account one wake's TX airtime at the current power (savings estimate, stale-link drift)
+   * @return true if getTxPower() changed
+   */
+  bool onTransmit(uint32_t air_ms);
+
+  int8_t getTxPower() const;
+  bool hasSamples() const;
+  float getLinkSNR() const;         // estimated SNR at full power, dB
+  float getSavedMilliAh() const;    // TX charge saved against always using full power
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <MeshCore.h>
+
+/**
+ * Compile-time RAM profile
+ *
+ * A sleeping sensor sends a few packets per wake and never forwards (allowPacketForward() is
+ * false), so it needs a fraction of the packet pool and duplicate tables MeshCore sizes for a
+ * repeater. The SRAM saved goes to retained state instead: the compact telemetry batch holds a
+ * full MAX_BATCH_WAKES batch (sent as several frames), and the boot snapshot keeps the whole
+ * ACL. -D SENSOR_MEM_PROFILE=MEM_PROFILE_REPEATER restores MeshCore's sizes.
+ *
+ * Worst-case packets in the pool during a wake (sleeping profile):
+ *   telemetry frames of one compact batch (~4) + advert + DISCOVER_WAKE_BUDGET responses
+ *   + request/login replies (2) + link probe + packets being received (2)
+ * The pool is heap-allocated by StaticPoolPacketManager, about 260 bytes per packet.
+ * The memory_budget.py post-build step reports the static RAM/flash and retained RAM this adds
+ * up to.
+ */
+#define MEM_PROFILE_SLEEPING   0
+#define MEM_PROFILE_REPEATER   1
+
+#ifndef SENSOR_MEM_PROFILE
+  #define SENSOR_MEM_PROFILE   MEM_PROFILE_SLEEPING
+#endif
+
+#if SENSOR_MEM_PROFILE == MEM_PROFILE_SLEEPING
+  #ifndef SENSOR_PACKET_POOL_SIZE
+    #define SENSOR_PACKET_POOL_SIZE   16
+  #endif
+  #ifndef SENSOR_SEEN_HASHES
+    #define SENSOR_SEEN_HASHES        32    // recent packet hashes (flood/direct duplicates)
+  #endif
+  #ifndef SENSOR_SEEN_ACKS
+    #define SENSOR_SEEN_ACKS          16
+  #endif
+  #ifndef TELEM_BATCH_BUF_SIZE
+    #define TELEM_BATCH_BUF_SIZE      (4 * MAX_PACKET_PAYLOAD)   // compact batches only, see getBatchCapacity()
+  #endif
+#else
+  #ifndef SENSOR_PACKET_POOL_SIZE
+    #define SENSOR_PACKET_POOL_SIZE   32
+  #endif
+  #ifndef SENSOR_SEEN_HASHES
+    #define SENSOR_SEEN_HASHES        128
+  #endif
+  #ifndef SENSOR_SEEN_ACKS
+    #define SENSOR_SEEN_ACKS          64
+  #endif
+  #ifndef TELEM_BATCH_BUF_SIZE
+    #define TELEM_BATCH_BUF_SIZE      MAX_PACKET_PAYLOAD
+  #endif
+#endif
+
+static_assert(SENSOR_PACKET_POOL_SIZE >= 8, "packet pool too small for one wake's TX and RX");
+static_assert(TELEM_BATCH_BUF_SIZE >= MAX_PACKET_PAYLOAD, "telemetry batch must hold one packet body");
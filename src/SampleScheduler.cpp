@@ -0,0 +1,172 @@
+#include "SampleScheduler.h"
+#include "LPPUtils.h"
+#include <LogLevel.h>
+
+static const char* const reducer_names[REDUCE_NUM] = { "mean", "median", "min", "max" };
+
+const char* getReducerName(uint8_t reducer) {
+  return reducer < REDUCE_NUM ? reducer_names[reducer] : "?";
+}
+
+int parseReducer(const char* name) {
+  for (int i = 0; i < REDUCE_NUM; i++) {
+    if (strcmp(name, reducer_names[i]) == 0) return i;
+  }
+  return -1;
+}
+
+bool isValidSampleSchedule(uint32_t count, uint32_t spacing_ms, uint32_t warmup_ms) {
+  if (count < 1 || count > SAMPLE_MAX_COUNT) return false;
+  return warmup_ms + (count - 1) * spacing_ms <= SAMPLE_WINDOW_MAX_MS;
+}
+
+bool SampleScheduler::addChannel(uint8_t channel, uint8_t lpp_type, SampleReadFn read, void* ctx,
+                                 uint8_t count, uint16_t spacing_ms, uint16_t warmup_ms, uint8_t reducer) {
+  if (_num_channels >= SAMPLE_MAX_CHANNELS) return false;
+
+  Channel& c = _channels[_num_channels++];
+  memset(&c, 0, sizeof(c));
+  c.lpp_type = lpp_type;
+  c.read = read;
+  c.ctx = ctx;
+  c.declared.channel = channel;
+  c.declared.count = count > SAMPLE_MAX_COUNT ? SAMPLE_MAX_COUNT : count;
+  c.declared.reducer = reducer < REDUCE_NUM ? reducer : (uint8_t)REDUCE_MEAN;
+  c.declared.warmup_ms = warmup_ms;
+  c.declared.spacing_ms = spacing_ms;
+  c.sched = c.declared;
+  return true;
+}
+
+void SampleScheduler::configure(uint8_t default_count, uint16_t default_spacing_ms, const SampleSchedule* overrides, int num_overrides) {
+  for (int i = 0; i < _num_channels; i++) {
+    Channel& c = _channels[i];
+    c.sched = c.declared;
+    if (c.sched.count == 0) {
+      c.sched.count = default_count;
+      c.sched.spacing_ms = default_spacing_ms;
+    }
+    for (int o = 0; o < num_overrides; o++) {
+      if (overrides[o].channel != 0 && overrides[o].channel == c.declared.channel) {
+        c.sched = overrides[o];
+        break;
+      }
+    }
+    c.sched.count = constrain(c.sched.count, 1, SAMPLE_MAX_COUNT);
+  }
+}
+
+void SampleScheduler::restrictTo(const uint8_t* channels, int n) {
+  for (int i = 0; i < _num_channels; i++) {
+    bool keep = false;
+    for (int k = 0; k < n && !keep; k++) keep = channels[k] == _channels[i].declared.channel;
+    if (!keep) _channels[i].sched.count = 0;   // done without a sample, not reported
+  }
+}
+
+bool SampleScheduler::hasChannel(uint8_t channel) const {
+  for (int i = 0; i < _num_channels; i++) {
+    if (_channels[i].declared.channel == channel) return true;
+  }
+  return false;
+}
+
+void SampleScheduler::start(uint32_t now) {
+  _start = now;
+  for (int i = 0; i < _num_channels; i++) {
+    _channels[i].taken = 0;
+    _channels[i].next_due = now + _channels[i].sched.warmup_ms;
+  }
+  _running = true;
+}
+
+bool SampleScheduler::isDone() const {
+  for (int i = 0; i < _num_channels; i++) {
+    if (_channels[i].taken < _channels[i].sched.count) return false;
+  }
+  return true;
+}
+
+int SampleScheduler::poll(uint32_t now) {
+  int n = 0;
+  for (int i = 0; i < _num_channels; i++) {
+    Channel& c = _channels[i];
+    if (c.taken >= c.sched.count || (int32_t)(now - c.next_due) < 0) continue;
+
+    c.samples[c.taken++] = c.read(c.ctx);
+    c.next_due += c.sched.spacing_ms;   // on the grid, a late sample does not push the rest back
+    n++;
+    LOG_DEBUG("Sample ch%d %d/%d: %.3f", c.sched.channel, c.taken, c.sched.count, c.samples[c.taken - 1]);
+  }
+  return n;
+}
+
+uint32_t SampleScheduler::getNextDue() const {
+  uint32_t next = 0;
+  bool found = false;
+  for (int i = 0; i < _num_channels; i++) {
+    const Channel& c = _channels[i];
+    if (c.taken >= c.sched.count) continue;
+    if (!found || (int32_t)(c.next_due - next) < 0) next = c.next_due;
+    found = true;
+  }
+  return found ? next : _start;
+}
+
+uint32_t SampleScheduler::getWindowMillis() const {
+  uint32_t window = 0;
+  for (int i = 0; i < _num_channels; i++) {
+    const SampleSchedule& s = _channels[i].sched;
+    if (s.count == 0) continue;
+    uint32_t w = s.warmup_ms + (uint32_t)(s.count - 1) * s.spacing_ms;
+    if (w > window) window = w;
+  }
+  return window;
+}
+
+float SampleScheduler::reduce(const Channel& c) const {
+  if (c.taken == 0) return 0.0f;
+
+  float v = c.samples[0];
+  switch (c.sched.reducer) {
+    case REDUCE_MEDIAN: {
+      float sorted[SAMPLE_MAX_COUNT];
+      for (int i = 0; i < c.taken; i++) {   // insertion sort, at most SAMPLE_MAX_COUNT values
+        int j = i;
+        for (; j > 0 && sorted[j - 1] > c.samples[i]; j--) sorted[j] = sorted[j - 1];
+        sorted[j] = c.samples[i];
+      }
+      int mid = c.taken / 2;
+      return (c.taken & 1) ? sorted[mid] : (sorted[mid - 1] + sorted[mid]) / 2.0f;
+    }
+    case REDUCE_MIN:
+      for (int i = 1; i < c.taken; i++) if (c.samples[i] < v) v = c.samples[i];
+      return v;
+    case REDUCE_MAX:
+      for (int i = 1; i < c.taken; i++) if (c.samples[i] > v) v = c.samples[i];
+      return v;
+    default:
+      for (int i = 1; i < c.taken; i++) v += c.samples[i];
+      return v / c.taken;
+  }
+}
+
+bool SampleScheduler::getValue(uint8_t channel, float& value) const {
+  for (int i = 0; i < _num_channels; i++) {
+    if (_channels[i].declared.channel == channel && _channels[i].taken > 0) {
+      value = reduce(_channels[i]);
+      return true;
+    }
+  }
+  return false;
+}
+
+void SampleScheduler::addTelemetry(CayenneLPP& lpp) const {
+  for (int i = 0; i < _num_channels; i++) {
+    const Channel& c = _channels[i];
+    if (c.taken == 0) continue;
+    if (!addLPPValue(lpp, c.declared.channel, c.lpp_type, reduce(c))) {
+      LOG_WARN("Sample ch%d: not added (LPP type %d unsupported or reading full)", c.declared.channel, c.lpp_type);
+    }
+  }
+}
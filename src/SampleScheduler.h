@@ -0,0 +1,95 @@
+#pragma once
+
+#include <Arduino.h>
+#include <CayenneLPP.h>
+
+/**
+ * Table-driven sampling for the SAMPLING state
+ *
+ * Each channel declares its own warm-up, sample count, spacing and reducer. All channels run
+ * concurrently from the start of SAMPLING, so the awake window is the slowest channel's
+ * warm-up + (count - 1) x spacing, not the sum over channels. A one-shot temperature channel
+ * finishes on the first poll while a distance burst takes its samples in between.
+ *
+ * A channel declared with count 0 follows the default schedule from the prefs (samples_per_wake
+ * x sample_spacing_ms); per-channel overrides from the prefs ("sample ch") replace either.
+ */
+#ifndef SAMPLE_MAX_CHANNELS
+  #define SAMPLE_MAX_CHANNELS   6
+#endif
+#define SAMPLE_MAX_COUNT        16
+#define SAMPLE_MAX_OVERRIDES    4
+#define SAMPLE_WINDOW_MAX_MS    30000   // warm-up + spacing of one channel, well inside the max awake time
+
+enum SampleReducer : uint8_t {
+  REDUCE_MEAN,
+  REDUCE_MEDIAN,
+  REDUCE_MIN,
+  REDUCE_MAX,
+  REDUCE_NUM
+};
+
+const char* getReducerName(uint8_t reducer);
+int parseReducer(const char* name);   // -1 if unknown
+
+// count 1-SAMPLE_MAX_COUNT and the whole schedule within SAMPLE_WINDOW_MAX_MS
+bool isValidSampleSchedule(uint32_t count, uint32_t spacing_ms, uint32_t warmup_ms);
+
+// Schedule of one LPP channel (also the prefs override format, channel 0 = unused slot)
+struct SampleSchedule {
+  uint8_t channel;
+  uint8_t count;          // samples per wake (1-SAMPLE_MAX_COUNT), 0 = default schedule
+  uint8_t reducer;        // SampleReducer
+  uint16_t warmup_ms;     // from the start of SAMPLING to the first sample
+  uint16_t spacing_ms;    // between samples
+};
+
+typedef float (*SampleReadFn)(void* ctx);
+
+class SampleScheduler {
+public:
+  SampleScheduler() : _num_channels(0), _running(false) { }
+
+  /**
+   * Declare a channel, reported as one value of lpp_type (scalar LPP types only)
+   * @return false when all SAMPLE_MAX_CHANNELS are used
+   */
+  bool addChannel(uint8_t channel, uint8_t lpp_type, SampleReadFn read, void* ctx = NULL,
+                  uint8_t count = 0, uint16_t spacing_ms = 0, uint16_t warmup_ms = 0, uint8_t reducer = REDUCE_MEAN);
+
+  // Resolve this wake's schedules: defaults for count 0 channels, then prefs overrides
+  void configure(uint8_t default_count, uint16_t default_spacing_ms, const SampleSchedule* overrides, int num_overrides);
+  void restrictTo(const uint8_t* channels, int n);   // after configure(): sample only these this wake (event wake)
+  bool hasChannel(uint8_t channel) const;
+
+  void start(uint32_t now);   // start of SAMPLING, every channel restarts
+  void reset() { _running = false; }
+  bool isRunning() const { return _running; }
+  bool isDone() const;
+
+  int poll(uint32_t now);          // take every due sample, returns the number taken
+  uint32_t getNextDue() const;     // millis() the next sample is due (while not done)
+  uint32_t getWindowMillis() const;
+
+  bool getValue(uint8_t channel, float& value) const;   // reduced value of the samples taken
+  void addTelemetry(CayenneLPP& lpp) const;              // every channel with samples, as its LPP type
+
+private:
+  struct Channel {
+    uint8_t lpp_type;
+    SampleReadFn read;
+    void* ctx;
+    SampleSchedule declared;
+    SampleSchedule sched;      // effective this wake
+    uint8_t taken;
+    uint32_t next_due;
+    float samples[SAMPLE_MAX_COUNT];
+  };
+
+  float reduce(const Channel& c) const;
+
+  Channel _channels[SAMPLE_MAX_CHANNELS];
+  uint8_t _num_channels;
+  bool _running;
+  uint32_t _start;
+};
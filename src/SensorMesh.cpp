@@ -1,4 +1,8 @@
 #include "SensorMesh.h"
+#include "LPPUtils.h"
+#include "CompactTelemetry.h"
+#include "WakeSchedule.h"
+#include "FSUtils.h"
 #include <SHA256.h>
 #include <base64.hpp>
 
@@ -6,23 +10,50 @@
 
 // Implementation of ExtendedPrefsSerializer for SensorExtendedPrefs
 bool ExtendedPrefsSerializer<SensorExtendedPrefs>::save(FILESYSTEM* fs, const SensorExtendedPrefs& prefs, const char* filename) {
-  #if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
-    fs->remove(filename);
-    File file = fs->open(filename, FILE_O_WRITE);
-  #elif defined(RP2040_PLATFORM)
-    File file = fs->open(filename, "w");
-  #else
-    File file = fs->open(filename, "w", true);
-  #endif
+  File file = openTruncate(fs, filename);
 
   if (!file) return false;
 
-  // Write fields with explicit ordering (84 bytes total)
-  file.write((uint8_t*)&prefs.sleep_interval_secs, sizeof(prefs.sleep_interval_secs));  // 0-1
+  // Write fields with explicit ordering (84 bytes original layout, appended fields follow)
+  uint16_t interval_lo = prefs.sleep_interval_secs & 0xFFFF;
+  uint16_t interval_hi = prefs.sleep_interval_secs >> 16;
+  file.write((uint8_t*)&interval_lo, sizeof(interval_lo));                              // 0-1
   file.write((uint8_t*)&prefs.wakeups_per_advert, sizeof(prefs.wakeups_per_advert));    // 2
   file.write((uint8_t*)&prefs._pad, 1);                                                  // 3 (padding)
   file.write((uint8_t*)&prefs.broadcast_zone_name, sizeof(prefs.broadcast_zone_name));  // 4-35
   file.write((uint8_t*)&prefs.private_channel_psk, sizeof(prefs.private_channel_psk));  // 36-83
+  file.write((uint8_t*)&prefs.batch_wakes, sizeof(prefs.batch_wakes));                  // 84
+  file.write((uint8_t*)&prefs.heartbeat_wakes, sizeof(prefs.heartbeat_wakes));          // 85
+  for (int i = 0; i < MAX_DEADBANDS; i++) {                                              // 86-125
+    file.write((uint8_t*)&prefs.deadbands[i].channel, sizeof(prefs.deadbands[i].channel));
+    file.write((uint8_t*)&prefs.deadbands[i].threshold, sizeof(prefs.deadbands[i].threshold));
+  }
+  file.write((uint8_t*)&prefs.lazy_radio, sizeof(prefs.lazy_radio));                    // 126
+  file.write((uint8_t*)&prefs.stats_window_mins, sizeof(prefs.stats_window_mins));      // 127-128
+  file.write((uint8_t*)&prefs.telemetry_log, sizeof(prefs.telemetry_log));              // 129
+  file.write((uint8_t*)&prefs.energy_telemetry, sizeof(prefs.energy_telemetry));        // 130
+  file.write((uint8_t*)&prefs.sensor_presence, sizeof(prefs.sensor_presence));          // 131-134
+  file.write((uint8_t*)&interval_hi, sizeof(interval_hi));                              // 135-136
+  file.write((uint8_t*)&prefs.tx_slotting, sizeof(prefs.tx_slotting));                  // 137
+  file.write((uint8_t*)&prefs.slot_width_secs, sizeof(prefs.slot_width_secs));          // 138-139
+  file.write((uint8_t*)&prefs.listen_every, sizeof(prefs.listen_every));                // 140
+  file.write((uint8_t*)&prefs.listen_window_ms, sizeof(prefs.listen_window_ms));        // 141-142
+  file.write((uint8_t*)&prefs.telemetry_format, sizeof(prefs.telemetry_format));        // 143
+  file.write((uint8_t*)&prefs.link_adapt, sizeof(prefs.link_adapt));                    // 144
+  file.write((uint8_t*)&prefs.link_margin_db, sizeof(prefs.link_margin_db));            // 145
+  file.write((uint8_t*)&prefs.samples_per_wake, sizeof(prefs.samples_per_wake));        // 146
+  file.write((uint8_t*)&prefs.sample_spacing_ms, sizeof(prefs.sample_spacing_ms));      // 147-148
+  for (int i = 0; i < SAMPLE_MAX_OVERRIDES; i++) {                                       // 149-176
+    const SampleSchedule& e = prefs.sample_schedules[i];
+    file.write(&e.channel, 1);
+    file.write(&e.count, 1);
+    file.write(&e.reducer, 1);
+    file.write((uint8_t*)&e.warmup_ms, sizeof(e.warmup_ms));
+    file.write((uint8_t*)&e.spacing_ms, sizeof(e.spacing_ms));
+  }
+  file.write((uint8_t*)&prefs.gps_fix_wakes, sizeof(prefs.gps_fix_wakes));              // 177
+  file.write((uint8_t*)&prefs.gps_fix_secs, sizeof(prefs.gps_fix_secs));                // 178
+  file.write((uint8_t*)&prefs.event_wake, sizeof(prefs.event_wake));                    // 179
 
   file.close();
   return true;
@@ -34,30 +65,232 @@ bool ExtendedPrefsSerializer<SensorExtendedPrefs>::load(FILESYSTEM* fs, SensorEx
     return false;
   }
 
-  #if defined(RP2040_PLATFORM)
-    File file = fs->open(filename, "r");
-  #else
-    File file = fs->open(filename);
-  #endif
+  File file = openRead(fs, filename);
 
   if (!file) return false;
 
   // Read fields in same order as save
-  file.read((uint8_t*)&prefs.sleep_interval_secs, sizeof(prefs.sleep_interval_secs));
+  uint16_t w;
+  if (file.read((uint8_t*)&w, sizeof(w)) == sizeof(w)) prefs.sleep_interval_secs = w;
   file.read((uint8_t*)&prefs.wakeups_per_advert, sizeof(prefs.wakeups_per_advert));
   uint8_t pad;
   file.read(&pad, 1);  // padding
   file.read((uint8_t*)&prefs.broadcast_zone_name, sizeof(prefs.broadcast_zone_name));
   file.read((uint8_t*)&prefs.private_channel_psk, sizeof(prefs.private_channel_psk));
 
+  // Appended fields: a short read (file from older firmware) leaves the constructor default
+  uint8_t b;
+  if (file.read(&b, 1) == 1) prefs.batch_wakes = b;
+  if (file.read(&b, 1) == 1) prefs.heartbeat_wakes = b;
+  for (int i = 0; i < MAX_DEADBANDS; i++) {
+    DeadbandEntry e;
+    if (file.read(&e.channel, sizeof(e.channel)) != sizeof(e.channel)) break;
+    if (file.read((uint8_t*)&e.threshold, sizeof(e.threshold)) != sizeof(e.threshold)) break;
+    if (!(e.threshold >= 0.0f)) e.channel = 0;   // drop NaN/negative entries
+    prefs.deadbands[i] = e;
+  }
+  if (file.read(&b, 1) == 1) prefs.lazy_radio = b ? 1 : 0;
+  if (file.read((uint8_t*)&w, sizeof(w)) == sizeof(w)) prefs.stats_window_mins = w;
+  if (file.read(&b, 1) == 1) prefs.telemetry_log = b ? 1 : 0;
+  if (file.read(&b, 1) == 1) prefs.energy_telemetry = b ? 1 : 0;
+  uint32_t d;
+  if (file.read((uint8_t*)&d, sizeof(d)) == sizeof(d)) prefs.sensor_presence = d;
+  if (file.read((uint8_t*)&w, sizeof(w)) == sizeof(w)) prefs.sleep_interval_secs |= (uint32_t)w << 16;
+  if (file.read(&b, 1) == 1) prefs.tx_slotting = b ? 1 : 0;
+  if (file.read((uint8_t*)&w, sizeof(w)) == sizeof(w)) prefs.slot_width_secs = w;
+  if (file.read(&b, 1) == 1) prefs.listen_every = b;
+  if (file.read((uint8_t*)&w, sizeof(w)) == sizeof(w)) prefs.listen_window_ms = w;
+  if (file.read(&b, 1) == 1) prefs.telemetry_format = b == TELEM_SCHEMA_COMPACT ? TELEM_SCHEMA_COMPACT : TELEM_SCHEMA_LPP;
+  if (file.read(&b, 1) == 1) prefs.link_adapt = b ? 1 : 0;
+  if (file.read(&b, 1) == 1) prefs.link_margin_db = b;
+  if (file.read(&b, 1) == 1) prefs.samples_per_wake = b;
+  if (file.read((uint8_t*)&w, sizeof(w)) == sizeof(w)) prefs.sample_spacing_ms = w;
+  for (int i = 0; i < SAMPLE_MAX_OVERRIDES; i++) {
+    SampleSchedule e;
+    if (file.read(&e.channel, 1) != 1 || file.read(&e.count, 1) != 1 || file.read(&e.reducer, 1) != 1) break;
+    if (file.read((uint8_t*)&e.warmup_ms, sizeof(e.warmup_ms)) != sizeof(e.warmup_ms)) break;
+    if (file.read((uint8_t*)&e.spacing_ms, sizeof(e.spacing_ms)) != sizeof(e.spacing_ms)) break;
+    if (!isValidSampleSchedule(e.count, e.spacing_ms, e.warmup_ms) || e.reducer >= REDUCE_NUM) e.channel = 0;
+    prefs.sample_schedules[i] = e;
+  }
+  if (file.read(&b, 1) == 1) prefs.gps_fix_wakes = b;
+  if (file.read(&b, 1) == 1) prefs.gps_fix_secs = b;
+  if (file.read(&b, 1) == 1) prefs.event_wake = b ? 1 : 0;
+
   // Sanitize values to valid ranges
-  prefs.sleep_interval_secs = constrain(prefs.sleep_interval_secs, 60, 3600);
+  prefs.sleep_interval_secs = constrain(prefs.sleep_interval_secs, SLEEP_INTERVAL_MIN_SECS, SLEEP_INTERVAL_MAX_SECS);
   prefs.wakeups_per_advert = constrain(prefs.wakeups_per_advert, 1, 255);
+  prefs.batch_wakes = constrain(prefs.batch_wakes, 1, MAX_BATCH_WAKES);
+  prefs.heartbeat_wakes = constrain(prefs.heartbeat_wakes, 1, 255);
+  prefs.stats_window_mins = constrain(prefs.stats_window_mins, 1, 1440);
+  prefs.listen_window_ms = constrain(prefs.listen_window_ms, LISTEN_WINDOW_MIN_MS, LISTEN_WINDOW_MAX_MS);
+  prefs.link_margin_db = constrain(prefs.link_margin_db, 0, LINK_MARGIN_MAX_DB);
+  prefs.gps_fix_secs = constrain(prefs.gps_fix_secs, 1, GPS_FIX_MAX_SECS);
+  if (!isValidSampleSchedule(prefs.samples_per_wake, prefs.sample_spacing_ms, 0)) {
+    prefs.samples_per_wake = 5;
+    prefs.sample_spacing_ms = 1000;
+  }
 
   file.close();
   return true;
 }
 
+/* ------------------------------ Boot Snapshot -------------------------------- */
+
+// Warm-wake copy of everything begin() would otherwise read from InternalFS or re-derive
+// (SHA256 zone key, base64 PSK decode). Kept in retained RAM across system-off and
+// invalidated whenever prefs, ACL or identity are written to flash.
+// Non-trivial MeshCore types are stored as raw bytes (see RetainedBlock).
+struct BootSnapshot {
+  NodePrefs prefs;
+  SensorExtendedPrefs ext_prefs;
+  uint8_t identity[PRV_KEY_SIZE + PUB_KEY_SIZE];
+  uint8_t zone_key[sizeof(TransportKey)];
+  char zone_name[32];
+  uint8_t channel[sizeof(mesh::GroupChannel)];
+  uint8_t channel_enabled;
+  uint8_t num_clients;
+  uint8_t clients[MAX_CLIENTS][sizeof(ClientInfo)];
+};
+
+#define BOOT_SNAPSHOT_MAGIC   0x50414E53   // 'SNAP'
+
+static RETAINED_RAM RetainedBlock<BootSnapshot, BOOT_SNAPSHOT_MAGIC> boot_snapshot;
+
+bool SensorMesh::restoreBootSnapshot() {
+  boot_snapshot.retain();
+  if (!boot_snapshot.isValid()) {
+    LOG_DEBUG("No valid boot snapshot, cold boot");
+    return false;
+  }
+
+  const BootSnapshot& snap = boot_snapshot.data;
+  memcpy(&_prefs, &snap.prefs, sizeof(_prefs));
+  memcpy(&_extended_prefs, &snap.ext_prefs, sizeof(_extended_prefs));
+  self_id.readFrom(snap.identity, sizeof(snap.identity));
+  memcpy(&broadcast_zone, snap.zone_key, sizeof(broadcast_zone));
+  memcpy(zone_name, snap.zone_name, sizeof(zone_name));
+  memcpy(&private_channel, snap.channel, sizeof(private_channel));
+  private_channel_enabled = snap.channel_enabled != 0;
+
+  for (int i = 0; i < snap.num_clients && i < MAX_CLIENTS; i++) {
+    ClientInfo saved;
+    memcpy(&saved, snap.clients[i], sizeof(saved));
+    ClientInfo* c = acl.putClient(saved.id, saved.permissions);
+    if (c) *c = saved;
+  }
+
+  _warm_boot = true;
+  LOG_DEBUG("Boot snapshot restored (%d ACL entries)", snap.num_clients);
+  return true;
+}
+
+void SensorMesh::saveBootSnapshot() {
+  BootSnapshot& snap = boot_snapshot.data;
+  memcpy(&snap.prefs, &_prefs, sizeof(snap.prefs));
+  memcpy(&snap.ext_prefs, &_extended_prefs, sizeof(snap.ext_prefs));
+  self_id.writeTo(snap.identity, sizeof(snap.identity));
+  memcpy(snap.zone_key, &broadcast_zone, sizeof(snap.zone_key));
+  memcpy(snap.zone_name, zone_name, sizeof(snap.zone_name));
+  memcpy(snap.channel, &private_channel, sizeof(snap.channel));
+  snap.channel_enabled = private_channel_enabled ? 1 : 0;
+
+  int n = min(acl.getNumClients(), MAX_CLIENTS);
+  for (int i = 0; i < n; i++) {
+    memcpy(snap.clients[i], acl.getClientByIdx(i), sizeof(ClientInfo));
+  }
+  snap.num_clients = n;
+
+  boot_snapshot.commit();
+}
+
+void SensorMesh::invalidateBootSnapshot() {
+  boot_snapshot.invalidate();
+}
+
+/* ------------------------------ Config Persistence -------------------------------- */
+
+// What the base files plus journal on flash currently hold, so a flush only journals the bytes
+// that changed. Kept with the pending-change flags in retained RAM across system-off; until
+// the flush the boot snapshot carries the new config.
+struct PersistedConfig {
+  uint8_t dirty;            // CFG_DIRTY_*
+  uint32_t dirty_clients;   // ACL slots to journal
+  NodePrefs prefs;
+  SensorExtendedPrefs ext_prefs;
+};
+
+#define PERSISTED_CONFIG_MAGIC   0x53474643   // 'CFGS'
+
+#define CFG_DIRTY_PREFS      0x01
+#define CFG_DIRTY_ACL        0x02   // entries added/removed: needs a full rewrite
+
+#define CFG_REC_PREFS        1      // NodePrefs bytes
+#define CFG_REC_EXT_PREFS    2      // SensorExtendedPrefs bytes
+#define CFG_REC_CLIENT       3      // whole ClientInfo, replaces the entry with the same pub key
+
+#define CFG_JOURNAL_LAYOUT   (((uint32_t)sizeof(NodePrefs) << 20) ^ ((uint32_t)sizeof(SensorExtendedPrefs) << 10) ^ sizeof(ClientInfo))
+
+static RETAINED_RAM RetainedBlock<PersistedConfig, PERSISTED_CONFIG_MAGIC> persisted_config;
+
+void SensorMesh::markConfigPersisted() {
+  PersistedConfig& pc = persisted_config.data;
+  pc.dirty = 0;
+  pc.dirty_clients = 0;
+  memcpy(&pc.prefs, &_prefs, sizeof(pc.prefs));
+  memcpy(&pc.ext_prefs, &_extended_prefs, sizeof(pc.ext_prefs));
+  persisted_config.commit();
+}
+
+void SensorMesh::applyJournalRecord(void* ctx, uint8_t kind, uint16_t offset, const uint8_t* data, uint16_t len) {
+  SensorMesh* self = (SensorMesh*) ctx;
+  if (kind == CFG_REC_PREFS && offset + len <= sizeof(self->_prefs)) {
+    memcpy((uint8_t*)&self->_prefs + offset, data, len);
+  } else if (kind == CFG_REC_EXT_PREFS && offset + len <= sizeof(self->_extended_prefs)) {
+    memcpy((uint8_t*)&self->_extended_prefs + offset, data, len);
+  } else if (kind == CFG_REC_CLIENT && len == sizeof(ClientInfo)) {
+    ClientInfo saved;
+    memcpy(&saved, data, sizeof(saved));
+    ClientInfo* c = self->acl.putClient(saved.id, saved.permissions);
+    if (c) *c = saved;
+  }
+}
+
+void SensorMesh::compactConfig() {
+  ensureFS();
+  _cli.savePrefs(_fs);  // Save core prefs
+  ExtendedPrefsSerializer<SensorExtendedPrefs>::save(_fs, _extended_prefs);  // Save extended prefs
+  acl.save(_fs);
+  _journal.clear();
+  markConfigPersisted();
+  LOG_DEBUG("Config compacted: prefs and ACL rewritten, journal cleared");
+}
+
+void SensorMesh::flushConfig() {
+  PersistedConfig& pc = persisted_config.data;
+  if (pc.dirty == 0 && pc.dirty_clients == 0) return;
+
+  ensureFS();
+  bool journaled = (pc.dirty & CFG_DIRTY_ACL) == 0;
+  if (journaled && (pc.dirty & CFG_DIRTY_PREFS)) {
+    journaled = _journal.appendDiff(CFG_REC_PREFS, &pc.prefs, &_prefs, sizeof(_prefs)) &&
+        _journal.appendDiff(CFG_REC_EXT_PREFS, &pc.ext_prefs, &_extended_prefs, sizeof(_extended_prefs));
+  }
+  for (int i = 0; journaled && i < acl.getNumClients() && i < 32; i++) {
+    if (pc.dirty_clients & (1UL << i)) {
+      journaled = _journal.append(CFG_REC_CLIENT, 0, acl.getClientByIdx(i), sizeof(ClientInfo));
+    }
+  }
+
+  if (journaled) {
+    markConfigPersisted();
+    LOG_DEBUG("Config journaled (%lu bytes)", (unsigned long)_journal.getSize());
+  } else {
+    compactConfig();   // journal full, or a change it cannot express
+  }
+  TRACE(TRACE_CONFIG_FLUSH, journaled ? 1 : 2, _journal.getSize());
+}
+
 /* ------------------------------ Config -------------------------------- */
 
 #ifndef LORA_FREQ
@@ -108,120 +341,346 @@ bool ExtendedPrefsSerializer<SensorExtendedPrefs>::load(FILESYSTEM* fs, SensorEx
 #define REQ_TYPE_GET_TELEMETRY_DATA  0x03
 #define REQ_TYPE_GET_AVG_MIN_MAX     0x04
 #define REQ_TYPE_GET_ACCESS_LIST     0x05
+#define REQ_TYPE_GET_LOG_DATA        0x10   // sensor-specific: ring log records after a timestamp cursor
+
+#define LOG_DATA_FLAG_MORE           0x01
+
+// Largest datagram plaintext for a direct response (dest/src hashes + MAC, whole AES blocks)
+#define MAX_RESPONSE_DATA_LEN  (((MAX_PACKET_PAYLOAD - 2*PATH_HASH_SIZE - CIPHER_MAC_SIZE) / CIPHER_BLOCK_SIZE) * CIPHER_BLOCK_SIZE)
 
 #define RESP_SERVER_LOGIN_OK      0   // response to ANON_REQ
 
 #define CLI_REPLY_DELAY_MILLIS  1000
+#define CLI_BATCH_SUMMARY_LEN   20    // room kept for "\n+NN more, NN Err" when results overflow the reply
 
-static File openAppend(FILESYSTEM* _fs, const char* fname) {
-  #if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
-    return _fs->open(fname, FILE_O_WRITE);
-  #elif defined(RP2040_PLATFORM)
-    return _fs->open(fname, "a");
-  #else
-    return _fs->open(fname, "a", true);
+static void mountFileSystem(FILESYSTEM* fs) {
+  #if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM) || defined(RP2040_PLATFORM)
+    fs->begin();
+  #elif defined(ESP32)
+    fs->begin(true);
   #endif
 }
 
-static uint8_t getDataSize(uint8_t type) {
-    switch (type) {
-      case LPP_GPS:
-        return 9;
-      case LPP_POLYLINE:
-        return 8;  // TODO: this is MINIMIUM
-      case LPP_GYROMETER:
-      case LPP_ACCELEROMETER:
-        return 6;
-      case LPP_GENERIC_SENSOR:
-      case LPP_FREQUENCY:
-      case LPP_DISTANCE:
-      case LPP_ENERGY:
-      case LPP_UNIXTIME:
-        return 4;
-      case LPP_COLOUR:
-        return 3;
-      case LPP_ANALOG_INPUT:
-      case LPP_ANALOG_OUTPUT:
-      case LPP_LUMINOSITY:
-      case LPP_TEMPERATURE:
-      case LPP_CONCENTRATION:
-      case LPP_BAROMETRIC_PRESSURE:
-      case LPP_RELATIVE_HUMIDITY:
-      case LPP_ALTITUDE:
-      case LPP_VOLTAGE:
-      case LPP_CURRENT:
-      case LPP_DIRECTION:
-      case LPP_POWER:
-        return 2;
+/* ------------------------------ Send-on-delta -------------------------------- */
+
+// Last reported reading, kept across system-off so each wake compares against what the
+// network actually has rather than the previous (possibly suppressed) sample.
+struct DeltaBaseline {
+  uint8_t wakes_since_report;
+  uint8_t len;
+  uint8_t lpp[MAX_PACKET_PAYLOAD];
+};
+
+#define DELTA_BASELINE_MAGIC   0x544C4544   // 'DELT'
+
+static RETAINED_RAM RetainedBlock<DeltaBaseline, DELTA_BASELINE_MAGIC> delta_baseline;
+
+// Find channel/type in an LPP buffer, returns offset of the value bytes or -1
+static int findLPPValue(const uint8_t* buf, uint8_t len, uint8_t channel, uint8_t type) {
+  uint8_t i = 0;
+  while (i + 2 <= len) {
+    uint8_t ch = buf[i++];
+    uint8_t t = buf[i++];
+    if (ch == channel && t == type) return i;
+    i += getDataSize(t);
+  }
+  return -1;
+}
+
+static const DeadbandEntry* findDeadband(const SensorExtendedPrefs& prefs, uint8_t channel) {
+  for (int i = 0; i < MAX_DEADBANDS; i++) {
+    if (prefs.deadbands[i].channel != 0 && prefs.deadbands[i].channel == channel) return &prefs.deadbands[i];
+  }
+  return NULL;
+}
+
+static SampleSchedule* findSampleSchedule(SensorExtendedPrefs& prefs, uint8_t channel) {
+  for (int i = 0; i < SAMPLE_MAX_OVERRIDES; i++) {
+    if (prefs.sample_schedules[i].channel != 0 && prefs.sample_schedules[i].channel == channel) return &prefs.sample_schedules[i];
+  }
+  return NULL;
+}
+
+bool SensorMesh::shouldReportTelemetry(const uint8_t* lpp, uint8_t len) {
+  delta_baseline.retain();
+  if (_extended_prefs.heartbeat_wakes <= 1) return true;   // send-on-delta disabled
+  if (!delta_baseline.isValid()) return true;               // nothing reported since power-up
+
+  DeltaBaseline& base = delta_baseline.data;
+  if (base.wakes_since_report < 255) base.wakes_since_report++;
+  delta_baseline.commit();
+
+  if (base.wakes_since_report >= _extended_prefs.heartbeat_wakes) {
+    LOG_DEBUG("Send-on-delta: heartbeat due (%d wakes)", base.wakes_since_report);
+    return true;
+  }
+
+  // Channels without a deadband ride along with whatever triggers a report
+  uint8_t i = 0;
+  while (i + 2 <= len) {
+    uint8_t ch = lpp[i++];
+    uint8_t t = lpp[i++];
+    uint8_t sz = getDataSize(t);
+    const DeadbandEntry* db = findDeadband(_extended_prefs, ch);
+
+    if (db) {
+      int prev = findLPPValue(base.lpp, base.len, ch, t);
+      if (prev < 0) {
+        LOG_DEBUG("Send-on-delta: channel %d new", ch);
+        return true;
+      }
+      uint8_t sizes[3];
+      uint32_t multipliers[3];
+      uint8_t n = getComponents(t, sizes, multipliers);
+      uint8_t off = 0;
+      for (uint8_t c = 0; c < n; c++) {
+        float now_v = getFloat(&lpp[i + off], sizes[c], multipliers[c], isSigned(t));
+        float prev_v = getFloat(&base.lpp[prev + off], sizes[c], multipliers[c], isSigned(t));
+        if (fabsf(now_v - prev_v) > db->threshold) {
+          LOG_DEBUG("Send-on-delta: channel %d moved %.3f (deadband %.3f)", ch, fabsf(now_v - prev_v), db->threshold);
+          return true;
+        }
+        off += sizes[c];
+      }
     }
-    return 1;
-}
-
-static uint32_t getMultiplier(uint8_t type) {
-    switch (type) {
-      case LPP_CURRENT:
-      case LPP_DISTANCE:
-      case LPP_ENERGY:
-        return 1000;
-      case LPP_VOLTAGE:
-      case LPP_ANALOG_INPUT:
-      case LPP_ANALOG_OUTPUT:
-        return 100;
-      case LPP_TEMPERATURE:
-      case LPP_BAROMETRIC_PRESSURE:
-      case LPP_RELATIVE_HUMIDITY:
-        return 10;
+    i += sz;
+  }
+
+  // A watched channel that disappeared (sensor lost) is also a change
+  for (int d = 0; d < MAX_DEADBANDS; d++) {
+    uint8_t ch = _extended_prefs.deadbands[d].channel;
+    if (ch == 0) continue;
+    bool in_now = false, in_prev = false;
+    for (uint8_t j = 0; j + 2 <= len; j += 2 + getDataSize(lpp[j + 1])) in_now |= lpp[j] == ch;
+    for (uint8_t j = 0; j + 2 <= base.len; j += 2 + getDataSize(base.lpp[j + 1])) in_prev |= base.lpp[j] == ch;
+    if (in_prev && !in_now) {
+      LOG_DEBUG("Send-on-delta: channel %d gone", ch);
+      return true;
     }
-    return 1;
+  }
+  return false;
+}
+
+void SensorMesh::onTelemetryReported(const uint8_t* lpp, uint8_t len) {
+  DeltaBaseline& base = delta_baseline.data;
+  if (len > sizeof(base.lpp)) len = sizeof(base.lpp);
+  base.wakes_since_report = 0;
+  base.len = len;
+  memcpy(base.lpp, lpp, len);
+  delta_baseline.commit();
 }
 
-static bool isSigned(uint8_t type) {
-  return type == LPP_ALTITUDE || type == LPP_TEMPERATURE || type == LPP_GYROMETER ||
-      type == LPP_ANALOG_INPUT || type == LPP_ANALOG_OUTPUT || type == LPP_GPS || type == LPP_ACCELEROMETER;
+/* ------------------------------ Downlink listen window -------------------------------- */
+
+struct ListenState {
+  uint8_t tx_since_listen;
+};
+
+#define LISTEN_STATE_MAGIC   0x4E54534C   // 'LSTN'
+
+static RETAINED_RAM RetainedBlock<ListenState, LISTEN_STATE_MAGIC> listen_state;
+
+bool SensorMesh::claimListenWindow() {
+  if (_extended_prefs.listen_every == 0) return false;
+
+  listen_state.retain();
+  if (!listen_state.isValid()) {
+    listen_state.data.tx_since_listen = _extended_prefs.listen_every - 1;   // first TX after power-up listens
+  }
+  bool listen = ++listen_state.data.tx_since_listen >= _extended_prefs.listen_every;
+  if (listen) listen_state.data.tx_since_listen = 0;
+  listen_state.commit();
+  return listen;
+}
+
+bool SensorMesh::takeListenWindow() {
+  bool pending = _listen_pending;
+  _listen_pending = false;
+  return pending;
 }
 
-static float getFloat(const uint8_t * buffer, uint8_t size, uint32_t multiplier, bool is_signed) {
-  uint32_t value = 0;
-  for (uint8_t i = 0; i < size; i++) {
-    value = (value << 8) + buffer[i];
+/* ------------------------------ Discover rate limiting -------------------------------- */
+
+struct DiscoverLimitState {
+  uint32_t tat;                               // bucket as GCRA: theoretical arrival time, RTC secs
+  uint32_t recent_tags[DISCOVER_TAG_HISTORY];
+  uint8_t next_tag;
+  uint32_t answered;
+  uint32_t dropped_dup;                       // tag already seen
+  uint32_t dropped_wake;                      // DISCOVER_WAKE_BUDGET used up
+  uint32_t dropped_rate;                      // bucket empty
+};
+
+#define DISCOVER_LIMIT_MAGIC   0x43534944   // 'DISC'
+
+static RETAINED_RAM RetainedBlock<DiscoverLimitState, DISCOVER_LIMIT_MAGIC> discover_limit;
+
+static DiscoverLimitState& discoverLimit() {
+  discover_limit.retain();
+  if (!discover_limit.isValid()) {
+    memset(&discover_limit.data, 0, sizeof(discover_limit.data));
+    discover_limit.commit();
   }
+  return discover_limit.data;
+}
 
-  int sign = 1;
-  if (is_signed) {
-    uint32_t bit = 1ul << ((size * 8) - 1);
-    if ((value & bit) == bit) {
-      value = (bit << 1) - value;
-      sign = -1;
+void SensorMesh::beginWake() {
+  _discover_replies = 0;
+  _listen_pending = false;
+  _tx_jitter_ms = -1;
+}
+
+bool SensorMesh::allowDiscoverReply(uint32_t tag, uint8_t cost) {
+  DiscoverLimitState& st = discoverLimit();
+
+  for (int i = 0; i < DISCOVER_TAG_HISTORY; i++) {
+    if (tag != 0 && st.recent_tags[i] == tag) {   // 0 = empty slot
+      st.dropped_dup++;
+      discover_limit.commit();
+      TRACE(TRACE_DISCOVER_DROP, 0, tag);
+      LOG_DEBUG("Discover: tag %08lX already seen, not answered", (unsigned long)tag);
+      return false;
+    }
+  }
+  st.recent_tags[st.next_tag] = tag;   // retries of a dropped request are not answered either
+  st.next_tag = (st.next_tag + 1) % DISCOVER_TAG_HISTORY;
+
+  bool allow = false;
+  if (_discover_replies >= DISCOVER_WAKE_BUDGET) {
+    st.dropped_wake++;
+  } else {
+    uint32_t now = getRTCClock()->getCurrentTime();
+    uint32_t limit = DISCOVER_BURST * DISCOVER_RATE_SECS;
+    if (st.tat > now + limit) st.tat = now;   // RTC was set backwards
+    uint32_t tat = max(st.tat, now) + cost * DISCOVER_RATE_SECS;
+    if (tat - now > limit) {
+      st.dropped_rate++;
+    } else {
+      st.tat = tat;
+      st.answered++;
+      _discover_replies++;
+      allow = true;
     }
   }
-  return sign * ((float) value / multiplier);
+  discover_limit.commit();
+  if (!allow) {
+    bool wake_budget = _discover_replies >= DISCOVER_WAKE_BUDGET;
+    LOG_DEBUG("Discover: %s, not answered", wake_budget ? "wake budget used" : "rate limited");
+    TRACE(TRACE_DISCOVER_DROP, wake_budget ? 1 : 2, tag);
+  }
+  return allow;
 }
 
-static uint8_t putFloat(uint8_t * dest, float value, uint8_t size, uint32_t multiplier, bool is_signed) {
-  // check sign
-  bool sign = value < 0;
-  if (sign) value = -value;
+/* ------------------------------ Telemetry ring log -------------------------------- */
+
+void SensorMesh::logTelemetry(uint32_t timestamp, const uint8_t* lpp, uint8_t len) {
+  if (!_extended_prefs.telemetry_log) return;
 
-  // get value to store
-  uint32_t v = value * multiplier;
+  // records collect in retained RAM, flash is only touched (and mounted) when the stage is full
+  if (!_log.fits(len)) {
+    ensureFS();
+    _log.flush();
+  }
+  _log.append(timestamp, lpp, len);
+}
 
-  // format an uint32_t as if it was an int32_t
-  if (is_signed & sign) {
-    uint32_t mask = (1 << (size * 8)) - 1;
-    v = v & mask;
-    if (sign) v = mask - v + 1;
+void SensorMesh::setLoggingOn(bool enable) {
+  if (!enable && _log.hasStaged()) {
+    ensureFS();
+    _log.flush();
   }
+  _extended_prefs.telemetry_log = enable ? 1 : 0;
+  savePrefs();
+}
+
+void SensorMesh::eraseLogFile() {
+  ensureFS();
+  _log.erase();
+  EventTrace::clear();
+}
+
+void SensorMesh::dumpLogFile() {
+  ensureFS();
+  _log.dump(Serial);
+  EventTrace::dump(Serial);
+}
+
+/* ------------------------------ Streaming stats -------------------------------- */
+
+void SensorMesh::recordTelemetry(const uint8_t* lpp, uint8_t len) {
+  uint32_t now = getRTCClock()->getCurrentTime();
+  uint8_t i = 0;
+  while (i + 2 <= len) {
+    uint8_t ch = lpp[i++];
+    uint8_t t = lpp[i++];
+    uint8_t sz = getDataSize(t);
+    if (i + sz > len) break;
 
-  // add bytes (MSB first)
-  for (uint8_t i=1; i<=size; i++) {
-    dest[size - i] = (v & 0xFF);
-    v >>= 8;
+    uint8_t sizes[3];
+    uint32_t multipliers[3];
+    if (getComponents(t, sizes, multipliers) == 1 && sz <= 4) {   // scalar types only (no GPS/accel/gyro)
+      _stats.add(ch, t, getFloat(&lpp[i], sz, multipliers[0], isSigned(t)), now);
+    }
+    i += sz;
   }
-  return size;
 }
 
 uint8_t SensorMesh::handleRequest(uint8_t perms, uint32_t sender_timestamp, uint8_t req_type, uint8_t* payload, size_t payload_len) {
   memcpy(reply_data, &sender_timestamp, 4);   // reflect sender_timestamp back in response packet (kind of like a 'tag')  
+  if (req_type == REQ_TYPE_GET_TELEMETRY_DATA) {  // allow all
+    uint8_t perm_mask = payload_len > 0 ? ~(payload[0]) : 0xFF;   // first reserved byte is an inverse mask to apply to permissions
+    telemetry.reset();
+    telemetry.addVoltage(TELEM_CHANNEL_SELF, (float)board.getBattMilliVolts() / 1000.0f);
+    sensors.querySensors((perms & perm_mask), telemetry);
+
+    uint8_t tlen = telemetry.getSize();
+    if (tlen > sizeof(reply_data) - 4) tlen = sizeof(reply_data) - 4;
+    memcpy(&reply_data[4], telemetry.getBuffer(), tlen);
+    return 4 + tlen;
+  }
+  if (req_type == REQ_TYPE_GET_AVG_MIN_MAX && (perms & PERM_ACL_ROLE_MASK) >= PERM_ACL_READ_ONLY) {
+    if (payload_len < 10) return 0;
+    uint32_t start_secs_ago, end_secs_ago;
+    memcpy(&start_secs_ago, &payload[0], 4);
+    memcpy(&end_secs_ago, &payload[4], 4);
+    uint8_t res1 = payload[8];   // reserved for future  (extra query params)
+    uint8_t res2 = payload[9];
+
+    StatsSummary data[STATS_MAX_CHANNELS];
+    uint32_t now = getRTCClock()->getCurrentTime();
+    int n = (res1 == 0 && res2 == 0) ? _stats.query(now, start_secs_ago, end_secs_ago, data, STATS_MAX_CHANNELS) : 0;
+
+    int budget = min((int)_reply_budget, (int)sizeof(reply_data));
+    uint8_t ofs = 4;
+    memcpy(&reply_data[ofs], &now, 4); ofs += 4;
+    for (int i = 0; i < n; i++) {
+      auto d = &data[i];
+      uint8_t sz = getDataSize(d->lpp_type);
+      if (ofs + 2 + 3*sz > budget) break;
+
+      reply_data[ofs++] = d->channel;
+      reply_data[ofs++] = d->lpp_type;
+      uint32_t mult = getMultiplier(d->lpp_type);
+      bool is_signed = isSigned(d->lpp_type);
+      ofs += putFloat(&reply_data[ofs], d->acc.min, sz, mult, is_signed);
+      ofs += putFloat(&reply_data[ofs], d->acc.max, sz, mult, is_signed);
+      ofs += putFloat(&reply_data[ofs], d->acc.mean, sz, mult, is_signed);
+    }
+    return ofs;
+  }
+  if (req_type == REQ_TYPE_GET_LOG_DATA && (perms & PERM_ACL_ROLE_MASK) >= PERM_ACL_READ_ONLY) {
+    if (payload_len < 4) return 0;
+    uint32_t since;   // resume cursor: timestamp of the last record already received (0 = from the start)
+    memcpy(&since, &payload[0], 4);
+
+    ensureFS();
+    bool more;
+    int budget = min((int)_reply_budget, (int)sizeof(reply_data));
+    int len = _log.read(since, &reply_data[5], budget - 5, more);
+    reply_data[4] = more ? LOG_DATA_FLAG_MORE : 0;
+    LOG_DEBUG("Log data since %lu: %d bytes%s", (unsigned long)since, len, more ? " (more)" : "");
+    return 5 + len;
+  }
   if (req_type == REQ_TYPE_GET_ACCESS_LIST && (perms & PERM_ACL_ROLE_MASK) == PERM_ACL_ADMIN) {
     uint8_t res1 = payload[0];   // reserved for future  (extra query params)
     uint8_t res2 = payload[1];
@@ -268,11 +727,36 @@ uint32_t SensorMesh::getDirectRetransmitDelay(const mesh::Packet* packet) {
   return getRNG()->nextInt(0, 6)*t;
 }
 
-int SensorMesh::getSleepInterval(uint8_t default_value) {
+uint32_t SensorMesh::getSleepInterval(uint32_t default_value) {
   if (!_extended_prefs.sleep_interval_secs) return default_value;
   return _extended_prefs.sleep_interval_secs;
 }
 
+uint32_t SensorMesh::getWakeKey() const {
+  // pub_key is uniformly distributed, so its leading bytes spread the slots evenly across the fleet
+  uint32_t h;
+  memcpy(&h, self_id.pub_key, sizeof(h));
+  return h;
+}
+
+uint32_t SensorMesh::getWakePhase(uint32_t interval, uint32_t now) {
+  if (!_extended_prefs.tx_slotting || interval == 0) return 0;
+  return wakePhaseFor(getWakeKey(), now / interval, interval, _extended_prefs.slot_width_secs);
+}
+
+uint32_t SensorMesh::getNextWakeSlot(uint32_t now, uint32_t woke_at, uint32_t interval, bool keep_slot) {
+  return nextWakeSlot(now, woke_at, interval, getWakeKey(), _extended_prefs.slot_width_secs, _extended_prefs.tx_slotting, keep_slot);
+}
+
+// Nodes drawn into the same slot still start their floods at different moments within it
+uint32_t SensorMesh::getTelemetryJitter() {
+  if (!_extended_prefs.tx_slotting) return 0;
+  if (_tx_jitter_ms < 0) {
+    _tx_jitter_ms = getRNG()->nextInt(0, telemJitterRangeMs(_extended_prefs.slot_width_secs));
+  }
+  return _tx_jitter_ms;   // one delay for the whole wake, so batch frames keep their order
+}
+
 int SensorMesh::getInterferenceThreshold() const {
   return _prefs.interference_threshold;
 }
@@ -285,34 +769,38 @@ uint8_t SensorMesh::handleLoginReq(const mesh::Identity& sender, const uint8_t*
   if (data[0] == 0) {   // blank password, just check if sender is in ACL
     client = acl.getClient(sender.pub_key, PUB_KEY_SIZE);
     if (client == NULL) {
-    #if MESH_DEBUG
-      MESH_DEBUG_PRINTLN("Login, sender not in ACL");
-    #endif
+      LOG_DEBUG("Login, sender not in ACL");
       return 0;
     }
   } else {
     if (strcmp((char *) data, _prefs.password) != 0) {  // check for valid admin password
-    #if MESH_DEBUG
-      MESH_DEBUG_PRINTLN("Invalid password: %s", &data[4]);
-    #endif
+      LOG_DEBUG("Invalid password: %s", &data[4]);
+      TRACE(TRACE_LOGIN, 0);
       return 0;
     }
 
+    bool known = acl.getClient(sender.pub_key, PUB_KEY_SIZE) != NULL;
     client = acl.putClient(sender, PERM_RECV_ALERTS_HI | PERM_RECV_ALERTS_LO);  // add to contacts (if not already known)
     if (sender_timestamp <= client->last_timestamp) {
-      MESH_DEBUG_PRINTLN("Possible login replay attack!");
+      LOG_WARN("Possible login replay attack!");
+      TRACE(TRACE_LOGIN, 0);
       return 0;  // FATAL: client table is full -OR- replay attack
     }
 
-    MESH_DEBUG_PRINTLN("Login success!");
+    LOG_DEBUG("Login success!");
     client->last_timestamp = sender_timestamp;
     client->last_activity = getRTCClock()->getCurrentTime();
     client->permissions |= PERM_ACL_ADMIN;
     memcpy(client->shared_secret, secret, PUB_KEY_SIZE);
 
-    // Immediately save ACL changes (sleeping nodes can't rely on lazy write timers)
-    acl.save(_fs);
+    // A new entry may have replaced another one, which only a full rewrite captures
+    int idx = -1;
+    for (int i = 0; known && i < acl.getNumClients(); i++) {
+      if (acl.getClientByIdx(i) == client) idx = i;
+    }
+    saveACL(idx);
   }
+  TRACE(TRACE_LOGIN, 1, client->permissions);
 
   uint32_t now = getRTCClock()->getCurrentTimeUnique();
   memcpy(reply_data, &now, 4);   // response packets always prefixed with timestamp
@@ -354,8 +842,7 @@ void SensorMesh::handleCommand(uint32_t sender_timestamp, char* command, char* r
       if (mesh::Utils::fromHex(pubkey, hex_len / 2, hex)) {
         uint8_t perms = atoi(sp);
         if (acl.applyPermissions(self_id, pubkey, hex_len / 2, perms)) {
-          // Immediately save ACL changes (sleeping nodes can't rely on lazy write timers)
-          acl.save(_fs);
+          saveACL();   // entries may have been added or removed
           strcpy(reply, "OK");
         } else {
           strcpy(reply, "Err - invalid params");
@@ -470,17 +957,17 @@ void SensorMesh::handleCommand(uint32_t sender_timestamp, char* command, char* r
 
     if (memcmp(subcmd, "set ", 4) == 0) {
       // sleep set <seconds>
-      uint32_t secs = atoi(&subcmd[4]);
-      if (secs < 60 || secs > 3600) {
-        strcpy(reply, "Err - sleep interval must be 60-3600 seconds");
+      uint32_t secs = strtoul(&subcmd[4], NULL, 10);
+      if (secs < SLEEP_INTERVAL_MIN_SECS || secs > SLEEP_INTERVAL_MAX_SECS) {
+        sprintf(reply, "Err - sleep interval must be %d-%lu seconds", SLEEP_INTERVAL_MIN_SECS, (unsigned long)SLEEP_INTERVAL_MAX_SECS);
       } else {
-        _extended_prefs.sleep_interval_secs = (uint16_t)secs;
+        _extended_prefs.sleep_interval_secs = secs;
         savePrefs();
-        sprintf(reply, "Sleep interval set: %d seconds", secs);
+        sprintf(reply, "Sleep interval set: %lu seconds", (unsigned long)secs);
       }
     } else if (strcmp(subcmd, "status") == 0 || strcmp(subcmd, "info") == 0) {
       // sleep status
-      sprintf(reply, "Sleep interval: %d seconds", _extended_prefs.sleep_interval_secs);
+      sprintf(reply, "Sleep interval: %lu seconds", (unsigned long)_extended_prefs.sleep_interval_secs);
     } else {
       strcpy(reply, "Usage: sleep set <seconds> | sleep status");
     }
@@ -500,15 +987,453 @@ void SensorMesh::handleCommand(uint32_t sender_timestamp, char* command, char* r
     } else if (strcmp(subcmd, "status") == 0 || strcmp(subcmd, "info") == 0) {
       // advert status
       uint32_t interval_mins = (_extended_prefs.sleep_interval_secs * _extended_prefs.wakeups_per_advert) / 60;
-      sprintf(reply, "Wakeups per advert: %d (~%d mins)", _extended_prefs.wakeups_per_advert, interval_mins);
+      sprintf(reply, "Wakeups per advert: %d (~%lu mins)", _extended_prefs.wakeups_per_advert, (unsigned long)interval_mins);
     } else {
       strcpy(reply, "Usage: advert set <count> | advert status");
     }
+  } else if (memcmp(command, "slot ", 5) == 0) {  // per-node wake phase (collision avoidance)
+    const char* subcmd = &command[5];
+
+    if (strcmp(subcmd, "on") == 0 || strcmp(subcmd, "off") == 0) {
+      // slot on|off
+      _extended_prefs.tx_slotting = (strcmp(subcmd, "on") == 0) ? 1 : 0;
+      savePrefs();
+      sprintf(reply, "Wake slotting: %s", subcmd);
+    } else if (memcmp(subcmd, "width ", 6) == 0) {
+      // slot width <secs>  (0 = 1 second granularity)
+      uint32_t width = strtoul(&subcmd[6], NULL, 10);
+      if (width > 0xFFFF) {
+        strcpy(reply, "Err - slot width must be 0-65535 seconds");
+      } else {
+        _extended_prefs.slot_width_secs = (uint16_t)width;
+        savePrefs();
+        sprintf(reply, "Slot width set: %lu seconds", (unsigned long)width);
+      }
+    } else if (strcmp(subcmd, "status") == 0 || strcmp(subcmd, "info") == 0) {
+      // slot status
+      uint32_t interval = getSleepInterval(0);
+      uint32_t now = getRTCClock()->getCurrentTime();
+      sprintf(reply, "Wake slotting: %s, width %d s, phase %lu of %lu s this period, next wake in %lu s",
+              _extended_prefs.tx_slotting ? "on" : "off", _extended_prefs.slot_width_secs,
+              (unsigned long)getWakePhase(interval, now), (unsigned long)interval,
+              interval ? (unsigned long)(getNextWakeSlot(now, now, interval, false) - now) : 0UL);
+    } else {
+      strcpy(reply, "Usage: slot on|off | slot width <secs> | slot status");
+    }
+  } else if (memcmp(command, "listen ", 7) == 0) {  // scheduled downlink listen window
+    const char* subcmd = &command[7];
+
+    if (memcmp(subcmd, "set ", 4) == 0) {
+      // listen set <every N TX> [window ms]
+      uint32_t every = atoi(&subcmd[4]);
+      const char* sp = strchr(&subcmd[4], ' ');
+      uint32_t window = sp ? atoi(sp + 1) : _extended_prefs.listen_window_ms;
+      if (every < 1 || every > 255 || window < LISTEN_WINDOW_MIN_MS || window > LISTEN_WINDOW_MAX_MS) {
+        sprintf(reply, "Err - usage: listen set <1-255> [%d-%d ms]", LISTEN_WINDOW_MIN_MS, LISTEN_WINDOW_MAX_MS);
+      } else {
+        _extended_prefs.listen_every = (uint8_t)every;
+        _extended_prefs.listen_window_ms = (uint16_t)window;
+        savePrefs();
+        sprintf(reply, "Listen window: %lu ms after every %lu telemetry TX", (unsigned long)window, (unsigned long)every);
+      }
+    } else if (strcmp(subcmd, "off") == 0) {
+      _extended_prefs.listen_every = 0;
+      savePrefs();
+      strcpy(reply, "Listen window: off");
+    } else if (strcmp(subcmd, "status") == 0 || strcmp(subcmd, "info") == 0) {
+      // listen status
+      if (_extended_prefs.listen_every == 0) {
+        strcpy(reply, "Listen window: off");
+      } else {
+        sprintf(reply, "Listen window: %d ms after every %d telemetry TX", _extended_prefs.listen_window_ms,
+                _extended_prefs.listen_every);
+      }
+    } else {
+      strcpy(reply, "Usage: listen set <every> [window_ms] | listen off | listen status");
+    }
+  } else if (memcmp(command, "link ", 5) == 0) {  // TX power link adaptation
+    const char* subcmd = &command[5];
+
+    if (strcmp(subcmd, "on") == 0 || strcmp(subcmd, "off") == 0) {
+      _extended_prefs.link_adapt = subcmd[1] == 'n' ? 1 : 0;
+      if (!_extended_prefs.link_adapt) _link.reset();
+      savePrefs();
+      if (_radio_ready) radio_set_tx_power(getEffectiveTxPower());
+      sprintf(reply, "Link adaptation: %s", subcmd);
+    } else if (memcmp(subcmd, "margin ", 7) == 0) {
+      // link margin <dB>
+      int margin = atoi(&subcmd[7]);
+      if (margin < 0 || margin > LINK_MARGIN_MAX_DB) {
+        sprintf(reply, "Err - margin must be 0-%d dB", LINK_MARGIN_MAX_DB);
+      } else {
+        _extended_prefs.link_margin_db = (uint8_t)margin;
+        savePrefs();
+        sprintf(reply, "Link margin set: %d dB", margin);
+      }
+    } else if (strcmp(subcmd, "probe") == 0) {
+      // link probe (responses update the estimate while the node stays awake)
+      strcpy(reply, sendLinkProbe() ? "Probe sent" : "Err - radio not ready");
+    } else if (strcmp(subcmd, "status") == 0 || strcmp(subcmd, "info") == 0) {
+      // link status
+      if (!_extended_prefs.link_adapt) {
+        sprintf(reply, "Link adaptation: off (%d dBm)", _prefs.tx_power_dbm);
+      } else if (!_link.hasSamples()) {
+        sprintf(reply, "Link adaptation: on, margin %d dB, no samples yet (%d dBm)", _extended_prefs.link_margin_db,
+                getEffectiveTxPower());
+      } else {
+        sprintf(reply, "Link adaptation: %d/%d dBm, link SNR %.1f dB, margin %d dB, ~%.3f mAh saved",
+                getEffectiveTxPower(), _prefs.tx_power_dbm, _link.getLinkSNR(), _extended_prefs.link_margin_db,
+                _link.getSavedMilliAh());
+      }
+    } else {
+      strcpy(reply, "Usage: link on|off | link margin <dB> | link probe | link status");
+    }
+  } else if (memcmp(command, "batch ", 6) == 0) {  // telemetry batching commands
+    const char* subcmd = &command[6];
+
+    if (memcmp(subcmd, "set ", 4) == 0) {
+      // batch set <wakes>
+      uint32_t wakes = atoi(&subcmd[4]);
+      if (wakes < 1 || wakes > MAX_BATCH_WAKES) {
+        sprintf(reply, "Err - wakes per batch must be 1-%d", MAX_BATCH_WAKES);
+      } else {
+        _extended_prefs.batch_wakes = (uint8_t)wakes;
+        savePrefs();
+        sprintf(reply, "Wakes per batch set: %d", wakes);
+      }
+    } else if (memcmp(subcmd, "format ", 7) == 0) {
+      // batch format lpp|compact
+      const char* fmt = &subcmd[7];
+      if (strcmp(fmt, "lpp") == 0 || strcmp(fmt, "compact") == 0) {
+        _extended_prefs.telemetry_format = fmt[0] == 'c' ? TELEM_SCHEMA_COMPACT : TELEM_SCHEMA_LPP;
+        savePrefs();
+        sprintf(reply, "Batch format: %s", fmt);
+      } else {
+        strcpy(reply, "Err - format must be lpp or compact");
+      }
+    } else if (strcmp(subcmd, "status") == 0 || strcmp(subcmd, "info") == 0) {
+      // batch status
+      const char* fmt = _extended_prefs.telemetry_format == TELEM_SCHEMA_COMPACT ? "compact" : "lpp";
+      if (_extended_prefs.batch_wakes <= 1) {
+        strcpy(reply, "Batching: off (send every wake)");
+      } else {
+        sprintf(reply, "Batching: every %d wakes, %s", _extended_prefs.batch_wakes, fmt);
+      }
+    } else {
+      strcpy(reply, "Usage: batch set <wakes> | batch format lpp|compact | batch status");
+    }
+  } else if (memcmp(command, "deadband ", 9) == 0) {  // send-on-delta thresholds
+    const char* subcmd = &command[9];
+
+    if (memcmp(subcmd, "set ", 4) == 0) {
+      // deadband set <channel> <threshold>
+      int ch = atoi(&subcmd[4]);
+      const char* sp = strchr(&subcmd[4], ' ');
+      float threshold = sp ? atof(sp + 1) : -1.0f;
+      if (ch < 1 || ch > 255 || !(threshold >= 0.0f)) {
+        strcpy(reply, "Err - usage: deadband set <channel 1-255> <threshold>=0>");
+      } else {
+        DeadbandEntry* slot = (DeadbandEntry*) findDeadband(_extended_prefs, ch);
+        for (int i = 0; slot == NULL && i < MAX_DEADBANDS; i++) {
+          if (_extended_prefs.deadbands[i].channel == 0) slot = &_extended_prefs.deadbands[i];
+        }
+        if (slot == NULL) {
+          sprintf(reply, "Err - max %d deadbands", MAX_DEADBANDS);
+        } else {
+          slot->channel = ch;
+          slot->threshold = threshold;
+          savePrefs();
+          sprintf(reply, "Deadband ch%d: %.3f", ch, threshold);
+        }
+      }
+    } else if (memcmp(subcmd, "clear ", 6) == 0) {
+      // deadband clear <channel|all>
+      if (strcmp(&subcmd[6], "all") == 0) {
+        memset(_extended_prefs.deadbands, 0, sizeof(_extended_prefs.deadbands));
+      } else {
+        DeadbandEntry* e = (DeadbandEntry*) findDeadband(_extended_prefs, atoi(&subcmd[6]));
+        if (e) memset(e, 0, sizeof(*e));
+      }
+      savePrefs();
+      strcpy(reply, "OK");
+    } else if (strcmp(subcmd, "status") == 0 || strcmp(subcmd, "info") == 0) {
+      // deadband status
+      char* dp = reply;
+      dp += sprintf(dp, "Heartbeat: %d wakes", _extended_prefs.heartbeat_wakes);
+      for (int i = 0; i < MAX_DEADBANDS; i++) {
+        if (_extended_prefs.deadbands[i].channel == 0) continue;
+        dp += sprintf(dp, ", ch%d=%.3f", _extended_prefs.deadbands[i].channel, _extended_prefs.deadbands[i].threshold);
+      }
+    } else {
+      strcpy(reply, "Usage: deadband set <ch> <threshold> | deadband clear <ch|all> | deadband status");
+    }
+  } else if (memcmp(command, "sample ", 7) == 0) {  // sampling schedules
+    const char* subcmd = &command[7];
+
+    if (memcmp(subcmd, "set ", 4) == 0) {
+      // sample set <count> <spacing_ms>   (channels without a schedule of their own)
+      uint32_t count = atoi(&subcmd[4]);
+      const char* sp = strchr(&subcmd[4], ' ');
+      uint32_t spacing = sp ? atoi(sp + 1) : 0;
+      if (!isValidSampleSchedule(count, spacing, 0)) {
+        sprintf(reply, "Err - count 1-%d, count x spacing up to %d ms", SAMPLE_MAX_COUNT, SAMPLE_WINDOW_MAX_MS);
+      } else {
+        _extended_prefs.samples_per_wake = count;
+        _extended_prefs.sample_spacing_ms = spacing;
+        savePrefs();
+        sprintf(reply, "Default schedule: %lu samples, %lu ms apart", (unsigned long)count, (unsigned long)spacing);
+      }
+    } else if (memcmp(subcmd, "ch ", 3) == 0) {
+      // sample ch <channel> <count> <spacing_ms> [warmup_ms] [mean|median|min|max]
+      uint32_t v[4] = { 0, 0, 0, 0 };   // channel, count, spacing, warmup; then the reducer name
+      int n = 0;
+      const char* p = &subcmd[3];
+      while (n < 4 && *p >= '0' && *p <= '9') {
+        char* end;
+        v[n++] = strtoul(p, &end, 10);
+        p = end;
+        while (*p == ' ') p++;
+      }
+      uint32_t ch = v[0], count = v[1], spacing = v[2], warmup = v[3];
+      int reducer = *p ? parseReducer(p) : REDUCE_MEAN;
+      if (ch < 1 || ch > 255 || n < 3 || reducer < 0 || !isValidSampleSchedule(count, spacing, warmup)) {
+        strcpy(reply, "Err - usage: sample ch <ch> <count> <spacing_ms> [warmup_ms] [mean|median|min|max]");
+      } else {
+        SampleSchedule* slot = findSampleSchedule(_extended_prefs, ch);
+        for (int i = 0; slot == NULL && i < SAMPLE_MAX_OVERRIDES; i++) {
+          if (_extended_prefs.sample_schedules[i].channel == 0) slot = &_extended_prefs.sample_schedules[i];
+        }
+        if (slot == NULL) {
+          sprintf(reply, "Err - max %d channel schedules", SAMPLE_MAX_OVERRIDES);
+        } else {
+          slot->channel = ch;
+          slot->count = count;
+          slot->spacing_ms = spacing;
+          slot->warmup_ms = warmup;
+          slot->reducer = reducer;
+          savePrefs();
+          sprintf(reply, "Sample ch%lu: %lu x %lu ms after %lu ms, %s", (unsigned long)ch, (unsigned long)count,
+                  (unsigned long)spacing, (unsigned long)warmup, getReducerName(reducer));
+        }
+      }
+    } else if (memcmp(subcmd, "clear ", 6) == 0) {
+      // sample clear <channel|all>
+      if (strcmp(&subcmd[6], "all") == 0) {
+        memset(_extended_prefs.sample_schedules, 0, sizeof(_extended_prefs.sample_schedules));
+      } else {
+        SampleSchedule* e = findSampleSchedule(_extended_prefs, atoi(&subcmd[6]));
+        if (e) memset(e, 0, sizeof(*e));
+      }
+      savePrefs();
+      strcpy(reply, "OK");
+    } else if (strcmp(subcmd, "status") == 0 || strcmp(subcmd, "info") == 0) {
+      // sample status
+      char* dp = reply;
+      dp += sprintf(dp, "Samples: %d x %d ms", _extended_prefs.samples_per_wake, _extended_prefs.sample_spacing_ms);
+      for (int i = 0; i < SAMPLE_MAX_OVERRIDES; i++) {
+        const SampleSchedule& e = _extended_prefs.sample_schedules[i];
+        if (e.channel == 0) continue;
+        dp += sprintf(dp, ", ch%d=%dx%d+%d %s", e.channel, e.count, e.spacing_ms, e.warmup_ms, getReducerName(e.reducer));
+      }
+    } else {
+      strcpy(reply, "Usage: sample set <count> <ms> | sample ch <ch> <count> <ms> [warmup] [reducer] | sample clear <ch|all> | sample status");
+    }
+  } else if (memcmp(command, "heartbeat ", 10) == 0) {  // send-on-delta forced report interval
+    const char* subcmd = &command[10];
+
+    if (memcmp(subcmd, "set ", 4) == 0) {
+      // heartbeat set <wakes>
+      uint32_t wakes = atoi(&subcmd[4]);
+      if (wakes < 1 || wakes > 255) {
+        strcpy(reply, "Err - heartbeat must be 1-255 wakes");
+      } else {
+        _extended_prefs.heartbeat_wakes = (uint8_t)wakes;
+        savePrefs();
+        sprintf(reply, "Heartbeat set: every %d wakes", wakes);
+      }
+    } else if (strcmp(subcmd, "status") == 0 || strcmp(subcmd, "info") == 0) {
+      // heartbeat status
+      if (_extended_prefs.heartbeat_wakes <= 1) {
+        strcpy(reply, "Send-on-delta: off (report every wake)");
+      } else {
+        sprintf(reply, "Send-on-delta: heartbeat every %d wakes", _extended_prefs.heartbeat_wakes);
+      }
+    } else {
+      strcpy(reply, "Usage: heartbeat set <wakes> | heartbeat status");
+    }
+  } else if (memcmp(command, "stats ", 6) == 0) {  // streaming statistics
+    const char* subcmd = &command[6];
+
+    if (memcmp(subcmd, "window set ", 11) == 0) {
+      // stats window set <minutes>
+      uint32_t mins = atoi(&subcmd[11]);
+      if (mins < 1 || mins > 1440) {
+        strcpy(reply, "Err - window must be 1-1440 minutes");
+      } else {
+        _extended_prefs.stats_window_mins = (uint16_t)mins;
+        savePrefs();
+        _stats.begin(mins * 60);   // different window - history is discarded
+        sprintf(reply, "Stats window: %d mins (%d hours history)", mins, (mins * STATS_NUM_BUCKETS) / 60);
+      }
+    } else if (strcmp(subcmd, "clear") == 0) {
+      // stats clear
+      _stats.clear();
+      strcpy(reply, "OK");
+    } else if (memcmp(subcmd, "show", 4) == 0 && (subcmd[4] == 0 || subcmd[4] == ' ')) {
+      // stats show [hours]
+      uint32_t secs = subcmd[4] == ' ' ? atoi(&subcmd[5]) * 3600 : _stats.getHistorySecs();
+      StatsSummary data[STATS_MAX_CHANNELS];
+      int n = _stats.query(getRTCClock()->getCurrentTime(), secs, 0, data, STATS_MAX_CHANNELS);
+      if (n == 0) {
+        strcpy(reply, "No stats");
+      } else if (sender_timestamp == 0) {
+        // serial console: one line per channel, no reply size limit
+        for (int i = 0; i < n; i++) {
+          auto a = &data[i].acc;
+          Serial.printf("ch%d type %d: n=%lu avg=%.3f min=%.3f max=%.3f sd=%.3f\n", data[i].channel, data[i].lpp_type,
+                        (unsigned long)a->count, a->mean, a->min, a->max, sqrtf(a->variance()));
+        }
+        reply[0] = 0;
+      } else {
+        auto a = &data[0].acc;
+        sprintf(reply, "ch%d: n=%lu avg=%.3f min=%.3f max=%.3f sd=%.3f (+%d more)", data[0].channel,
+                (unsigned long)a->count, a->mean, a->min, a->max, sqrtf(a->variance()), n - 1);
+      }
+    } else {
+      strcpy(reply, "Usage: stats show [hours] | stats window set <mins> | stats clear | stats energy");
+    }
+  } else if (memcmp(command, "radiomode ", 10) == 0) {  // radio power policy
+    const char* subcmd = &command[10];
+
+    if (memcmp(subcmd, "set ", 4) == 0) {
+      // radiomode set lazy|always
+      const char* mode = &subcmd[4];
+      if (strcmp(mode, "lazy") == 0 || strcmp(mode, "always") == 0) {
+        _extended_prefs.lazy_radio = (strcmp(mode, "lazy") == 0) ? 1 : 0;
+        savePrefs();
+        sprintf(reply, "Radio mode set: %s", mode);
+      } else {
+        strcpy(reply, "Err - mode must be lazy or always");
+      }
+    } else if (strcmp(subcmd, "status") == 0 || strcmp(subcmd, "info") == 0) {
+      // radiomode status
+      sprintf(reply, "Radio mode: %s (radio %s)", _extended_prefs.lazy_radio ? "lazy" : "always",
+              _radio_ready ? "on" : "off");
+    } else {
+      strcpy(reply, "Usage: radiomode set lazy|always | radiomode status");
+    }
+  } else if (memcmp(command, "sensors ", 8) == 0) {  // cached sensor presence map
+    const char* subcmd = &command[8];
+
+    if (strcmp(subcmd, "rescan") == 0) {
+      // sensors rescan - probe every driver again (eg. after fitting a module)
+      board.setSensorPower(true);
+      board.waitSensorPowerReady();
+      sensors.begin();
+      _extended_prefs.sensor_presence = sensors.getPresenceMap();
+      savePrefs();
+      sprintf(reply, "Sensors rescanned: map %08lX", (unsigned long)_extended_prefs.sensor_presence);
+    } else if (strcmp(subcmd, "status") == 0 || strcmp(subcmd, "info") == 0) {
+      // sensors status
+      sprintf(reply, "Sensor map: %08lX (probe %s)", (unsigned long)_extended_prefs.sensor_presence,
+              sensors.wasProbeSkipped() ? "skipped" : "ran");
+    } else {
+      strcpy(reply, "Usage: sensors rescan | sensors status");
+    }
+  } else if (memcmp(command, "journal ", 8) == 0) {  // deferred prefs/ACL persistence
+    const char* subcmd = &command[8];
+
+    if (strcmp(subcmd, "flush") == 0) {
+      flushConfig();
+      sprintf(reply, "Journal: %lu/%d bytes", (unsigned long)_journal.getSize(), CFG_JOURNAL_MAX_SIZE);
+    } else if (strcmp(subcmd, "compact") == 0) {
+      compactConfig();   // eg. before a firmware update that changes the config structs
+      strcpy(reply, "OK - prefs and ACL rewritten");
+    } else if (strcmp(subcmd, "status") == 0 || strcmp(subcmd, "info") == 0) {
+      ensureFS();
+      const PersistedConfig& pc = persisted_config.data;
+      sprintf(reply, "Journal: %lu/%d bytes, pending: %s%s%s", (unsigned long)_journal.getSize(), CFG_JOURNAL_MAX_SIZE,
+              pc.dirty & CFG_DIRTY_PREFS ? "prefs " : "", pc.dirty & CFG_DIRTY_ACL ? "acl " : (pc.dirty_clients ? "clients " : ""),
+              pc.dirty || pc.dirty_clients ? "" : "none");
+    } else {
+      strcpy(reply, "Usage: journal flush | journal compact | journal status");
+    }
   } else{
+    // reboot/OTA may not come back through a warm boot, so pending changes go to flash first
+    if (strcmp(command, "reboot") == 0 || memcmp(command, "start ota", 9) == 0) {
+      endCLIBatch();
+      flushConfig();
+    }
     _cli.handleCommand(sender_timestamp, command, reply);  // common CLI commands
   }
 }
 
+/**
+ * Several commands in one CLI datagram, one result per line in a single reply
+ *
+ * Commands run in order. Prefs are saved once, after the last one. A run of identical results
+ * is packed as "<result> x<n>", so a config batch answers "OK x6". Results that no longer fit
+ * max_len are counted in a final "+<n> more, <e> Err" line, but their commands still run.
+ */
+void SensorMesh::handleCommandBatch(uint32_t sender_timestamp, char* commands, char* reply, int max_len) {
+  char result[161];
+  int len = 0;
+  int run_start = -1, run_len = 0, run = 0;   // last result in reply: offset, length, repeat count
+  int skipped = 0, skipped_err = 0;
+
+  _cli_batch = true;
+  _cli_batch_dirty = false;
+  char* line = commands;
+  while (line != NULL) {
+    char* next = strchr(line, '\n');
+    if (next) *next++ = 0;
+    int n = strlen(line);
+    if (n > 0 && line[n - 1] == '\r') line[--n] = 0;
+
+    if (n > 0) {
+      result[0] = 0;
+      handleCommand(sender_timestamp, line, result);
+      if (result[0] == 0) strcpy(result, "-");   // keep one line per command
+      int rlen = strlen(result);
+
+      char suffix[12];
+      if (skipped == 0 && run_start >= 0 && rlen == run_len && memcmp(&reply[run_start], result, rlen) == 0
+          && run_start + run_len + sprintf(suffix, " x%d", run + 1) + CLI_BATCH_SUMMARY_LEN <= max_len) {
+        run++;
+        len = run_start + run_len;
+        strcpy(&reply[len], suffix);
+        len += strlen(suffix);
+      } else if (skipped == 0 && len + (len ? 1 : 0) + rlen + CLI_BATCH_SUMMARY_LEN <= max_len) {
+        if (len) reply[len++] = '\n';
+        run_start = len;
+        run_len = rlen;
+        run = 1;
+        memcpy(&reply[len], result, rlen);
+        len += rlen;
+      } else {
+        skipped++;
+        if (memcmp(result, "Err", 3) == 0) skipped_err++;
+      }
+    }
+    line = next;
+  }
+  endCLIBatch();
+
+  if (skipped) {
+    len += sprintf(&reply[len], "%s+%d more, %d Err", len ? "\n" : "", min(skipped, 99), min(skipped_err, 99));
+  }
+  reply[len] = 0;
+}
+
+void SensorMesh::endCLIBatch() {
+  if (!_cli_batch) return;
+  _cli_batch = false;
+  if (_cli_batch_dirty) {
+    _cli_batch_dirty = false;
+    savePrefs();
+  }
+}
+
 void SensorMesh::onAnonDataRecv(mesh::Packet* packet, const uint8_t* secret, const mesh::Identity& sender, uint8_t* data, size_t len) {
   if (packet->getPayloadType() == PAYLOAD_TYPE_ANON_REQ) {  // received an initial request by a possible admin client (unknown at this stage)
     uint32_t timestamp;
@@ -525,6 +1450,8 @@ void SensorMesh::onAnonDataRecv(mesh::Packet* packet, const uint8_t* secret, con
     }
 
     if (reply_len == 0) return;   // invalid request
+    _downlink_count++;
+    onLinkSample(packet->_snr, false);
 
     if (packet->isRouteFlood()) {
       // let this sender know path TO here, so they can use sendDirect(), and ALSO encode the response
@@ -554,24 +1481,28 @@ void SensorMesh::getPeerSharedSecret(uint8_t* dest_secret, int peer_idx) {
     // lookup pre-calculated shared_secret
     memcpy(dest_secret, acl.getClientByIdx(i)->shared_secret, PUB_KEY_SIZE);
   } else {
-    MESH_DEBUG_PRINTLN("getPeerSharedSecret: Invalid peer idx: %d", i);
+    LOG_WARN("getPeerSharedSecret: Invalid peer idx: %d", i);
   }
 }
 
 void SensorMesh::onPeerDataRecv(mesh::Packet* packet, uint8_t type, int sender_idx, const uint8_t* secret, uint8_t* data, size_t len) {
   int i = matching_peer_indexes[sender_idx];
   if (i < 0 || i >= acl.getNumClients()) {
-    MESH_DEBUG_PRINTLN("onPeerDataRecv: Invalid sender idx: %d", i);
+    LOG_WARN("onPeerDataRecv: Invalid sender idx: %d", i);
     return;
   }
 
   ClientInfo* from = acl.getClientByIdx(i);
+  _downlink_count++;
+  onLinkSample(packet->_snr, false);
 
   if (type == PAYLOAD_TYPE_REQ) {  // request (from a known contact)
     uint32_t timestamp;
     memcpy(&timestamp, data, 4);
 
     if (timestamp > from->last_timestamp) {  // prevent replay attacks
+      // a flood request is answered with a path return, which also carries the path
+      _reply_budget = MAX_RESPONSE_DATA_LEN - (packet->isRouteFlood() ? 2 + packet->path_len : 0);
       uint8_t reply_len = handleRequest(from->isAdmin() ? 0xFF : from->permissions, timestamp, data[4], &data[5], len - 5);
       if (reply_len == 0) return;  // invalid command
 
@@ -594,7 +1525,7 @@ void SensorMesh::onPeerDataRecv(mesh::Packet* packet, uint8_t type, int sender_i
         }
       }
     } else {
-      MESH_DEBUG_PRINTLN("onPeerDataRecv: possible replay attack detected");
+      LOG_WARN("onPeerDataRecv: possible replay attack detected");
     }
   } else if (type == PAYLOAD_TYPE_TXT_MSG && len > 5 && from->isAdmin()) {   // a CLI command
     uint32_t sender_timestamp;
@@ -635,7 +1566,11 @@ void SensorMesh::onPeerDataRecv(mesh::Packet* packet, uint8_t type, int sender_i
         uint8_t temp[166];
         char *command = (char *) &data[5];
         char *reply = (char *) &temp[5];
-        handleCommand(sender_timestamp, command, reply);
+        if (strchr(command, '\n')) {
+          handleCommandBatch(sender_timestamp, command, reply, sizeof(temp) - 5 - 1);
+        } else {
+          handleCommand(sender_timestamp, command, reply);
+        }
 
         int text_len = strlen(reply);
         if (text_len > 0) {
@@ -657,17 +1592,17 @@ void SensorMesh::onPeerDataRecv(mesh::Packet* packet, uint8_t type, int sender_i
           }
         }
       } else {
-        MESH_DEBUG_PRINTLN("onPeerDataRecv: unsupported text type received: flags=%02x", (uint32_t)flags);
+        LOG_DEBUG("onPeerDataRecv: unsupported text type received: flags=%02x", (uint32_t)flags);
       }
     } else {
-      MESH_DEBUG_PRINTLN("onPeerDataRecv: possible replay attack detected");
+      LOG_WARN("onPeerDataRecv: possible replay attack detected");
     }
   }
 }
 
 bool SensorMesh::handleIncomingMsg(ClientInfo& from, uint32_t timestamp, uint8_t* data, uint flags, size_t len) {
-  MESH_DEBUG_PRINT("handleIncomingMsg: unhandled msg from ");
-  #ifdef MESH_DEBUG
+  #if LOG_ENABLED(LOG_LEVEL_DEBUG)
+  Serial.print("DEBUG: handleIncomingMsg: unhandled msg from ");
   mesh::Utils::printHex(Serial, from.id.pub_key, PUB_KEY_SIZE);
   Serial.printf(": %s\n", data);
   #endif
@@ -679,8 +1614,14 @@ bool SensorMesh::handleIncomingMsg(ClientInfo& from, uint32_t timestamp, uint8_t
 
 void SensorMesh::onControlDataRecv(mesh::Packet* packet) {
   uint8_t type = packet->payload[0] & 0xF0;    // just test upper 4 bits
-  if (type == CTL_TYPE_NODE_DISCOVER_REQ && packet->payload_len >= 6) {
-    // TODO: apply rate limiting to these!
+  if (type == CTL_TYPE_NODE_DISCOVER_RESP && packet->payload_len >= 6 && _probe_tag != 0) {
+    // answer to our link probe: payload[1] is the SNR the neighbour heard us at
+    if (memcmp(&packet->payload[2], &_probe_tag, 4) == 0) {
+      onLinkSample((int8_t)packet->payload[1], true);
+    }
+  } else if (type == CTL_TYPE_NODE_DISCOVER_REQ && packet->payload_len >= 6) {
+    onLinkSample(packet->_snr, false);   // zero-hop, so this is a direct neighbour
+
     int i = 1;
     uint8_t  filter = packet->payload[i++];
     uint32_t tag;
@@ -692,8 +1633,9 @@ void SensorMesh::onControlDataRecv(mesh::Packet* packet) {
       since = 0;
     }
 
-    if ((filter & (1 << ADV_TYPE_SENSOR)) != 0 && _prefs.discovery_mod_timestamp >= since) {
-      bool prefix_only = packet->payload[0] & 1;
+    bool prefix_only = packet->payload[0] & 1;
+    if ((filter & (1 << ADV_TYPE_SENSOR)) != 0 && _prefs.discovery_mod_timestamp >= since
+        && allowDiscoverReply(tag, prefix_only ? 1 : 2)) {   // full key is the longer TX
       uint8_t data[6 + PUB_KEY_SIZE];
       data[0] = CTL_TYPE_NODE_DISCOVER_RESP | ADV_TYPE_SENSOR;   // low 4-bits for node type
       data[1] = packet->_snr;   // let sender know the inbound SNR ( x 4)
@@ -710,22 +1652,23 @@ void SensorMesh::onControlDataRecv(mesh::Packet* packet) {
 bool SensorMesh::onPeerPathRecv(mesh::Packet* packet, int sender_idx, const uint8_t* secret, uint8_t* path, uint8_t path_len, uint8_t extra_type, uint8_t* extra, uint8_t extra_len) {
   int i = matching_peer_indexes[sender_idx];
   if (i < 0 || i >= acl.getNumClients()) {
-    MESH_DEBUG_PRINTLN("onPeerPathRecv: Invalid sender idx: %d", i);
+    LOG_WARN("onPeerPathRecv: Invalid sender idx: %d", i);
     return false;
   }
 
   ClientInfo* from = acl.getClientByIdx(i);
 
-  MESH_DEBUG_PRINTLN("PATH to contact, path_len=%d", (uint32_t) path_len);
+  LOG_DEBUG("PATH to contact, path_len=%d", (uint32_t) path_len);
+  onLinkSample(packet->_snr, false);
   // NOTE: for this impl, we just replace the current 'out_path' regardless, whenever sender sends us a new out_path.
   // FUTURE: could store multiple out_paths per contact, and try to find which is the 'best'(?)
   memcpy(from->out_path, path, from->out_path_len = path_len);  // store a copy of path, for sendDirect()
   from->last_activity = getRTCClock()->getCurrentTime();
 
   // REVISIT: Paths are invalidated on wake for sleeping nodes (see Fix 2)
-  // For now, immediately save admin paths (sleeping nodes can't rely on lazy write timers)
+  // Admin paths are kept (journaled before sleep, sleeping nodes can't rely on lazy write timers)
   if (from->isAdmin()) {
-    acl.save(_fs);
+    saveACL(i);
   }
 
   // NOTE: no reciprocal path send!!
@@ -736,12 +1679,32 @@ void SensorMesh::onAckRecv(mesh::Packet* packet, uint32_t ack_crc) {
   // Alert ACK handling removed - alert system not compatible with sleeping nodes
 }
 
+// Function-local so it is constructed before first use, whatever the global constructor order
+static StaticPoolPacketManager& packetPool() {
+  static StaticPoolPacketManager pool(SENSOR_PACKET_POOL_SIZE);   // see MemoryProfile.h
+  return pool;
+}
+
 SensorMesh::SensorMesh(mesh::MainBoard& board, mesh::Radio& radio, mesh::MillisecondClock& ms, mesh::RNG& rng, mesh::RTCClock& rtc, mesh::MeshTables& tables)
-     : mesh::Mesh(radio, ms, rng, rtc, *new StaticPoolPacketManager(32), tables),
-      _cli(board, rtc, sensors, &_prefs, this), telemetry(MAX_PACKET_PAYLOAD - 4)
+     : mesh::Mesh(radio, ms, rng, rtc, packetPool(), tables),
+      _cli(board, rtc, sensors, &_prefs, this), telemetry(MAX_PACKET_PAYLOAD - 4),
+      _reading(TELEM_READING_MAX)
 {
   // next_local_advert, next_flood_advert initialization removed - time-based ads removed
   zone_name[0] = 0;  // Initialize zone name as empty
+  _fs = NULL;
+  _fs_mounted = false;
+  _warm_boot = false;
+  _radio_ready = false;
+  _reply_budget = MAX_RESPONSE_DATA_LEN;
+  _cli_batch = false;
+  _cli_batch_dirty = false;
+  _discover_replies = 0;
+  _downlink_count = 0;
+  _num_sources = 0;
+  _listen_pending = false;
+  _tx_jitter_ms = -1;
+  _probe_tag = 0;
 
   // defaults
   memset(&_prefs, 0, sizeof(_prefs));
@@ -774,6 +1737,25 @@ SensorMesh::SensorMesh(mesh::MainBoard& board, mesh::Radio& radio, mesh::Millise
   // Sleeping sensor defaults
   _extended_prefs.sleep_interval_secs = 300;  // 5 minutes
   _extended_prefs.wakeups_per_advert = 12;    // 12 wakeups = 60 minutes at 5-minute intervals
+  _extended_prefs.batch_wakes = 1;            // send every wake (no batching)
+  _extended_prefs.heartbeat_wakes = 1;        // send-on-delta off (deadbands zeroed by memset above)
+  _extended_prefs.lazy_radio = 0;             // radio powered from boot
+  _extended_prefs.stats_window_mins = 60;     // 1 hour buckets, 12 hours of history
+  _extended_prefs.telemetry_log = 1;          // keep readings for store-and-forward backfill
+  _extended_prefs.energy_telemetry = 0;       // wake timing stays on-node unless requested
+  _extended_prefs.sensor_presence = 0;        // unknown: first boot runs the full probe
+  _extended_prefs.tx_slotting = 1;            // spread fleet wakes across the interval
+  _extended_prefs.slot_width_secs = 0;        // 1 second granularity
+  _extended_prefs.listen_every = 0;           // no scheduled downlink window
+  _extended_prefs.listen_window_ms = 500;
+  _extended_prefs.telemetry_format = TELEM_SCHEMA_LPP;   // batches stay plain CayenneLPP
+  _extended_prefs.link_adapt = 0;             // fixed tx_power_dbm
+  _extended_prefs.link_margin_db = 10;
+  _extended_prefs.samples_per_wake = 5;       // battery: 5 samples, 1 s apart (overrides zeroed by memset above)
+  _extended_prefs.sample_spacing_ms = 1000;
+  _extended_prefs.gps_fix_wakes = 12;         // GPS fix once an hour at 5-minute intervals
+  _extended_prefs.gps_fix_secs = 30;
+  _extended_prefs.event_wake = 1;             // sources only exist if the application declares them
 
   // Transport code zone defaults
   StrHelper::strncpy(_extended_prefs.broadcast_zone_name, DEFAULT_BROADCAST_ZONE, sizeof(_extended_prefs.broadcast_zone_name));
@@ -782,93 +1764,165 @@ SensorMesh::SensorMesh(mesh::MainBoard& board, mesh::Radio& radio, mesh::Millise
   _extended_prefs.private_channel_psk[0] = 0;  // No private channel by default
   private_channel_enabled = false;
   memset(&private_channel, 0, sizeof(private_channel));
+  memset(&public_channel, 0, sizeof(public_channel));
+  _telem_channel = &public_channel;
 }
 
-void SensorMesh::begin(FILESYSTEM* fs) {
-  mesh::Mesh::begin();
+void SensorMesh::begin(FILESYSTEM* fs, bool fs_mounted) {
   _fs = fs;
+  _fs_mounted = fs_mounted;
+
+  if (_warm_boot) {
+    // prefs, ACL, zone key and channel secret already restored by restoreBootSnapshot()
+    LOG_DEBUG("Warm wake: config restored from retained RAM, skipping InternalFS");
+    LOG_DEBUG("Sleep interval: %lu secs, Wakeups per advert: %d",
+                       _extended_prefs.sleep_interval_secs,
+                       _extended_prefs.wakeups_per_advert);
+  } else {
+    ensureFS();
+    loadPrefsFromFS();
+    acl.load(_fs);
+  }
 
+  // Base files plus journal = persisted config
+  _journal.begin(_fs, CFG_JOURNAL_LAYOUT);
+  persisted_config.retain();
+  if (!_warm_boot) {
+    int n = _journal.replay(applyJournalRecord, this);
+    if (n < 0) {
+      compactConfig();   // unreadable tail or another build's layout: start a clean journal
+    } else {
+      markConfigPersisted();
+    }
+  } else if (!persisted_config.isValid()) {
+    // warm wake without the persisted image: cannot diff, rewrite everything at the next flush
+    markConfigPersisted();
+    persisted_config.data.dirty = CFG_DIRTY_PREFS | CFG_DIRTY_ACL;
+    persisted_config.commit();
+  }
+
+#if ENV_INCLUDE_GPS == 1
+  applyGpsPrefs();
+#endif
+
+  _stats.begin((uint32_t)_extended_prefs.stats_window_mins * 60);
+  _log.begin(_fs);
+  _link.begin(_prefs.tx_power_dbm);
+
+  if (!_warm_boot) {
+    // Load persisted broadcast zone from extended preferences
+    // If persisted zone exists, use it; otherwise fall back to DEFAULT_BROADCAST_ZONE
+    if (strlen(_extended_prefs.broadcast_zone_name) > 0) {
+      applyBroadcastZone(_extended_prefs.broadcast_zone_name);
+      LOG_DEBUG("Loaded persisted zone: %s", _extended_prefs.broadcast_zone_name);
+    } else {
+      applyBroadcastZone(NULL);
+      LOG_DEBUG("No persisted zone, using standard flood");
+    }
+
+    // Load persisted private channel from extended preferences
+    if (strlen(_extended_prefs.private_channel_psk) > 0) {
+      applyPrivateChannel(_extended_prefs.private_channel_psk);
+      LOG_DEBUG("Loaded private channel from preferences");
+    } else {
+      applyPrivateChannel(NULL);
+      LOG_DEBUG("No private channel configured, using public broadcast");
+    }
+
+    saveBootSnapshot();   // next warm wake can skip all of the above
+  }
+  resolveTelemetryRoute();
+
+  // Readings batched over previous wakes survive system-off in retained RAM
+  _batch.begin(getBatchCapacity());
+}
+
+// Kept separate from begin() so prefs/keys can be loaded while the SX1262 is still unpowered
+void SensorMesh::beginRadio() {
+  mesh::Mesh::begin();
+  radio_set_params(_prefs.freq, _prefs.bw, _prefs.sf, _prefs.cr);
+  radio_set_tx_power(getEffectiveTxPower());
+  _radio_ready = true;
+}
+
+void SensorMesh::loadPrefsFromFS() {
   // Load persisted core prefs
-  MESH_DEBUG_PRINTLN("=== Preference Loading Debug ===");
-  MESH_DEBUG_PRINTLN("Checking for /com_prefs file...");
+  LOG_DEBUG("=== Preference Loading Debug ===");
+  LOG_DEBUG("Checking for /com_prefs file...");
   if (_fs->exists("/com_prefs")) {
-    MESH_DEBUG_PRINTLN("/com_prefs found");
+    LOG_DEBUG("/com_prefs found");
   } else {
-    MESH_DEBUG_PRINTLN("WARNING: /com_prefs NOT found - will use build-time defaults!");
+    LOG_WARN("/com_prefs NOT found - will use build-time defaults!");
   }
 
-  MESH_DEBUG_PRINTLN("Build-time defaults: freq=%.3f bw=%.1f sf=%d cr=%d",
+  LOG_DEBUG("Build-time defaults: freq=%.3f bw=%.1f sf=%d cr=%d",
                      LORA_FREQ, LORA_BW, LORA_SF, LORA_CR);
 
   _cli.loadPrefs(_fs);
 
-  MESH_DEBUG_PRINTLN("Loaded radio params: freq=%.3f bw=%.1f sf=%d cr=%d",
+  LOG_DEBUG("Loaded radio params: freq=%.3f bw=%.1f sf=%d cr=%d",
                      _prefs.freq, _prefs.bw, _prefs.sf, _prefs.cr);
 
   // Detect silent failure by comparing to build defaults
   if (_prefs.freq == LORA_FREQ && _prefs.bw == LORA_BW &&
       _prefs.sf == LORA_SF && _prefs.cr == LORA_CR) {
-    MESH_DEBUG_PRINTLN("NOTE: Radio params match build-time defaults - either first boot or load failed");
+    LOG_DEBUG("NOTE: Radio params match build-time defaults - either first boot or load failed");
   }
-  MESH_DEBUG_PRINTLN("=== End Preference Loading ===\n");
+  LOG_DEBUG("=== End Preference Loading ===\n");
 
   // Load persisted extended prefs (if file exists, otherwise uses defaults from constructor)
-  MESH_DEBUG_PRINTLN("=== Extended Preference Loading ===");
+  LOG_DEBUG("=== Extended Preference Loading ===");
   if (_fs->exists("/com_prefs_ext")) {
-    MESH_DEBUG_PRINTLN("/com_prefs_ext found");
+    LOG_DEBUG("/com_prefs_ext found");
     if (ExtendedPrefsSerializer<SensorExtendedPrefs>::load(_fs, _extended_prefs)) {
-      MESH_DEBUG_PRINTLN("Extended prefs loaded successfully");
+      LOG_DEBUG("Extended prefs loaded successfully");
     } else {
-      MESH_DEBUG_PRINTLN("WARNING: Extended prefs load FAILED!");
+      LOG_WARN("Extended prefs load FAILED!");
     }
   } else {
-    MESH_DEBUG_PRINTLN("NOTE: /com_prefs_ext not found - using defaults");
+    LOG_DEBUG("NOTE: /com_prefs_ext not found - using defaults");
     ExtendedPrefsSerializer<SensorExtendedPrefs>::load(_fs, _extended_prefs);
   }
-  MESH_DEBUG_PRINTLN("Sleep interval: %d secs, Wakeups per advert: %d",
+  LOG_DEBUG("Sleep interval: %lu secs, Wakeups per advert: %d",
                      _extended_prefs.sleep_interval_secs,
                      _extended_prefs.wakeups_per_advert);
-  MESH_DEBUG_PRINTLN("=== End Extended Prefs ===\n");
-
-  acl.load(_fs);
-
-  radio_set_params(_prefs.freq, _prefs.bw, _prefs.sf, _prefs.cr);
-  radio_set_tx_power(_prefs.tx_power_dbm);
-
-#if ENV_INCLUDE_GPS == 1
-  applyGpsPrefs();
-#endif
+  LOG_DEBUG("=== End Extended Prefs ===\n");
+}
 
-  // Load persisted broadcast zone from extended preferences
-  // If persisted zone exists, use it; otherwise fall back to DEFAULT_BROADCAST_ZONE
-  if (strlen(_extended_prefs.broadcast_zone_name) > 0) {
-    setBroadcastZone(_extended_prefs.broadcast_zone_name);
-    MESH_DEBUG_PRINTLN("Loaded persisted zone: %s", _extended_prefs.broadcast_zone_name);
-  } else {
-    clearBroadcastZone();
-    MESH_DEBUG_PRINTLN("No persisted zone, using standard flood");
+void SensorMesh::ensureFS() {
+  if (!_fs_mounted) {
+    mountFileSystem(_fs);   // deferred on warm wakes until something actually needs flash
+    _fs_mounted = true;
   }
+}
 
-  // Load persisted private channel from extended preferences
-  if (strlen(_extended_prefs.private_channel_psk) > 0) {
-    setPrivateChannel(_extended_prefs.private_channel_psk);
-    MESH_DEBUG_PRINTLN("Loaded private channel from preferences");
+// Changes stay in RAM (and the retained boot snapshot, so warm wakes and soft reboots see them)
+// until flushConfig() runs before sleep: no flash stall on the RX path, one write per wake
+void SensorMesh::saveACL(int client_idx) {
+  PersistedConfig& pc = persisted_config.data;
+  if (client_idx >= 0 && client_idx < 32) {
+    pc.dirty_clients |= 1UL << client_idx;
   } else {
-    clearPrivateChannel();
-    MESH_DEBUG_PRINTLN("No private channel configured, using public broadcast");
+    pc.dirty |= CFG_DIRTY_ACL;
   }
+  persisted_config.commit();
+  saveBootSnapshot();
 }
 
 void SensorMesh::savePrefs() {
-  MESH_DEBUG_PRINTLN("Saving preferences...");
-  MESH_DEBUG_PRINTLN("Radio params to save: freq=%.3f bw=%.1f sf=%d cr=%d",
+  if (_cli_batch) {   // written once when the batch ends
+    _cli_batch_dirty = true;
+    return;
+  }
+  LOG_DEBUG("Preferences changed: freq=%.3f bw=%.1f sf=%d cr=%d (written before sleep)",
                      _prefs.freq, _prefs.bw, _prefs.sf, _prefs.cr);
-  _cli.savePrefs(_fs);  // Save core prefs
-  ExtendedPrefsSerializer<SensorExtendedPrefs>::save(_fs, _extended_prefs);  // Save extended prefs
-  MESH_DEBUG_PRINTLN("Preferences saved");
+  persisted_config.data.dirty |= CFG_DIRTY_PREFS;
+  persisted_config.commit();
+  saveBootSnapshot();
 }
 
 bool SensorMesh::formatFileSystem() {
+    invalidateBootSnapshot();
 #if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
     return InternalFS.format();
 #elif defined(RP2040_PLATFORM)
@@ -892,13 +1946,16 @@ void SensorMesh::saveIdentity(const mesh::LocalIdentity& new_id) {
 #else
   #error "need to define saveIdentity()"
 #endif
+  ensureFS();
+  flushConfig();   // next boot is cold, pending changes must be on flash
   store.save("_main", self_id);
+  invalidateBootSnapshot();
 }
 
 void SensorMesh::applyTempRadioParams(float freq, float bw, uint8_t sf, uint8_t cr, int timeout_mins) {
   // Temporary radio parameters removed - not compatible with sleeping nodes
   // Timers don't survive sleep cycles, making this feature unreliable
-  MESH_DEBUG_PRINTLN("Temp radio params not supported on sleeping nodes");
+  LOG_DEBUG("Temp radio params not supported on sleeping nodes");
 }
 
 void SensorMesh::sendSelfAdvertisement(int delay_millis) {
@@ -906,72 +1963,224 @@ void SensorMesh::sendSelfAdvertisement(int delay_millis) {
   if (pkt) {
     sendFlood(pkt, delay_millis);
   } else {
-    MESH_DEBUG_PRINTLN("ERROR: unable to create advertisement packet!");
+    LOG_ERROR("unable to create advertisement packet!");
   }
 }
 
-void SensorMesh::broadcastTelemetry() {
-  // Read current sensor data into telemetry buffer
-  telemetry.reset();
-  telemetry.addVoltage(TELEM_CHANNEL_SELF, (float)board.getBattMilliVolts() / 1000.0f);
+/* ------------------------------ Telemetry Pipeline -------------------------------- */
+
+bool SensorMesh::addTelemetrySource(TelemetrySourceFn fn, void* ctx) {
+  if (_num_sources >= MAX_TELEMETRY_SOURCES) return false;
+  _sources[_num_sources].fn = fn;
+  _sources[_num_sources].ctx = ctx;
+  _num_sources++;
+  return true;
+}
 
-  // Query other sensors (if any)
-  sensors.querySensors(0xFF, telemetry);
+// Build this wake's reading from the sources; every reading feeds the on-node statistics and the
+// store-and-forward log, whether or not it is reported. Returns its length (0 = nothing to send)
+uint8_t SensorMesh::collectReading(uint32_t timestamp) {
+  _reading.reset();
+  for (int i = 0; i < _num_sources; i++) {
+    _sources[i].fn(_sources[i].ctx, _reading);
+  }
 
-  // Get telemetry data
-  uint8_t telem_len = telemetry.getSize();
-  if (telem_len == 0) {
-    MESH_DEBUG_PRINTLN("No telemetry data to broadcast");
-    return;
+  uint8_t len = _reading.getSize();
+  if (len == 0) {
+    LOG_DEBUG("No telemetry data to broadcast");
+    return 0;
   }
+  recordTelemetry(_reading.getBuffer(), len);
+  logTelemetry(timestamp, _reading.getBuffer(), len);
+  return len;
+}
 
-  // Create packet with timestamp + telemetry data
-  uint8_t temp[5 + MAX_PACKET_PAYLOAD];
+bool SensorMesh::broadcastTelemetry() {
   uint32_t timestamp = getRTCClock()->getCurrentTime();
-  memcpy(temp, &timestamp, 4);
-  temp[4] = 0;  // flags
-
-  // Copy telemetry data
-  memcpy(&temp[5], telemetry.getBuffer(), telem_len);
-
-  // Select channel: private if configured, otherwise public
-  mesh::GroupChannel* channel;
-  const char* channel_type;
-  if (private_channel_enabled) {
-    channel = &private_channel;
-    channel_type = "ENCRYPTED";
+  uint8_t len = collectReading(timestamp);
+  if (len == 0) return false;
+  const uint8_t* lpp = _reading.getBuffer();
+
+  // Send-on-delta: skip readings that stayed inside their deadbands (heartbeat still forces one through)
+  if (!shouldReportTelemetry(lpp, len)) {
+    LOG_DEBUG("Telemetry unchanged - not reported");
+    return false;
+  }
+  onTelemetryReported(lpp, len);
+
+  uint8_t batch_wakes = _extended_prefs.batch_wakes;
+  if (batch_wakes <= 1) {
+    // Batching off: one packet per wake
+    if (!_batch.isEmpty()) flushTelemetryBatch();  // leftovers from before batching was disabled
+    return sendTelemetryReading(timestamp, lpp, len);
+  }
+
+  // Batching: accumulate this wake's reading, send once K wakes are collected or the batch is full
+  _batch.setCapacity(getBatchCapacity());
+  bool sent = false;
+  if (!_batch.append(timestamp, lpp, len)) {
+    sent = flushTelemetryBatch();
+    if (!_batch.append(timestamp, lpp, len)) {
+      // Single reading larger than a batch record allows - send it on its own
+      return sendTelemetryReading(timestamp, lpp, len) || sent;
+    }
+  }
+
+  if (isTelemBatchDue(_batch.getWakes(), batch_wakes, _batch.fits(len))) {
+    sent |= flushTelemetryBatch();
   } else {
-    // Use public channel (all zeros)
-    static mesh::GroupChannel public_channel;
-    memset(public_channel.hash, 0, sizeof(public_channel.hash));
-    memset(public_channel.secret, 0, sizeof(public_channel.secret));
-    channel = &public_channel;
-    channel_type = "PUBLIC";
+    LOG_DEBUG("Telemetry batched (%d/%d wakes)", _batch.getWakes(), batch_wakes);
   }
+  return sent;
+}
 
-  auto pkt = createGroupDatagram(PAYLOAD_TYPE_GRP_DATA, *channel, temp, 5 + telem_len);
+bool SensorMesh::sendEventTelemetry() {
+  uint32_t timestamp = getRTCClock()->getCurrentTime();
+  uint8_t len = collectReading(timestamp);
+  if (len == 0) return false;
+  return sendTelemetryReading(timestamp, _reading.getBuffer(), len);
+}
 
-  if (pkt) {
-    // Use transport codes if broadcast zone is configured
-    if (broadcast_zone.isNull()) {
-      // No zone configured - use standard flood (backward compatible)
-      sendFlood(pkt);
-      MESH_DEBUG_PRINTLN("Telemetry broadcast (%d bytes, %s) - standard flood", telem_len, channel_type);
-    } else {
-      // Zone configured - use transport codes for zone-based routing
-      uint16_t codes[2];
-      codes[0] = broadcast_zone.calcTransportCode(pkt);
-      codes[1] = 0;  //
-      sendFlood(pkt, codes);
-      MESH_DEBUG_PRINTLN("Telemetry broadcast (%d bytes, %s) - zone: %s", telem_len, channel_type, zone_name);
+int SensorMesh::getBatchCapacity() const {
+  return getTelemBatchCapacity(_extended_prefs.telemetry_format);
+}
+
+// Send all batched readings in the configured format and start a new batch
+bool SensorMesh::flushTelemetryBatch() {
+  if (_batch.isEmpty()) return false;
+
+  LOG_DEBUG("Flushing telemetry batch: %d records", _batch.getNumRecords());
+  bool sent;
+  if (_extended_prefs.telemetry_format == TELEM_SCHEMA_COMPACT) {
+    CompactTelemetryEncoder enc;
+    sent = sendTelemetryBatch(enc);
+  } else {
+    LppBatchEncoder enc;
+    sent = sendTelemetryBatch(enc);
+  }
+  _batch.clear();
+  return sent;
+}
+
+// Encode the retained records in place, starting a new frame whenever the next record does not
+// fit. Records the format cannot carry go out on their own as CayenneLPP.
+bool SensorMesh::sendTelemetryBatch(TelemetryEncoder& enc) {
+  uint8_t frame[MAX_GROUP_DATA_LEN];   // datagram plaintext, the encoder writes the body in place
+  uint32_t frame_time = _batch.getBaseTime();
+  enc.begin(&frame[TELEM_FRAME_HDR], sizeof(frame) - TELEM_FRAME_HDR, frame_time);
+
+  bool sent = false;
+  uint32_t ts;
+  const uint8_t* lpp;
+  uint8_t len;
+  for (int pos = 0; (pos = _batch.next(pos, ts, lpp, len)) >= 0; ) {
+    if (enc.add(ts, lpp, len)) continue;
+    if (enc.getCount() > 0) {
+      sent |= sendTelemetryFrame(frame, frame_time, enc);
+      frame_time = ts;
+      enc.begin(&frame[TELEM_FRAME_HDR], sizeof(frame) - TELEM_FRAME_HDR, frame_time);
+      if (enc.add(ts, lpp, len)) continue;
     }
+    sent |= sendTelemetryReading(ts, lpp, len);
+  }
+  if (enc.getCount() > 0) {
+    sent |= sendTelemetryFrame(frame, frame_time, enc);
+  }
+  return sent;
+}
+
+bool SensorMesh::sendTelemetryReading(uint32_t timestamp, const uint8_t* lpp, uint8_t len) {
+  uint8_t frame[MAX_GROUP_DATA_LEN];
+  LppTelemetryEncoder enc;
+  enc.begin(&frame[TELEM_FRAME_HDR], sizeof(frame) - TELEM_FRAME_HDR, timestamp);
+  if (!enc.add(timestamp, lpp, len)) {
+    LOG_ERROR("telemetry reading too large (%d bytes)", len);
+    return false;
+  }
+  return sendTelemetryFrame(frame, timestamp, enc);
+}
+
+// Fill in the [timestamp u32][flags u8] header in front of the encoded body and flood the frame on
+// the channel picked by resolveTelemetryRoute(), honouring the broadcast zone
+// Returns true if a packet was queued
+bool SensorMesh::sendTelemetryFrame(uint8_t* frame, uint32_t timestamp, const TelemetryEncoder& enc) {
+  prepareRadio();
+
+  // Every Nth telemetry TX tells listeners (gateways) that RX stays open briefly afterwards
+  uint8_t flags = enc.getFlags();
+  if (!_listen_pending && claimListenWindow()) {
+    flags |= TELEM_FLAG_LISTEN;
+    _listen_pending = true;
+  }
+
+  // Note: Padding is handled by encryption layer. CayenneLPP channel 0 marks end of data.
+  memcpy(frame, &timestamp, 4);
+  frame[4] = flags;
+  int body_len = enc.getLength();
+
+  auto pkt = createGroupDatagram(PAYLOAD_TYPE_GRP_DATA, *_telem_channel, frame, TELEM_FRAME_HDR + body_len);
+  if (pkt == NULL) {
+    LOG_ERROR("unable to create telemetry packet!");
+    return false;
+  }
+
+  TRACE(TRACE_TELEM_TX, body_len, flags);
+  const char* channel_type = _telem_channel == &private_channel ? "ENCRYPTED" : "PUBLIC";
+  uint32_t jitter = getTelemetryJitter();
+  if (zone_name[0] == 0) {
+    sendFlood(pkt, jitter);
+    LOG_INFO("Telemetry broadcast (%d bytes, %s) - standard flood", body_len, channel_type);
   } else {
-    MESH_DEBUG_PRINTLN("ERROR: unable to create telemetry packet!");
+    // Zone configured - use transport codes for zone-based routing
+    uint16_t codes[2];
+    codes[0] = broadcast_zone.calcTransportCode(pkt);
+    codes[1] = 0;
+    sendFlood(pkt, codes, jitter);
+    LOG_INFO("Telemetry broadcast (%d bytes, %s) - zone: %s", body_len, channel_type, zone_name);
   }
+  return true;
 }
 
 void SensorMesh::setTxPower(uint8_t power_dbm) {
-  radio_set_tx_power(power_dbm);
+  _link.setMaxPower(power_dbm);   // new ceiling for link adaptation
+  if (_radio_ready) radio_set_tx_power(getEffectiveTxPower());   // otherwise applied from prefs by beginRadio()
+}
+
+/* ------------------------------ Link Adaptation -------------------------------- */
+
+int8_t SensorMesh::getEffectiveTxPower() {
+  return _extended_prefs.link_adapt ? _link.getTxPower() : _prefs.tx_power_dbm;
+}
+
+void SensorMesh::onLinkSample(int8_t snr_x4, bool uplink) {
+  if (!_extended_prefs.link_adapt) return;
+  _link.addSample(snr_x4, uplink);
+  if (_link.update(_prefs.sf, _extended_prefs.link_margin_db)) {
+    TRACE(TRACE_TX_POWER, _link.getTxPower());
+    if (_radio_ready) radio_set_tx_power(getEffectiveTxPower());
+  }
+}
+
+void SensorMesh::recordTxAirtime(uint32_t air_ms) {
+  if (!_extended_prefs.link_adapt) return;
+  if (_link.onTransmit(air_ms)) {
+    TRACE(TRACE_TX_POWER, _link.getTxPower());
+    if (_radio_ready) radio_set_tx_power(getEffectiveTxPower());
+  }
+}
+
+bool SensorMesh::sendLinkProbe() {
+  if (!_radio_ready) return false;
+  uint8_t data[6];
+  data[0] = CTL_TYPE_NODE_DISCOVER_REQ | 1;      // prefix-only responses are enough
+  data[1] = (1 << ADV_TYPE_REPEATER);
+  getRNG()->random((uint8_t*)&_probe_tag, 4);
+  if (_probe_tag == 0) _probe_tag = 1;
+  memcpy(&data[2], &_probe_tag, 4);
+  auto pkt = createControlData(data, sizeof(data));
+  if (pkt == NULL) return false;
+  sendZeroHop(pkt);
+  return true;
 }
 
 void SensorMesh::formatStatsReply(char *reply) {
@@ -980,31 +2189,28 @@ void SensorMesh::formatStatsReply(char *reply) {
 
 void SensorMesh::formatRadioStatsReply(char *reply) {
   StatsFormatHelper::formatRadioStats(reply, _radio, radio_driver, getTotalAirTime(), getReceiveAirTime());
+  if (_extended_prefs.link_adapt) {
+    // extend the JSON object with the adapted power and the TX charge it saved
+    char* end = strrchr(reply, '}');
+    if (end == NULL) end = reply + strlen(reply);
+    sprintf(end, ",\"tx_dbm\":%d,\"link_snr\":%.1f,\"tx_mah_saved\":%.3f}", getEffectiveTxPower(),
+            _link.getLinkSNR(), _link.getSavedMilliAh());
+  }
 }
 
 void SensorMesh::formatPacketStatsReply(char *reply) {
   StatsFormatHelper::formatPacketStats(reply, radio_driver, getNumSentFlood(), getNumSentDirect(), 
                                        getNumRecvFlood(), getNumRecvDirect());
+  // extend the JSON object with the node-discover responses sent and dropped
+  const DiscoverLimitState& disc = discoverLimit();
+  char* end = strrchr(reply, '}');
+  if (end == NULL) end = reply + strlen(reply);
+  sprintf(end, ",\"disc_ok\":%lu,\"disc_dup\":%lu,\"disc_ltd\":%lu}", (unsigned long)disc.answered,
+          (unsigned long)disc.dropped_dup, (unsigned long)(disc.dropped_wake + disc.dropped_rate));
 }
 
 float SensorMesh::getTelemValue(uint8_t channel, uint8_t type) {
-  auto buf = telemetry.getBuffer();
-  uint8_t size = telemetry.getSize();
-  uint8_t i = 0;
-
-  while (i + 2 < size) {
-    // Get channel #
-    uint8_t ch = buf[i++];
-    // Get data type
-    uint8_t t = buf[i++];
-    uint8_t sz = getDataSize(t);
-
-    if (ch == channel && t == type) {
-      return getFloat(&buf[i], sz, getMultiplier(t), isSigned(t));
-    }
-    i += sz;  // skip
-  }
-  return 0.0f;   // not found
+  return getLPPValue(telemetry.getBuffer(), telemetry.getSize(), channel, type);
 }
 
 bool  SensorMesh::getGPS(uint8_t channel, float& lat, float& lon, float& alt) {
@@ -1019,7 +2225,21 @@ bool  SensorMesh::getGPS(uint8_t channel, float& lat, float& lon, float& alt) {
 }
 
 void SensorMesh::loop() {
-  mesh::Mesh::loop();
+  if (_radio_ready) mesh::Mesh::loop();
+}
+
+bool SensorMesh::hasPendingWork() {
+  // queued packets (including ones scheduled for later) need loop() to start their TX,
+  // and a TX in progress needs loop() to notice completion
+  return getPendingTxCount() > 0 || (_radio_ready && !_radio->isInRecvMode());
+}
+
+bool SensorMesh::isTxDue() {
+  return _mgr->getOutboundCount(_ms->getMillis()) > 0 || (_radio_ready && !_radio->isInRecvMode());
+}
+
+int SensorMesh::getPendingTxCount() {
+  return _mgr->getOutboundCount(0xFFFFFFFF);
 }
 
 /* ==================== Zone Management for Transport Codes ====================
@@ -1061,33 +2281,42 @@ void SensorMesh::setBroadcastZone(const char* name) {
     return;
   }
 
-  // Store zone name
-  strncpy(zone_name, name, sizeof(zone_name) - 1);
-  zone_name[sizeof(zone_name) - 1] = 0;
-
-  // Calculate transport key from zone name using SHA256
-  SHA256 sha;
-  sha.reset();
-  sha.update(name, strlen(name));
-  sha.finalize(broadcast_zone.key, sizeof(broadcast_zone.key));
+  applyBroadcastZone(name);
 
   // Persist zone name to extended preferences
   strncpy(_extended_prefs.broadcast_zone_name, zone_name, sizeof(_extended_prefs.broadcast_zone_name) - 1);
   _extended_prefs.broadcast_zone_name[sizeof(_extended_prefs.broadcast_zone_name) - 1] = 0;
   savePrefs();  // Save to filesystem
 
-  MESH_DEBUG_PRINTLN("Broadcast zone set to: %s (persisted)", zone_name);
+  LOG_DEBUG("Broadcast zone set to: %s (persisted)", zone_name);
 }
 
 void SensorMesh::clearBroadcastZone() {
-  zone_name[0] = 0;
-  memset(broadcast_zone.key, 0, sizeof(broadcast_zone.key));
+  applyBroadcastZone(NULL);
 
   // Persist cleared state to extended preferences
   _extended_prefs.broadcast_zone_name[0] = 0;
   savePrefs();  // Save to filesystem
 
-  MESH_DEBUG_PRINTLN("Broadcast zone cleared (using standard flood, persisted)");
+  LOG_DEBUG("Broadcast zone cleared (using standard flood, persisted)");
+}
+
+void SensorMesh::applyBroadcastZone(const char* name) {
+  if (name == NULL || strlen(name) == 0) {
+    zone_name[0] = 0;
+    memset(broadcast_zone.key, 0, sizeof(broadcast_zone.key));
+    return;
+  }
+
+  // Store zone name
+  strncpy(zone_name, name, sizeof(zone_name) - 1);
+  zone_name[sizeof(zone_name) - 1] = 0;
+
+  // Calculate transport key from zone name using SHA256
+  SHA256 sha;
+  sha.reset();
+  sha.update(name, strlen(name));
+  sha.finalize(broadcast_zone.key, sizeof(broadcast_zone.key));
 }
 
 /* ==================== Private Channel Management ====================
@@ -1109,42 +2338,63 @@ void SensorMesh::setPrivateChannel(const char* psk_base64) {
     return;
   }
 
-  // Decode base64 PSK (following BaseChatMesh::addChannel pattern)
-  memset(private_channel.secret, 0, sizeof(private_channel.secret));
-  int decoded_len = decode_base64((unsigned char*)psk_base64, strlen(psk_base64),
-                                   private_channel.secret);
-
-  // Validate PSK length (must be 16 or 32 bytes for AES-128/256)
-  if (decoded_len != 16 && decoded_len != 32) {
-    MESH_DEBUG_PRINTLN("ERROR: Invalid PSK length (%d bytes). Must be 16 or 32 bytes.", decoded_len);
+  int decoded_len = applyPrivateChannel(psk_base64);
+  if (decoded_len == 0) {
     clearPrivateChannel();
     return;
   }
 
-  // Compute SHA-256 hash of secret (for channel identification)
-  mesh::Utils::sha256(private_channel.hash, sizeof(private_channel.hash),
-                      private_channel.secret, decoded_len);
-
-  // Enable private channel
-  private_channel_enabled = true;
+  resolveTelemetryRoute();
 
   // Persist to extended preferences
   strncpy(_extended_prefs.private_channel_psk, psk_base64, sizeof(_extended_prefs.private_channel_psk) - 1);
   _extended_prefs.private_channel_psk[sizeof(_extended_prefs.private_channel_psk) - 1] = 0;
   savePrefs();  // Save to filesystem
 
-  MESH_DEBUG_PRINTLN("Private channel enabled (%d-bit key, persisted)", decoded_len * 8);
+  LOG_DEBUG("Private channel enabled (%d-bit key, persisted)", decoded_len * 8);
 }
 
 void SensorMesh::clearPrivateChannel() {
-  private_channel_enabled = false;
-  memset(&private_channel, 0, sizeof(private_channel));
+  applyPrivateChannel(NULL);
+  resolveTelemetryRoute();
 
   // Persist cleared state to extended preferences
   _extended_prefs.private_channel_psk[0] = 0;
   savePrefs();  // Save to filesystem
 
-  MESH_DEBUG_PRINTLN("Private channel disabled (using public broadcast, persisted)");
+  LOG_DEBUG("Private channel disabled (using public broadcast, persisted)");
+}
+
+int SensorMesh::applyPrivateChannel(const char* psk_base64) {
+  private_channel_enabled = false;
+  memset(&private_channel, 0, sizeof(private_channel));
+  if (psk_base64 == NULL || strlen(psk_base64) == 0) {
+    return 0;
+  }
+
+  // Decode base64 PSK (following BaseChatMesh::addChannel pattern)
+  int decoded_len = decode_base64((unsigned char*)psk_base64, strlen(psk_base64),
+                                   private_channel.secret);
+
+  // Validate PSK length (must be 16 or 32 bytes for AES-128/256)
+  if (decoded_len != 16 && decoded_len != 32) {
+    LOG_ERROR("Invalid PSK length (%d bytes). Must be 16 or 32 bytes.", decoded_len);
+    memset(&private_channel, 0, sizeof(private_channel));
+    return 0;
+  }
+
+  // Compute SHA-256 hash of secret (for channel identification)
+  mesh::Utils::sha256(private_channel.hash, sizeof(private_channel.hash),
+                      private_channel.secret, decoded_len);
+
+  // Enable private channel
+  private_channel_enabled = true;
+  return decoded_len;
+}
+
+// Telemetry goes out on the private channel when one is configured, otherwise on the public one
+void SensorMesh::resolveTelemetryRoute() {
+  _telem_channel = private_channel_enabled ? &private_channel : &public_channel;
 }
 
 const char* SensorMesh::getBroadcastZoneName() const {
@@ -13,7 +13,6 @@
 
 #include <helpers/ArduinoHelpers.h>
 #include <helpers/StaticPoolPacketManager.h>
-#include <helpers/SimpleMeshTables.h>
 #include <helpers/IdentityStore.h>
 #include <helpers/AdvertDataHelpers.h>
 #include <helpers/TxtDataHelpers.h>
@@ -23,15 +22,85 @@
 #include <helpers/TransportKeyStore.h>
 #include <RTClib.h>
 #include <target.h>
+#include <LogLevel.h>
+#include <EventTrace.h>
+#include "MemoryProfile.h"
+#include "SensorMeshTables.h"
+#include "SensorStats.h"
+#include "TelemetryLog.h"
+#include "TelemetryBatch.h"
+#include "TelemetryEncoder.h"
+#include "WakeCycle.h"          // MAX_GROUP_DATA_LEN, MAX_BATCH_WAKES
+#include "LinkAdapter.h"
+#include "SampleScheduler.h"
+#include "ConfigJournal.h"
+#include <GpsDutyCycle.h>
+
+#define MAX_DEADBANDS   8
+
+// Sleep interval range; multi-day intervals use the RTC's long timer / calendar alarm
+#define SLEEP_INTERVAL_MIN_SECS   5     // short intervals sleep in System ON (see RAK4631Board::prefersSystemOn)
+#define SLEEP_INTERVAL_MAX_SECS   (7 * 86400UL)
+
+// Downlink listen window range
+#define LISTEN_WINDOW_MIN_MS      100
+#define LISTEN_WINDOW_MAX_MS      5000
+
+// Node-discover responses: token bucket over RTC time (kept in retained RAM) plus a per-wake cap
+#ifndef DISCOVER_RATE_SECS
+  #define DISCOVER_RATE_SECS      30    // one token refills every N seconds
+#endif
+#ifndef DISCOVER_BURST
+  #define DISCOVER_BURST          4     // bucket size; a prefix-only response costs 1, a full key 2
+#endif
+#ifndef DISCOVER_WAKE_BUDGET
+  #define DISCOVER_WAKE_BUDGET    2     // responses per wake, however full the bucket
+#endif
+#define DISCOVER_TAG_HISTORY      4     // recent request tags, a repeated tag is not answered again
+
+// Telemetry sample sources: called in registration order to build each wake's reading
+#ifndef MAX_TELEMETRY_SOURCES
+  #define MAX_TELEMETRY_SOURCES   8
+#endif
+typedef void (*TelemetrySourceFn)(void* ctx, CayenneLPP& lpp);
+
+// Send-on-delta threshold for one CayenneLPP channel
+struct DeadbandEntry {
+  uint8_t channel;                    // LPP channel number (0 = unused slot)
+  float threshold;                    // report when any value on the channel moves more than this
+};
 
 // Extended preferences for sleeping sensor (separate from core NodePrefs)
 // Stored in /com_prefs_ext to allow core NodePrefs to grow independently
 struct SensorExtendedPrefs {
-  uint16_t sleep_interval_secs;       // Sleep interval (60-3600 seconds)
+  uint32_t sleep_interval_secs;       // Sleep interval (SLEEP_INTERVAL_MIN_SECS-SLEEP_INTERVAL_MAX_SECS), low 16 bits at offset 0
   uint8_t wakeups_per_advert;         // Wakeups between advertisements (1-255)
   uint8_t _pad;                       // Alignment padding
   char broadcast_zone_name[32];       // Transport zone name for selective forwarding
   char private_channel_psk[48];       // Base64 PSK for private channels (16 or 32 bytes)
+  // --- appended fields (older files simply end before these, defaults are kept) ---
+  uint8_t batch_wakes;                // Wake cycles per batched telemetry packet (1 = no batching)
+  uint8_t heartbeat_wakes;            // Send-on-delta: force a report every N wakes (1 = report every wake)
+  DeadbandEntry deadbands[MAX_DEADBANDS];  // Send-on-delta per-channel thresholds
+  uint8_t lazy_radio;                 // 1 = keep SX1262 powered off on RTC wakes until something is sent
+  uint16_t stats_window_mins;         // Length of one statistics bucket (history = STATS_NUM_BUCKETS windows)
+  uint8_t telemetry_log;              // 1 = record every reading in the flash ring log (log start/stop)
+  uint8_t energy_telemetry;           // 1 = add previous wake's awake ms / uAh estimate to the telemetry
+  uint32_t sensor_presence;           // Drivers that found hardware at the last full probe (0 = never probed)
+  // sleep_interval_secs high 16 bits follow in the file
+  uint8_t tx_slotting;                // 1 = wake at a per-node phase within the interval (from pub_key)
+  uint16_t slot_width_secs;           // Phase granularity; 0 = any second of the interval
+  uint8_t listen_every;               // Open a downlink listen window after every Nth telemetry TX (0 = never)
+  uint16_t listen_window_ms;          // Length of that window (LISTEN_WINDOW_MIN_MS-LISTEN_WINDOW_MAX_MS)
+  uint8_t telemetry_format;           // Batch body schema: TELEM_SCHEMA_LPP or TELEM_SCHEMA_COMPACT
+  uint8_t link_adapt;                 // 1 = step TX power down from observed SNR (tx_power_dbm is the ceiling)
+  uint8_t link_margin_db;             // SNR kept above the SF demodulation floor (0-LINK_MARGIN_MAX_DB)
+  uint8_t samples_per_wake;           // Default schedule of sample channels declared with count 0 (battery)
+  uint16_t sample_spacing_ms;         // ... and the spacing between those samples
+  SampleSchedule sample_schedules[SAMPLE_MAX_OVERRIDES];   // Per-channel schedule overrides ("sample ch")
+  uint8_t gps_fix_wakes;              // GPS duty cycle: search for a fix every N wakes (0 = every wake)
+  uint8_t gps_fix_secs;               // ... holding the wake up to this long for it (1-GPS_FIX_MAX_SECS)
+  uint8_t event_wake;                 // 1 = arm the wake source pins (addWakeSource()) before sleep
 };
 
 // Template specialization for extended prefs serialization
@@ -69,6 +138,8 @@ struct ExtendedPrefsSerializer<SensorExtendedPrefs> {
 
 #define FIRMWARE_ROLE "sensor"
 
+#define LINK_MARGIN_MAX_DB   30
+
 #define MAX_SEARCH_RESULTS      8
 // MAX_CONCURRENT_ALERTS removed - alert system not compatible with sleeping nodes
 
@@ -85,9 +156,17 @@ struct ExtendedPrefsSerializer<SensorExtendedPrefs> {
 class SensorMesh : public mesh::Mesh, public CommonCLICallbacks {
 public:
   SensorMesh(mesh::MainBoard& board, mesh::Radio& radio, mesh::MillisecondClock& ms, mesh::RNG& rng, mesh::RTCClock& rtc, mesh::MeshTables& tables);
-  void begin(FILESYSTEM* fs);
+  void begin(FILESYSTEM* fs, bool fs_mounted = true);
+  bool restoreBootSnapshot();   // warm wake: restore prefs/ACL/identity/keys from retained RAM
+  void beginRadio();            // start the dispatcher and apply radio prefs (radio must be powered and initialised)
+  bool isRadioReady() const { return _radio_ready; }
+  void endRadio() { _radio_ready = false; }   // radio about to lose power, beginRadio() again before use
   void loop();
+  bool hasPendingWork();   // outbound packets queued or TX in progress
+  bool isTxDue();          // a queued packet is due now, or TX in progress
+  int getPendingTxCount(); // queued outbound packets (any schedule time)
   void handleCommand(uint32_t sender_timestamp, char* command, char* reply);
+  void handleCommandBatch(uint32_t sender_timestamp, char* commands, char* reply, int max_len);   // newline-separated, one packed reply
 
   // CommonCLI callbacks
   const char* getFirmwareVer() override { return FIRMWARE_VERSION; }
@@ -96,15 +175,15 @@ public:
   const char* getNodeName() { return _prefs.node_name; }
   NodePrefs* getNodePrefs() { return &_prefs; }
   SensorExtendedPrefs* getExtendedPrefs() { return &_extended_prefs; }
-  void savePrefs() override;
+  void savePrefs() override;   // deferred: written by flushConfig()
+  void flushConfig();           // journal (or compact) pending prefs/ACL changes, call before sleep
   bool formatFileSystem() override;
   void sendSelfAdvertisement(int delay_millis) override;
-  void broadcastTelemetry();  // Broadcast sensor data via group message
   void updateAdvertTimer() override { /* Empty stub - time-based ads removed for sleeping nodes */ }
   void updateFloodAdvertTimer() override { /* Empty stub - time-based ads removed for sleeping nodes */ }
-  void setLoggingOn(bool enable) override {  }
-  void eraseLogFile() override { }
-  void dumpLogFile() override { }
+  void setLoggingOn(bool enable) override;   // telemetry ring log on/off (persisted)
+  void eraseLogFile() override;
+  void dumpLogFile() override;
   void setTxPower(uint8_t power_dbm) override;
   void formatNeighborsReply(char *reply) override {
     strcpy(reply, "not supported");
@@ -118,7 +197,37 @@ public:
   void applyTempRadioParams(float freq, float bw, uint8_t sf, uint8_t cr, int timeout_mins) override;
 
   float getTelemValue(uint8_t channel, uint8_t type);
-  int getSleepInterval(uint8_t default_value);
+
+  // Send-on-delta: compare a reading against the last reported one (kept in retained RAM)
+  bool shouldReportTelemetry(const uint8_t* lpp, uint8_t len);   // a deadband was exceeded, layout changed or heartbeat due
+  void onTelemetryReported(const uint8_t* lpp, uint8_t len);     // reading was sent/batched, make it the new baseline
+
+  // Streaming statistics (served via REQ_TYPE_GET_AVG_MIN_MAX)
+  void recordTelemetry(const uint8_t* lpp, uint8_t len);         // add each scalar LPP value to the stats engine
+  const SensorStats& getStats() const { return _stats; }
+
+  // Store-and-forward ring log (served via REQ_TYPE_GET_LOG_DATA)
+  void logTelemetry(uint32_t timestamp, const uint8_t* lpp, uint8_t len);
+  uint32_t getSleepInterval(uint32_t default_value);
+  uint32_t getWakePhase(uint32_t interval, uint32_t now);   // offset of this node's wake slot in now's period
+  uint32_t getNextWakeSlot(uint32_t now, uint32_t woke_at, uint32_t interval, bool keep_slot);   // RTC time of the next wake
+
+  // Telemetry pipeline: sources add their values to one reading, broadcastTelemetry() feeds it to
+  // the stats, log and send-on-delta, then batches it or encodes it straight into a group datagram
+  bool addTelemetrySource(TelemetrySourceFn fn, void* ctx = NULL);   // false when all slots are used
+  bool broadcastTelemetry();   // true if a packet was queued (false when suppressed or batched)
+  bool sendEventTelemetry();   // event wake: the reading goes out at once, no send-on-delta or batching
+
+  // Downlink listen window: claimListenWindow() is called once per telemetry TX and returns true
+  // when this one should announce (TELEM_FLAG_LISTEN) and open a window
+  bool claimListenWindow();
+  bool takeListenWindow();   // a telemetry TX this wake announced a window (true once)
+  uint32_t getDownlinkCount() const { return _downlink_count; }   // requests/logins accepted since boot
+
+  // Link adaptation: account this wake's TX airtime (may step power back up on a stale link)
+  void recordTxAirtime(uint32_t air_ms);
+
+  void beginWake();   // System ON wake: reset per-wake state (a reset starts from the constructor)
 
   // Zone management for transport codes
   // Zones enable selective packet forwarding to reduce network congestion
@@ -150,6 +259,7 @@ protected:
 
   virtual void onSensorDataRead() = 0;   // for app to implement
   virtual bool handleCustomCommand(uint32_t sender_timestamp, char* command, char* reply) { return false; }
+  virtual void prepareRadio() { }        // before telemetry is queued, eg. lazy radio power-up
 
   // Mesh overrides
   float getAirtimeBudgetFactor() const override;
@@ -170,6 +280,9 @@ protected:
   // sendAckTo() removed - alert system not compatible with sleeping nodes
 private:
   FILESYSTEM* _fs;
+  bool _fs_mounted;   // false on warm wakes until the first flash write
+  bool _warm_boot;    // true when config came from the retained boot snapshot
+  bool _radio_ready;  // beginRadio() has run, dispatcher owns the radio
   // next_local_advert, next_flood_advert removed - time-based ads incompatible with sleeping nodes
   NodePrefs _prefs;
   SensorExtendedPrefs _extended_prefs;  // Extended preferences in separate file
@@ -178,6 +291,22 @@ private:
   ClientACL  acl;
   // dirty_contacts_expiry removed - ACL changes saved immediately for sleeping nodes
   CayenneLPP telemetry;
+  CayenneLPP _reading;        // this wake's broadcast reading, sized to fit one batch record
+  TelemetryBatch _batch;
+  struct { TelemetrySourceFn fn; void* ctx; } _sources[MAX_TELEMETRY_SOURCES];
+  uint8_t _num_sources;
+  bool _listen_pending;       // a telemetry TX this wake claimed the listen window
+  int32_t _tx_jitter_ms;      // telemetry TX delay within the wake slot, drawn on first use (-1 = not yet)
+  SensorStats _stats;
+  TelemetryLog _log;
+  ConfigJournal _journal;
+  uint8_t _reply_budget;      // max reply_data bytes that fit the response packet for the current request
+  bool _cli_batch;            // handleCommandBatch() running: savePrefs() waits for the end of the batch
+  bool _cli_batch_dirty;      // a command of the batch changed prefs
+  uint32_t _downlink_count;
+  LinkAdapter _link;
+  uint32_t _probe_tag;        // tag of our last discover request (0 = none outstanding)
+  uint8_t _discover_replies;  // discover responses sent this wake
   // last_read_time removed - sensor reading handled by main.cpp state machine for sleeping nodes
   int matching_peer_indexes[MAX_SEARCH_RESULTS];
   // num_alert_tasks and alert_tasks removed - alert system not compatible with sleeping nodes
@@ -190,6 +319,33 @@ private:
   // Private channel for encrypted telemetry broadcasts
   mesh::GroupChannel private_channel;
   bool private_channel_enabled;
+  mesh::GroupChannel public_channel;            // all zeros
+  const mesh::GroupChannel* _telem_channel;     // private_channel or public_channel, see resolveTelemetryRoute()
+
+  void loadPrefsFromFS();
+  void ensureFS();
+  void saveACL(int client_idx = -1);   // one changed entry, or -1 when entries were added/removed
+  void compactConfig();                 // rewrite the base prefs/ACL files and empty the journal
+  void markConfigPersisted();           // current config is what flash holds
+  static void applyJournalRecord(void* ctx, uint8_t kind, uint16_t offset, const uint8_t* data, uint16_t len);
+  bool allowDiscoverReply(uint32_t tag, uint8_t cost);   // rate limit, per-wake cap, repeated tags
+  void saveBootSnapshot();
+  uint32_t getWakeKey() const;          // per-node input of the wake slot hash
+  uint32_t getTelemetryJitter();
+  void endCLIBatch();                   // save prefs once if the batch changed them
+  void invalidateBootSnapshot();
+  void applyBroadcastZone(const char* name);      // derive transport key only (no persist)
+  int applyPrivateChannel(const char* psk_base64);  // decode PSK only (no persist), returns key length or 0
+  void resolveTelemetryRoute();                   // pick the telemetry channel after a channel change
+  uint8_t collectReading(uint32_t timestamp);      // run the sources into _reading, stats + log
+  int getBatchCapacity() const;
+  bool flushTelemetryBatch();
+  bool sendTelemetryBatch(TelemetryEncoder& enc);
+  bool sendTelemetryReading(uint32_t timestamp, const uint8_t* lpp, uint8_t len);
+  bool sendTelemetryFrame(uint8_t* frame, uint32_t timestamp, const TelemetryEncoder& enc);
+  int8_t getEffectiveTxPower();                   // adapted power, or tx_power_dbm when link adaptation is off
+  void onLinkSample(int8_t snr_x4, bool uplink);  // feed the link adapter, apply a changed TX power
+  bool sendLinkProbe();                           // zero-hop discover request, responses carry our uplink SNR
 
   uint8_t handleLoginReq(const mesh::Identity& sender, const uint8_t* secret, uint32_t sender_timestamp, const uint8_t* data);
   uint8_t handleRequest(uint8_t perms, uint32_t sender_timestamp, uint8_t req_type, uint8_t* payload, size_t payload_len);
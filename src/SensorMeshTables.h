@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Mesh.h>
+#include <string.h>
+
+/**
+ * Duplicate-packet tables with compile-time sizes
+ *
+ * Same behaviour as MeshCore's SimpleMeshTables (cyclic tables of recent packet hashes and
+ * ACK CRCs), but sized per build instead of for a repeater. A node seeing a few packets per
+ * wake only needs to remember a few dozen.
+ */
+template<int NUM_HASHES, int NUM_ACKS>
+class SensorMeshTables : public mesh::MeshTables {
+  uint8_t _hashes[NUM_HASHES * MAX_HASH_SIZE];
+  int _next_idx;
+  uint32_t _acks[NUM_ACKS];
+  int _next_ack_idx;
+
+public:
+  SensorMeshTables() {
+    memset(_hashes, 0, sizeof(_hashes));
+    _next_idx = 0;
+    memset(_acks, 0, sizeof(_acks));
+    _next_ack_idx = 0;
+  }
+
+  bool hasSeen(const mesh::Packet* packet) override {
+    if (packet->getPayloadType() == PAYLOAD_TYPE_ACK) {
+      uint32_t ack;
+      memcpy(&ack, packet->payload, 4);
+      for (int i = 0; i < NUM_ACKS; i++) {
+        if (ack == _acks[i]) return true;
+      }
+      _acks[_next_ack_idx] = ack;
+      _next_ack_idx = (_next_ack_idx + 1) % NUM_ACKS;   // cyclic table
+      return false;
+    }
+
+    uint8_t hash[MAX_HASH_SIZE];
+    packet->calculatePacketHash(hash);
+    const uint8_t* sp = _hashes;
+    for (int i = 0; i < NUM_HASHES; i++, sp += MAX_HASH_SIZE) {
+      if (memcmp(hash, sp, MAX_HASH_SIZE) == 0) return true;
+    }
+    memcpy(&_hashes[_next_idx * MAX_HASH_SIZE], hash, MAX_HASH_SIZE);
+    _next_idx = (_next_idx + 1) % NUM_HASHES;
+    return false;
+  }
+
+  void clear(const mesh::Packet* packet) override {
+    if (packet->getPayloadType() == PAYLOAD_TYPE_ACK) {
+      uint32_t ack;
+      memcpy(&ack, packet->payload, 4);
+      for (int i = 0; i < NUM_ACKS; i++) {
+        if (ack == _acks[i]) {
+          _acks[i] = 0;
+          break;
+        }
+      }
+    } else {
+      uint8_t hash[MAX_HASH_SIZE];
+      packet->calculatePacketHash(hash);
+      uint8_t* sp = _hashes;
+      for (int i = 0; i < NUM_HASHES; i++, sp += MAX_HASH_SIZE) {
+        if (memcmp(hash, sp, MAX_HASH_SIZE) == 0) {
+          memset(sp, 0, MAX_HASH_SIZE);
+          break;
+        }
+      }
+    }
+  }
+};
@@ -0,0 +1,138 @@
+#include "SensorStats.h"
+#include <Arduino.h>
+#include <MeshCore.h>
+#include <RetainedRAM.h>
+#include <LogLevel.h>
+
+#define SENSOR_STATS_MAGIC   0x54415453   // 'STAT'
+
+struct StatsBucket {
+  uint32_t start_time;    // 0 = unused
+  StatsAccumulator acc[STATS_MAX_CHANNELS];
+};
+
+struct SensorStatsData {
+  uint32_t window_secs;
+  uint8_t num_channels;
+  uint8_t head;           // bucket currently being filled
+  uint8_t channels[STATS_MAX_CHANNELS];
+  uint8_t types[STATS_MAX_CHANNELS];
+  StatsBucket buckets[STATS_NUM_BUCKETS];
+};
+
+static RETAINED_RAM RetainedBlock<SensorStatsData, SENSOR_STATS_MAGIC> stats;
+
+void StatsAccumulator::add(float value) {
+  if (count == 0) {
+    min = max = value;
+  } else {
+    if (value < min) min = value;
+    if (value > max) max = value;
+  }
+  count++;
+  float delta = value - mean;
+  mean += delta / count;
+  m2 += delta * (value - mean);
+}
+
+void StatsAccumulator::merge(const StatsAccumulator& other) {
+  if (other.count == 0) return;
+  if (count == 0) {
+    *this = other;
+    return;
+  }
+  uint32_t n = count + other.count;
+  float delta = other.mean - mean;
+  mean += delta * other.count / n;
+  m2 += other.m2 + delta * delta * ((float)count * other.count / n);
+  if (other.min < min) min = other.min;
+  if (other.max > max) max = other.max;
+  count = n;
+}
+
+void SensorStats::begin(uint32_t window_secs) {
+  stats.retain();
+  if (!stats.isValid() || stats.data.window_secs != window_secs) {
+    clear();
+    stats.data.window_secs = window_secs;
+    stats.commit();
+  } else {
+    LOG_DEBUG("Sensor stats restored: %d channels", stats.data.num_channels);
+  }
+}
+
+void SensorStats::clear() {
+  uint32_t window = stats.data.window_secs;
+  memset(&stats.data, 0, sizeof(stats.data));
+  stats.data.window_secs = window;
+  stats.commit();
+}
+
+uint32_t SensorStats::getWindowSecs() const {
+  return stats.data.window_secs;
+}
+
+bool SensorStats::add(uint8_t channel, uint8_t lpp_type, float value, uint32_t now) {
+  SensorStatsData& d = stats.data;
+  if (d.window_secs == 0) return false;
+
+  // find (or allocate) the channel slot
+  int slot = -1;
+  for (int i = 0; i < d.num_channels; i++) {
+    if (d.channels[i] == channel && d.types[i] == lpp_type) { slot = i; break; }
+  }
+  if (slot < 0) {
+    if (d.num_channels >= STATS_MAX_CHANNELS) return false;
+    slot = d.num_channels++;
+    d.channels[slot] = channel;
+    d.types[slot] = lpp_type;
+  }
+
+  uint32_t bucket_start = now - (now % d.window_secs);
+  StatsBucket* b = &d.buckets[d.head];
+  if (b->start_time > bucket_start) {
+    // RTC went backwards (eg. clock was set) - history is meaningless now
+    LOG_DEBUG("Sensor stats: clock moved backwards, clearing");
+    clear();
+    return add(channel, lpp_type, value, now);
+  }
+  if (b->start_time != bucket_start) {
+    if (b->start_time != 0) {
+      d.head = (d.head + 1) % STATS_NUM_BUCKETS;
+      b = &d.buckets[d.head];
+    }
+    memset(b, 0, sizeof(*b));
+    b->start_time = bucket_start;
+  }
+
+  b->acc[slot].add(value);
+  stats.commit();
+  return true;
+}
+
+int SensorStats::query(uint32_t now, uint32_t start_secs_ago, uint32_t end_secs_ago, StatsSummary dest[], int max_num) const {
+  const SensorStatsData& d = stats.data;
+  if (start_secs_ago < end_secs_ago) {   // accept either order
+    uint32_t t = start_secs_ago; start_secs_ago = end_secs_ago; end_secs_ago = t;
+  }
+  uint32_t from = now > start_secs_ago ? now - start_secs_ago : 0;
+  uint32_t to = now > end_secs_ago ? now - end_secs_ago : 0;
+
+  int n = 0;
+  for (int c = 0; c < d.num_channels && n < max_num; c++) {
+    StatsSummary& s = dest[n];
+    memset(&s, 0, sizeof(s));
+    s.channel = d.channels[c];
+    s.lpp_type = d.types[c];
+
+    for (int i = 0; i < STATS_NUM_BUCKETS; i++) {
+      const StatsBucket& b = d.buckets[i];
+      if (b.start_time == 0) continue;
+      if (b.start_time <= to && b.start_time + d.window_secs > from) {
+        s.acc.merge(b.acc[c]);
+      }
+    }
+    if (s.acc.count > 0) n++;
+  }
+  return n;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Streaming per-channel statistics, kept in retained RAM across system-off
+ *
+ * Values are accumulated with Welford's algorithm (count, mean, M2, min, max) into a ring of
+ * time buckets, one bucket per configured window. Queries merge every bucket overlapping the
+ * requested time range, so a gateway can ask for "the last 6 hours" and get one summary per
+ * channel without the node storing individual samples.
+ */
+#define STATS_MAX_CHANNELS   8
+#define STATS_NUM_BUCKETS   12
+
+struct StatsAccumulator {
+  uint32_t count;
+  float mean;
+  float m2;       // sum of squared differences from the mean
+  float min;
+  float max;
+
+  void add(float value);
+  void merge(const StatsAccumulator& other);   // Chan et al. parallel combination
+  float variance() const { return count > 1 ? m2 / (count - 1) : 0.0f; }
+};
+
+struct StatsSummary {
+  uint8_t channel;
+  uint8_t lpp_type;
+  StatsAccumulator acc;
+};
+
+class SensorStats {
+public:
+  /**
+   * Register the retained block, discard it if it is invalid or was built with another window
+   * @param window_secs  length of one bucket
+   */
+  void begin(uint32_t window_secs);
+
+  /**
+   * Add one value observed at RTC time 'now'
+   * @return false if all channel slots are taken by other channels
+   */
+  bool add(uint8_t channel, uint8_t lpp_type, float value, uint32_t now);
+
+  /**
+   * Merge all buckets overlapping [now - start_secs_ago, now - end_secs_ago]
+   * @return number of summaries written to dest
+   */
+  int query(uint32_t now, uint32_t start_secs_ago, uint32_t end_secs_ago, StatsSummary dest[], int max_num) const;
+
+  void clear();
+  uint32_t getWindowSecs() const;
+  uint32_t getHistorySecs() const { return getWindowSecs() * STATS_NUM_BUCKETS; }
+};
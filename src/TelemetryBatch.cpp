@@ -0,0 +1,78 @@
+#include "TelemetryBatch.h"
+#include <Arduino.h>
+#include <MeshCore.h>
+#include <RetainedRAM.h>
+#include <LogLevel.h>
+#include "MemoryProfile.h"   // TELEM_BATCH_BUF_SIZE
+
+#define TELEM_BATCH_MAGIC      0x48544142   // 'BATH'
+
+struct TelemetryBatchData {
+  uint32_t base_time;     // timestamp of the first record
+  uint8_t num_records;
+  uint8_t wakes;          // wake cycles accumulated
+  uint16_t len;           // bytes used in buf (records only)
+  uint8_t buf[TELEM_BATCH_BUF_SIZE];
+};
+
+static RETAINED_RAM RetainedBlock<TelemetryBatchData, TELEM_BATCH_MAGIC> batch;
+
+void TelemetryBatch::begin(int capacity) {
+  setCapacity(capacity);
+  batch.retain();
+  if (!batch.isValid()) {
+    clear();
+  } else {
+    LOG_DEBUG("Telemetry batch restored: %d records over %d wakes", batch.data.num_records, batch.data.wakes);
+  }
+}
+
+void TelemetryBatch::setCapacity(int capacity) {
+  _capacity = capacity < TELEM_BATCH_BUF_SIZE ? capacity : TELEM_BATCH_BUF_SIZE;
+}
+
+bool TelemetryBatch::fits(uint8_t lpp_len) const {
+  // 1 byte for the record count prefix
+  return 1 + batch.data.len + TELEM_BATCH_RECORD_HDR + lpp_len <= _capacity;
+}
+
+bool TelemetryBatch::append(uint32_t timestamp, const uint8_t* lpp, uint8_t len) {
+  TelemetryBatchData& d = batch.data;
+  if (!fits(len) || d.num_records == 0xFF) return false;
+
+  if (d.num_records == 0) {
+    d.base_time = timestamp;
+  }
+  uint32_t dt = timestamp >= d.base_time ? timestamp - d.base_time : 0;
+  if (dt > 0xFFFF) return false;   // ~18 hours, base would overflow - caller flushes
+
+  d.buf[d.len++] = dt & 0xFF;
+  d.buf[d.len++] = (dt >> 8) & 0xFF;
+  d.buf[d.len++] = len;
+  memcpy(&d.buf[d.len], lpp, len);
+  d.len += len;
+  d.num_records++;
+  d.wakes++;
+  batch.commit();
+  return true;
+}
+
+bool TelemetryBatch::isEmpty() const { return batch.data.num_records == 0; }
+uint8_t TelemetryBatch::getNumRecords() const { return batch.data.num_records; }
+uint8_t TelemetryBatch::getWakes() const { return batch.data.wakes; }
+uint32_t TelemetryBatch::getBaseTime() const { return batch.data.base_time; }
+
+int TelemetryBatch::next(int pos, uint32_t& timestamp, const uint8_t*& lpp, uint8_t& len) const {
+  const TelemetryBatchData& d = batch.data;
+  if (pos < 0 || pos + TELEM_BATCH_RECORD_HDR > d.len) return -1;
+  timestamp = d.base_time + (d.buf[pos] | (d.buf[pos + 1] << 8));
+  len = d.buf[pos + 2];
+  lpp = &d.buf[pos + TELEM_BATCH_RECORD_HDR];
+  pos += TELEM_BATCH_RECORD_HDR + len;
+  return pos <= d.len ? pos : -1;
+}
+
+void TelemetryBatch::clear() {
+  memset(&batch.data, 0, sizeof(batch.data));
+  batch.commit();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Multi-wake telemetry batch, kept in retained RAM across system-off
+ *
+ * Each wake appends one record; the whole batch goes out as a single
+ * PAYLOAD_TYPE_GRP_DATA packet (flags = TELEM_FLAG_BATCH) every K wakes or
+ * when the next record would not fit.
+ *
+ * Wire format (after the 4-byte timestamp + flags header, timestamp = base_time):
+ *   [count u8] then count x { [dt u16 LE, seconds after base_time] [len u8] [CayenneLPP bytes] }
+ * This is also the retained layout (without the count byte); at send time next() walks the
+ * records in place and an encoder (LppBatchEncoder or CompactTelemetryEncoder) writes the frames.
+ */
+#define TELEM_BATCH_RECORD_HDR   3    // dt(2) + len(1)
+
+class TelemetryBatch {
+public:
+  /**
+   * Register the retained block, discard it if the CRC does not match
+   * @param capacity  max batch body bytes (including count byte) that fit one packet
+   */
+  void begin(int capacity);
+  void setCapacity(int capacity);   // eg. larger when the batch is sent in the compact format
+
+  /**
+   * Append one wake's reading
+   * @return false if the record does not fit (caller should flush first)
+   */
+  bool append(uint32_t timestamp, const uint8_t* lpp, uint8_t len);
+
+  bool fits(uint8_t lpp_len) const;
+  bool isEmpty() const;
+  uint8_t getNumRecords() const;
+  uint8_t getWakes() const;
+  uint32_t getBaseTime() const;
+
+  /**
+   * Walk the records in place, start with pos = 0
+   * @return position of the following record, or -1 when there was no record at pos
+   */
+  int next(int pos, uint32_t& timestamp, const uint8_t*& lpp, uint8_t& len) const;
+
+  void clear();
+
+private:
+  int _capacity;
+};
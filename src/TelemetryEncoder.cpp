@@ -0,0 +1,40 @@
+#include "TelemetryEncoder.h"
+#include "TelemetryBatch.h"
+#include <string.h>
+
+void LppTelemetryEncoder::begin(uint8_t* dest, int max_len, uint32_t base_time) {
+  (void)base_time;   // the frame header carries the timestamp
+  _dest = dest;
+  _max_len = max_len;
+  _len = 0;
+}
+
+bool LppTelemetryEncoder::add(uint32_t timestamp, const uint8_t* lpp, uint8_t len) {
+  (void)timestamp;
+  if (_len > 0 || len == 0 || len > _max_len) return false;   // one reading per frame
+  memcpy(_dest, lpp, len);
+  _len = len;
+  return true;
+}
+
+void LppBatchEncoder::begin(uint8_t* dest, int max_len, uint32_t base_time) {
+  _dest = dest;
+  _max_len = max_len;
+  _base_time = base_time;
+  _dest[0] = 0;   // record count
+  _len = 1;
+}
+
+bool LppBatchEncoder::add(uint32_t timestamp, const uint8_t* lpp, uint8_t len) {
+  uint32_t dt = timestamp >= _base_time ? timestamp - _base_time : 0;
+  if (dt > 0xFFFF || _dest[0] == 0xFF) return false;
+  if (_len + TELEM_BATCH_RECORD_HDR + len > _max_len) return false;
+
+  _dest[_len++] = dt & 0xFF;
+  _dest[_len++] = (dt >> 8) & 0xFF;
+  _dest[_len++] = len;
+  memcpy(&_dest[_len], lpp, len);
+  _len += len;
+  _dest[0]++;
+  return true;
+}
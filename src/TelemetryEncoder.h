@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdint.h>
+
+// Telemetry payload: [timestamp u32][flags u8][body]
+#define TELEM_FLAG_BATCH        0x01   // body is a TelemetryBatch (count + time-offset records)
+#define TELEM_FLAG_LISTEN       0x02   // node keeps RX open for listen_window_ms after this packet
+#define TELEM_SCHEMA_SHIFT      4      // bits 4-7: body schema id
+#define TELEM_SCHEMA_MASK       0xF0
+#define TELEM_SCHEMA_LPP        0      // CayenneLPP (single reading or TelemetryBatch records)
+#define TELEM_SCHEMA_COMPACT    1      // CompactTelemetry delta records (always with TELEM_FLAG_BATCH)
+
+#define TELEM_FRAME_HDR         5      // timestamp(4) + flags(1)
+
+/**
+ * Telemetry body encoder: writes readings straight into a frame after its header
+ *
+ * SensorMesh::broadcastTelemetry() picks the encoder for the configured format, feeds it
+ * readings until add() refuses one, sends the frame and starts the next one in the same buffer.
+ */
+class TelemetryEncoder {
+public:
+  virtual ~TelemetryEncoder() { }
+
+  virtual uint8_t getFlags() const = 0;   // TELEM_FLAG_* and schema bits for the header
+
+  /**
+   * Start a body in dest
+   * @param base_time  timestamp placed in the frame header
+   */
+  virtual void begin(uint8_t* dest, int max_len, uint32_t base_time) = 0;
+
+  /**
+   * Append one reading
+   * @return false if it does not fit or the format cannot carry it (body unchanged)
+   */
+  virtual bool add(uint32_t timestamp, const uint8_t* lpp, uint8_t len) = 0;
+
+  virtual int getLength() const = 0;
+  virtual uint8_t getCount() const = 0;
+};
+
+// One CayenneLPP reading, the body is the LPP bytes as-is (flags 0x00)
+class LppTelemetryEncoder : public TelemetryEncoder {
+public:
+  uint8_t getFlags() const override { return 0x00; }
+  void begin(uint8_t* dest, int max_len, uint32_t base_time) override;
+  bool add(uint32_t timestamp, const uint8_t* lpp, uint8_t len) override;
+  int getLength() const override { return _len; }
+  uint8_t getCount() const override { return _len > 0 ? 1 : 0; }
+
+private:
+  uint8_t* _dest;
+  int _max_len;
+  int _len;
+};
+
+// TelemetryBatch records, see TelemetryBatch.h for the layout (TELEM_FLAG_BATCH)
+class LppBatchEncoder : public TelemetryEncoder {
+public:
+  uint8_t getFlags() const override { return TELEM_FLAG_BATCH; }
+  void begin(uint8_t* dest, int max_len, uint32_t base_time) override;
+  bool add(uint32_t timestamp, const uint8_t* lpp, uint8_t len) override;
+  int getLength() const override { return _len; }
+  uint8_t getCount() const override { return _dest[0]; }
+
+private:
+  uint8_t* _dest;
+  int _max_len;
+  int _len;
+  uint32_t _base_time;
+};
@@ -0,0 +1,262 @@
+#include "TelemetryLog.h"
+#include <MeshCore.h>
+#include <RetainedRAM.h>
+#include <LogLevel.h>
+#include "FSUtils.h"
+#include <EventTrace.h>
+
+#define TELEM_LOG_MAGIC   0x474F4C54   // 'TLOG'
+
+struct TelemetryLogState {
+  uint8_t scanned;          // segment headers have been read since power-up
+  uint8_t cur;              // segment being appended to
+  uint32_t cur_seq;         // its sequence number (0 = no segment yet)
+  uint32_t cur_size;        // its file size
+  uint16_t stage_len;
+  uint8_t stage[TLOG_STAGE_SIZE];
+};
+
+static RETAINED_RAM RetainedBlock<TelemetryLogState, TELEM_LOG_MAGIC> log_state;
+
+static void segmentName(char* dest, int idx) {
+  sprintf(dest, "/tlog%d", idx);
+}
+
+static uint32_t readSegmentSeq(FILESYSTEM* fs, int idx) {
+  char name[12];
+  segmentName(name, idx);
+  if (!fs->exists(name)) return 0;
+
+  File f = openRead(fs, name);
+  if (!f) return 0;
+  uint32_t seq = 0;
+  if (f.read((uint8_t*)&seq, 4) != 4) seq = 0;
+  f.close();
+  return seq;
+}
+
+// Collects whole records into a reply buffer, never splitting a run of equal timestamps
+struct RecordCollector {
+  uint8_t* dest;
+  int max_len;
+  int ofs;
+  uint32_t since;
+  uint32_t group_ts;      // timestamp of the current run
+  int group_ofs;          // where that run started in dest
+  bool full;
+
+  // returns false once dest is full
+  bool add(uint32_t ts, const uint8_t* lpp, uint8_t len) {
+    if (ts <= since) return true;
+    if (ofs + TLOG_RECORD_HDR + len > max_len) {
+      // drop a partial run of the same timestamp, unless it is all we have
+      if (ts == group_ts && group_ofs > 0) ofs = group_ofs;
+      full = true;
+      return false;
+    }
+    if (ts != group_ts) {
+      group_ts = ts;
+      group_ofs = ofs;
+    }
+    memcpy(&dest[ofs], &ts, 4);
+    dest[ofs + 4] = len;
+    memcpy(&dest[ofs + TLOG_RECORD_HDR], lpp, len);
+    ofs += TLOG_RECORD_HDR + len;
+    return true;
+  }
+};
+
+void TelemetryLog::begin(FILESYSTEM* fs) {
+  _fs = fs;
+  log_state.retain();
+  if (!log_state.isValid()) {
+    memset(&log_state.data, 0, sizeof(log_state.data));   // segments are re-scanned on first flash access
+    log_state.commit();
+  }
+}
+
+bool TelemetryLog::fits(uint8_t len) const {
+  return log_state.data.stage_len + TLOG_RECORD_HDR + len <= TLOG_STAGE_SIZE;
+}
+
+bool TelemetryLog::hasStaged() const {
+  return log_state.data.stage_len > 0;
+}
+
+bool TelemetryLog::append(uint32_t timestamp, const uint8_t* lpp, uint8_t len) {
+  if (!fits(len)) return false;
+
+  TelemetryLogState& st = log_state.data;
+  memcpy(&st.stage[st.stage_len], &timestamp, 4);
+  st.stage[st.stage_len + 4] = len;
+  memcpy(&st.stage[st.stage_len + TLOG_RECORD_HDR], lpp, len);
+  st.stage_len += TLOG_RECORD_HDR + len;
+  log_state.commit();
+  return true;
+}
+
+void TelemetryLog::scanSegments() {
+  TelemetryLogState& st = log_state.data;
+  if (st.scanned) return;
+
+  st.cur = 0;
+  st.cur_seq = 0;
+  st.cur_size = 0;
+  for (int i = 0; i < TLOG_NUM_SEGMENTS; i++) {
+    uint32_t seq = readSegmentSeq(_fs, i);
+    if (seq > st.cur_seq) {
+      st.cur_seq = seq;
+      st.cur = i;
+    }
+  }
+  if (st.cur_seq > 0) {
+    char name[12];
+    segmentName(name, st.cur);
+    File f = openRead(_fs, name);
+    if (f) {
+      st.cur_size = f.size();
+      f.close();
+    }
+  }
+  st.scanned = 1;
+  log_state.commit();
+  LOG_DEBUG("Telemetry log: segment %d, seq %lu, %lu bytes", st.cur, (unsigned long)st.cur_seq, (unsigned long)st.cur_size);
+}
+
+void TelemetryLog::rotate() {
+  TelemetryLogState& st = log_state.data;
+  if (st.cur_seq > 0) st.cur = (st.cur + 1) % TLOG_NUM_SEGMENTS;
+  st.cur_seq++;
+
+  char name[12];
+  segmentName(name, st.cur);
+  _fs->remove(name);   // oldest segment is recycled
+  File f = openAppend(_fs, name);
+  if (f) {
+    f.write((uint8_t*)&st.cur_seq, 4);
+    f.close();
+  }
+  st.cur_size = 4;
+}
+
+void TelemetryLog::flush() {
+  TelemetryLogState& st = log_state.data;
+  if (st.stage_len == 0 || _fs == NULL) return;
+
+  scanSegments();
+  if (st.cur_seq == 0 || st.cur_size + st.stage_len > TLOG_SEGMENT_SIZE) {
+    rotate();
+  }
+
+  char name[12];
+  segmentName(name, st.cur);
+  File f = openAppend(_fs, name);
+  if (!f) {
+    LOG_ERROR("telemetry log write failed");
+    TRACE(TRACE_FS_ERROR, 1);
+    return;   // keep the staged records for the next attempt
+  }
+  f.write(st.stage, st.stage_len);
+  f.close();
+
+  st.cur_size += st.stage_len;
+  st.stage_len = 0;
+  log_state.commit();
+}
+
+// Segment indexes from oldest to newest
+int TelemetryLog::getSegmentOrder(uint8_t order[]) const {
+  uint32_t seqs[TLOG_NUM_SEGMENTS];
+  int n = 0;
+  for (int i = 0; i < TLOG_NUM_SEGMENTS; i++) {
+    uint32_t seq = readSegmentSeq(_fs, i);
+    if (seq == 0) continue;
+    // insertion sort by seq
+    int j = n++;
+    while (j > 0 && seqs[j - 1] > seq) {
+      seqs[j] = seqs[j - 1];
+      order[j] = order[j - 1];
+      j--;
+    }
+    seqs[j] = seq;
+    order[j] = i;
+  }
+  return n;
+}
+
+int TelemetryLog::read(uint32_t since, uint8_t* dest, int max_len, bool& more) {
+  RecordCollector rc = { dest, max_len, 0, since, 0, 0, false };
+
+  if (_fs) {
+    uint8_t order[TLOG_NUM_SEGMENTS];
+    int n = getSegmentOrder(order);
+    for (int s = 0; s < n && !rc.full; s++) {
+      char name[12];
+      segmentName(name, order[s]);
+      File f = openRead(_fs, name);
+      if (!f) continue;
+
+      uint32_t seq;
+      f.read((uint8_t*)&seq, 4);
+      uint8_t hdr[TLOG_RECORD_HDR];
+      uint8_t lpp[255];
+      while (f.read(hdr, TLOG_RECORD_HDR) == TLOG_RECORD_HDR) {
+        uint32_t ts;
+        memcpy(&ts, hdr, 4);
+        if (ts <= since) {
+          f.seek(f.position() + hdr[4]);   // skip without copying
+          continue;
+        }
+        if (f.read(lpp, hdr[4]) != hdr[4]) break;   // truncated tail (power loss during write)
+        if (!rc.add(ts, lpp, hdr[4])) break;
+      }
+      f.close();
+    }
+  }
+
+  // records not yet flushed are the newest
+  const TelemetryLogState& st = log_state.data;
+  for (int i = 0; i + TLOG_RECORD_HDR <= st.stage_len && !rc.full; ) {
+    uint32_t ts;
+    memcpy(&ts, &st.stage[i], 4);
+    uint8_t len = st.stage[i + 4];
+    rc.add(ts, &st.stage[i + TLOG_RECORD_HDR], len);
+    i += TLOG_RECORD_HDR + len;
+  }
+
+  more = rc.full;
+  return rc.ofs;
+}
+
+void TelemetryLog::erase() {
+  if (_fs) {
+    for (int i = 0; i < TLOG_NUM_SEGMENTS; i++) {
+      char name[12];
+      segmentName(name, i);
+      _fs->remove(name);
+    }
+  }
+  memset(&log_state.data, 0, sizeof(log_state.data));
+  log_state.data.scanned = 1;    // nothing left on flash
+  log_state.commit();
+}
+
+void TelemetryLog::dump(Stream& out) {
+  uint8_t buf[MAX_PACKET_PAYLOAD];
+  uint32_t since = 0;
+  bool more = true;
+  while (more) {
+    int len = read(since, buf, sizeof(buf), more);
+    if (len == 0) break;
+    for (int i = 0; i + TLOG_RECORD_HDR <= len; ) {
+      uint32_t ts;
+      memcpy(&ts, &buf[i], 4);
+      uint8_t rlen = buf[i + 4];
+      out.printf("%lu: ", (unsigned long)ts);
+      mesh::Utils::printHex(out, &buf[i + TLOG_RECORD_HDR], rlen);
+      out.println();
+      since = ts;
+      i += TLOG_RECORD_HDR + rlen;
+    }
+  }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Arduino.h>
+#include <helpers/IdentityStore.h>   // FILESYSTEM
+
+/**
+ * Append-only telemetry ring log on the internal filesystem (store-and-forward)
+ *
+ * Records are staged in retained RAM and written to flash in blocks, so most wakes do not
+ * touch (or even mount) InternalFS. Flash storage is a ring of TLOG_NUM_SEGMENTS files; when
+ * the newest segment is full the oldest one is removed and reused, which bounds the log size
+ * and spreads writes across segments (LittleFS levels wear within the filesystem).
+ *
+ * Segment file: [seq u32] then records
+ * Record:       [timestamp u32 LE][len u8][CayenneLPP bytes]
+ */
+#ifndef TLOG_NUM_SEGMENTS
+  #define TLOG_NUM_SEGMENTS     4
+#endif
+#ifndef TLOG_SEGMENT_SIZE
+  #define TLOG_SEGMENT_SIZE     2048
+#endif
+#define TLOG_STAGE_SIZE         128
+#define TLOG_RECORD_HDR         5    // timestamp(4) + len(1)
+
+class TelemetryLog {
+public:
+  TelemetryLog() : _fs(NULL) { }
+
+  /**
+   * Register the retained staging buffer; the filesystem is only used by flush()/read()/erase()
+   */
+  void begin(FILESYSTEM* fs);
+
+  /**
+   * Stage one reading
+   * @return false if the staging buffer is full (caller must flush() first)
+   */
+  bool append(uint32_t timestamp, const uint8_t* lpp, uint8_t len);
+  bool fits(uint8_t len) const;
+  bool hasStaged() const;
+
+  /**
+   * Write staged records to the current flash segment (filesystem must be mounted)
+   */
+  void flush();
+
+  /**
+   * Copy records with timestamp > since, oldest first, as whole records
+   * Records sharing a timestamp are never split across calls, so 'since' = last timestamp
+   * returned is a safe resume cursor.
+   * @param more  set true if records remain after what fitted
+   * @return number of bytes written to dest
+   */
+  int read(uint32_t since, uint8_t* dest, int max_len, bool& more);
+
+  void erase();
+  void dump(Stream& out);
+
+private:
+  FILESYSTEM* _fs;
+
+  void scanSegments();
+  void rotate();
+  int getSegmentOrder(uint8_t order[]) const;
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <MeshCore.h>
+#include "MemoryProfile.h"      // TELEM_BATCH_BUF_SIZE
+#include "TelemetryBatch.h"     // TELEM_BATCH_RECORD_HDR
+#include "TelemetryEncoder.h"   // TELEM_FRAME_HDR, TELEM_SCHEMA_*
+
+/**
+ * Wake cycle decisions, shared by the firmware (main.cpp loop(), SensorMesh) and the host simulation
+ *
+ * Only the pure parts live here: the limits of a wake, the state transitions of loop() and the
+ * telemetry batching limits. What each state does (sampling, TX, sleep entry) stays with the
+ * caller, so sim/SimNode and main.cpp take the same decisions from the same code.
+ */
+#define MAX_AWAKE_TIME_MS    (1 * 60 * 1000UL)   // safety net: forced sleep after this long awake
+#define ADVERT_TX_DELAY_MS   500                 // short flood delay so the advert leaves before sleep
+#define TX_DRAIN_TIMEOUT_MS  5000                // upper bound on waiting for the outbound queue
+
+// Largest group datagram plaintext: payload minus channel hash and MAC, rounded down to whole AES blocks
+#define MAX_GROUP_DATA_LEN   (((MAX_PACKET_PAYLOAD - PATH_HASH_SIZE - CIPHER_MAC_SIZE) / CIPHER_BLOCK_SIZE) * CIPHER_BLOCK_SIZE)
+#define MAX_BATCH_WAKES      32
+#define TELEM_BODY_MAX       (MAX_GROUP_DATA_LEN - TELEM_FRAME_HDR)               // one frame's body
+#define TELEM_READING_MAX    (TELEM_BODY_MAX - 1 - TELEM_BATCH_RECORD_HDR)        // one reading, fits a batch of one
+
+// State machine
+enum SensorNodeState {
+  SAMPLING,
+  PROCESSING,
+  ADVERTISING,
+  WAITING_FOR_TX,   // Outbound queue draining before the radio is powered off
+  LISTENING,        // Announced downlink window (TELEM_FLAG_LISTEN): RX open for listen_window_ms
+  READY_TO_SLEEP,
+  INTERACTIVE_MODE  // Stay awake for configuration/debugging
+};
+
+inline bool isAwakeTooLong(uint32_t now, uint32_t awake_start) {
+  return now - awake_start >= MAX_AWAKE_TIME_MS;
+}
+
+inline bool isTxDrainTimedOut(uint32_t now, uint32_t state_start) {
+  return now - state_start >= TX_DRAIN_TIMEOUT_MS;
+}
+
+inline bool isListenWindowOver(uint32_t now, uint32_t state_start, uint16_t listen_window_ms) {
+  return now - state_start >= listen_window_ms;
+}
+
+// Periodic advert, counted in wakes (the count is kept across resets in GPREGRET2)
+inline bool isAdvertDue(uint8_t wakeup_count, uint8_t wakeups_per_advert) {
+  return wakeup_count >= wakeups_per_advert;
+}
+
+// PROCESSING -> next state: advertise if due, else wait for the telemetry TX, else sleep right away
+inline SensorNodeState stateAfterProcessing(bool advert_due, bool telemetry_sent) {
+  if (advert_due) return ADVERTISING;
+  return telemetry_sent ? WAITING_FOR_TX : READY_TO_SLEEP;
+}
+
+// WAITING_FOR_TX once the queue drained (or timed out: never listens) -> LISTENING or READY_TO_SLEEP
+inline SensorNodeState stateAfterTx(bool listen_window) {
+  return listen_window ? LISTENING : READY_TO_SLEEP;
+}
+
+/**
+ * Capacity a batch collects up to. A CayenneLPP batch goes out as one frame. A compact batch
+ * re-encodes to well under its CayenneLPP size and is split into as many frames as it needs,
+ * so it collects up to the retained buffer size.
+ */
+inline int getTelemBatchCapacity(uint8_t telemetry_format) {
+  return telemetry_format == TELEM_SCHEMA_COMPACT ? TELEM_BATCH_BUF_SIZE : TELEM_BODY_MAX;
+}
+
+// Send the batch after batch_wakes readings, or now if another reading like this one would not fit
+inline bool isTelemBatchDue(uint8_t wakes, uint8_t batch_wakes, bool fits_next) {
+  return wakes >= batch_wakes || !fits_next;
+}
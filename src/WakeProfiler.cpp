@@ -0,0 +1,137 @@
+#include "WakeProfiler.h"
+#include <MeshCore.h>
+#include <RetainedRAM.h>
+#include <LogLevel.h>
+
+#define WAKE_PROFILE_MAGIC   0x464F5250   // 'PROF'
+
+struct PhaseHistogram {
+  uint32_t count;
+  uint32_t sum_ms;
+  uint32_t max_ms;
+  uint16_t bins[WAKE_HIST_BINS];
+};
+
+struct WakeProfileData {
+  uint32_t wakes;
+  float total_uah;
+  uint32_t last_awake_ms;
+  float last_uah;
+  uint32_t reboot_ms;       // running average of the reset-to-ready phases (0 = not measured)
+  PhaseHistogram phases[WAKE_NUM_PHASES];
+};
+
+static RETAINED_RAM RetainedBlock<WakeProfileData, WAKE_PROFILE_MAGIC> profile;
+
+static const char* phase_names[WAKE_NUM_PHASES] = {
+  "boot", "fs", "radio", "sensors", "sample", "query", "txq", "air", "sleep", "awake"
+};
+
+static uint8_t binFor(uint32_t ms) {
+  if (ms == 0) return 0;
+  uint8_t bin = 32 - __builtin_clz(ms);
+  return bin < WAKE_HIST_BINS ? bin : WAKE_HIST_BINS - 1;
+}
+
+void WakeProfiler::begin() {
+  memset(_start, 0, sizeof(_start));
+  memset(_current, 0, sizeof(_current));
+  _wake_start_ms = 0;
+  _rebooted = true;
+  profile.retain();
+  if (!profile.isValid()) {
+    clear();
+  }
+}
+
+void WakeProfiler::beginWake() {
+  memset(_start, 0, sizeof(_start));
+  memset(_current, 0, sizeof(_current));
+  _wake_start_ms = millis();
+  _rebooted = false;
+}
+
+void WakeProfiler::clear() {
+  memset(&profile.data, 0, sizeof(profile.data));
+  profile.commit();
+}
+
+void WakeProfiler::endWake(uint32_t radio_on_ms) {
+  WakeProfileData& d = profile.data;
+  _current[WAKE_PHASE_AWAKE] = millis() - _wake_start_ms;   // millis() counts from reset
+
+  for (int p = 0; p < WAKE_NUM_PHASES; p++) {
+    PhaseHistogram& h = d.phases[p];
+    uint32_t ms = _current[p];
+    h.count++;
+    h.sum_ms += ms;
+    if (ms > h.max_ms) h.max_ms = ms;
+    uint8_t bin = binFor(ms);
+    if (h.bins[bin] < 0xFFFF) h.bins[bin]++;
+  }
+
+  // charge model: MCU for the whole wake, radio RX while powered, TX on top during airtime
+  uint32_t air_ms = _current[WAKE_PHASE_TX_AIRTIME];
+  float mas = _current[WAKE_PHASE_AWAKE] * ENERGY_MCU_ACTIVE_MA
+            + radio_on_ms * ENERGY_RADIO_RX_MA
+            + air_ms * (ENERGY_RADIO_TX_MA - ENERGY_RADIO_RX_MA);   // mA x ms
+  d.last_uah = mas / 3600.0f;    // mA.ms -> uAh
+  d.last_awake_ms = _current[WAKE_PHASE_AWAKE];
+  d.total_uah += d.last_uah;
+  if (_rebooted) {
+    uint32_t reboot = _current[WAKE_PHASE_BOOT] + _current[WAKE_PHASE_FS_LOAD] + _current[WAKE_PHASE_SENSORS_BEGIN];
+    d.reboot_ms = d.reboot_ms ? (d.reboot_ms * 7 + reboot) / 8 : reboot;
+  }
+  d.wakes++;
+  profile.commit();
+
+  LOG_DEBUG("Wake profile: awake %lu ms, radio %lu ms, air %lu ms, ~%.1f uAh",
+                     d.last_awake_ms, radio_on_ms, air_ms, d.last_uah);
+}
+
+uint32_t WakeProfiler::getLastAwakeMillis() const {
+  return profile.data.last_awake_ms;
+}
+
+float WakeProfiler::getLastWakeMicroAh() const {
+  return profile.data.last_uah;
+}
+
+float WakeProfiler::getRebootMicroAh() const {
+  uint32_t ms = profile.data.reboot_ms ? profile.data.reboot_ms : WAKE_REBOOT_MS_DEFAULT;
+  return ms * ENERGY_MCU_ACTIVE_MA / 3600.0f;
+}
+
+void WakeProfiler::formatSummary(char* reply) const {
+  const WakeProfileData& d = profile.data;
+  if (d.wakes == 0) {
+    strcpy(reply, "No wakes profiled yet");
+    return;
+  }
+  const PhaseHistogram& awake = d.phases[WAKE_PHASE_AWAKE];
+  const PhaseHistogram& air = d.phases[WAKE_PHASE_TX_AIRTIME];
+  sprintf(reply, "%lu wakes, awake avg %lu max %lu ms, air avg %lu ms, ~%.1f uAh/wake (last %.1f)",
+          (unsigned long)d.wakes, (unsigned long)(awake.sum_ms / awake.count), (unsigned long)awake.max_ms,
+          (unsigned long)(air.sum_ms / air.count), d.total_uah / d.wakes, d.last_uah);
+}
+
+void WakeProfiler::print(Stream& out) const {
+  const WakeProfileData& d = profile.data;
+  out.printf("Wakes: %lu, total ~%.1f uAh\n", (unsigned long)d.wakes, d.total_uah);
+  out.printf("phase    avg    max |");
+  for (int b = 0; b < WAKE_HIST_BINS; b++) {
+    if (b == 0) out.printf("    0");
+    else if (b == WAKE_HIST_BINS - 1) out.printf(" >=%-3d", 1 << (b - 1));
+    else out.printf(" <%-4d", 1 << b);
+  }
+  out.println();
+
+  for (int p = 0; p < WAKE_NUM_PHASES; p++) {
+    const PhaseHistogram& h = d.phases[p];
+    out.printf("%-7s %5lu %6lu |", phase_names[p], (unsigned long)(h.count ? h.sum_ms / h.count : 0), (unsigned long)h.max_ms);
+    for (int b = 0; b < WAKE_HIST_BINS; b++) {
+      out.printf(" %5u", h.bins[b]);
+    }
+    out.println();
+  }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Per-wake timing and energy instrumentation, kept in retained RAM across system-off
+ *
+ * Each phase of a wake is timed with start()/stop() (or add() for externally measured values).
+ * endWake() folds this wake's per-phase totals into log2 histograms and estimates the charge
+ * used from awake time, radio-on time and TX airtime, so regressions show up as a shifted
+ * histogram rather than a single noisy number.
+ */
+enum WakePhase {
+  WAKE_PHASE_BOOT,            // setup() entry to board.begin() done (serial wait included)
+  WAKE_PHASE_FS_LOAD,         // boot snapshot / InternalFS, identity, prefs
+  WAKE_PHASE_RADIO_INIT,      // SX1262 power-up to dispatcher in RX
+  WAKE_PHASE_SENSORS_BEGIN,
+  WAKE_PHASE_SAMPLE,          // sum over all samples of the wake
+  WAKE_PHASE_QUERY_SENSORS,
+  WAKE_PHASE_TX_QUEUE,        // WAITING_FOR_TX until the queue drained
+  WAKE_PHASE_TX_AIRTIME,      // Dispatcher::getTotalAirTime()
+  WAKE_PHASE_SLEEP_ENTRY,     // READY_TO_SLEEP until system-off is requested
+  WAKE_PHASE_AWAKE,           // reset to system-off
+  WAKE_NUM_PHASES
+};
+
+#define WAKE_HIST_BINS   12   // bin 0: 0ms, bin k: [2^(k-1), 2^k) ms, last bin open-ended
+
+#ifndef WAKE_REBOOT_MS_DEFAULT
+  #define WAKE_REBOOT_MS_DEFAULT   400    // reset-to-ready estimate until a reboot has been measured
+#endif
+
+// Current estimates for the mAh model (override per board/build)
+#ifndef ENERGY_MCU_ACTIVE_MA
+  #define ENERGY_MCU_ACTIVE_MA   3.0f    // nRF52840 awake, mostly in WFE between events
+#endif
+#ifndef ENERGY_RADIO_RX_MA
+  #define ENERGY_RADIO_RX_MA     5.3f    // SX1262 RX (DC-DC)
+#endif
+#ifndef ENERGY_RADIO_TX_MA
+  #define ENERGY_RADIO_TX_MA     118.0f  // SX1262 TX at +22 dBm
+#endif
+
+class WakeProfiler {
+public:
+  void begin();
+  void beginWake();   // System ON wake: new cycle without a reset
+
+
+  void start(WakePhase phase) { _start[phase] = millis(); }
+  void stop(WakePhase phase) { add(phase, millis() - _start[phase]); }
+  void add(WakePhase phase, uint32_t ms) { _current[phase] += ms; }
+
+  /**
+   * Fold this wake into the retained histograms (call once, just before system-off)
+   * @param radio_on_ms  time the SX1262 was powered this wake
+   */
+  void endWake(uint32_t radio_on_ms);
+
+  uint32_t getLastAwakeMillis() const;
+  float getLastWakeMicroAh() const;
+  float getRebootMicroAh() const;   // charge of boot + FS load + sensors begin, averaged over rebooting wakes
+
+  void formatSummary(char* reply) const;   // one line, fits a CLI reply
+  void print(Stream& out) const;           // full histograms
+  void clear();
+
+private:
+  uint32_t _start[WAKE_NUM_PHASES];
+  uint32_t _current[WAKE_NUM_PHASES];
+  uint32_t _wake_start_ms;   // 0 after a reset, millis() at a System ON wake
+  bool _rebooted;
+};
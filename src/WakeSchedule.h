@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Wake slot arithmetic, shared by the firmware (main.cpp, SensorMesh) and the host simulation
+ *
+ * Wakes are phase-locked to the wall clock: time is cut into periods of one interval, and a node
+ * wakes once per period at its phase within it, so time spent awake does not accumulate as drift.
+ * The phase is re-drawn every period from the node's key and the period number. Two nodes that
+ * share a slot in one period are independent in the next, instead of colliding every cycle.
+ */
+#define WAKE_MIN_SLEEP_SECS       10      // shortest sleep: a closer slot is moved later in its period
+#define TELEM_SLOT_JITTER_MAX_MS  1000    // telemetry TX delay drawn within the slot, at most this
+
+/**
+ * Per-period slot hash: murmur3 finalizer over the node key and period number
+ */
+inline uint32_t wakeSlotHash(uint32_t key_hash, uint32_t period) {
+  uint32_t h = key_hash ^ (period * 0x9E3779B9UL);
+  h ^= h >> 16;
+  h *= 0x85EBCA6BUL;
+  h ^= h >> 13;
+  h *= 0xC2B2AE35UL;
+  h ^= h >> 16;
+  return h;
+}
+
+/**
+ * Phase of a node within one period, in slot_width steps (0 = 1 s)
+ * @param key_hash  uniformly distributed per-node value (leading bytes of the public key)
+ * @param period    RTC time / interval
+ */
+inline uint32_t wakePhaseFor(uint32_t key_hash, uint32_t period, uint32_t interval, uint32_t slot_width) {
+  uint32_t width = slot_width ? slot_width : 1;
+  uint32_t num_slots = interval / width;
+  if (num_slots <= 1) return 0;
+  return (wakeSlotHash(key_hash, period) % num_slots) * width;
+}
+
+// Upper bound (exclusive) of the telemetry TX delay: within the slot, at most TELEM_SLOT_JITTER_MAX_MS
+inline uint32_t telemJitterRangeMs(uint32_t slot_width) {
+  uint32_t width_ms = (slot_width ? slot_width : 1) * 1000UL;
+  return width_ms < TELEM_SLOT_JITTER_MAX_MS ? width_ms : TELEM_SLOT_JITTER_MAX_MS;
+}
+
+// RTC time a wake started, from how long it has been awake
+inline uint32_t wakeStartTime(uint32_t now, uint32_t awake_ms) {
+  uint32_t awake_secs = awake_ms / 1000;
+  return awake_secs < now ? now - awake_secs : 0;
+}
+
+/**
+ * Next wake slot after now: the slot of the period after the one this wake served
+ *
+ * The phase is re-drawn every period, so a wake late in period p can end after, or just before,
+ * the slot drawn for p+1. Such a slot is moved later within p+1 (at least the margin after now)
+ * rather than skipped: every period keeps exactly one wake, and only a period that went by
+ * entirely while the node was awake is lost. The served period is the one the wake started in
+ * (woke_at), not the one now falls in. Slots are period * interval + phase, never now - phase, so
+ * an unset or just reset RTC (now smaller than any phase) simply lands in period 0 instead of
+ * wrapping around.
+ * @param woke_at    RTC time this wake started (wakeStartTime())
+ * @param slotting   false: wake at the start of each period (phase 0)
+ * @param keep_slot  after an event wake: keep the slot it interrupted however close it is
+ */
+inline uint32_t nextWakeSlot(uint32_t now, uint32_t woke_at, uint32_t interval, uint32_t key_hash,
+                             uint32_t slot_width, bool slotting, bool keep_slot) {
+  if (interval == 0) interval = 1;
+  if (woke_at > now) woke_at = now;
+  uint32_t margin = interval > 2 * WAKE_MIN_SLEEP_SECS && !keep_slot ? WAKE_MIN_SLEEP_SECS : 1;
+
+  // this wake's period, unless its slot is still ahead (power-up, reset or event wake before the slot)
+  uint32_t period = woke_at / interval;
+  uint32_t slot = period * interval + (slotting ? wakePhaseFor(key_hash, period, interval, slot_width) : 0);
+  for (;;) {
+    if (slot <= now) {
+      period++;
+      slot = period * interval + (slotting ? wakePhaseFor(key_hash, period, interval, slot_width) : 0);
+    }
+    uint32_t latest = (period + 1) * interval - 1;   // last second of the period
+    if (latest <= now) continue;                     // the whole period went by while awake
+    if (slot <= now || slot - now < margin) {   // passed while awake, or too close: later in the period
+      slot = now + margin < latest ? now + margin : latest;
+    }
+    return slot;
+  }
+}
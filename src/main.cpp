@@ -1,10 +1,16 @@
 #include "SensorMesh.h"
+#include "SampleScheduler.h"
+#include "WakeProfiler.h"
+#include "WakeSchedule.h"
+#include "WakeCycle.h"
 
 // ============================================================
 // CHANNEL DEFINITIONS
 // ============================================================
 
 // Standard Telemetry Channels (1-9) - Reserved for system/framework
+#define TELEM_CHANNEL_WAKE_MS        8   // Previous wake: awake time in ms (optional, "stats energy lpp on")
+#define TELEM_CHANNEL_WAKE_UAH       9   // Previous wake: estimated charge in uAh (optional)
 #define TELEM_CHANNEL_BATTERY       10   // Battery voltage
 
 // Application Telemetry Channels (10+) - CUSTOMIZE THIS SECTION
@@ -26,15 +32,6 @@
 
 // ============================================================
 
-// State machine
-enum SensorNodeState {
-  SAMPLING,
-  PROCESSING,
-  ADVERTISING,
-  READY_TO_SLEEP,
-  INTERACTIVE_MODE  // Stay awake for configuration/debugging
-};
-
 class LowPowerSensorMesh : public SensorMesh {
 public:
   LowPowerSensorMesh(mesh::MainBoard& board, mesh::Radio& radio,
@@ -50,154 +47,192 @@ public:
 protected:
   void onSensorDataRead() override {
     // Not used in low-power mode - device sleeps between wake cycles
-    // All sensor reading happens in broadcastApplicationTelemetry()
+    // All sensor reading happens in the telemetry sources below, called by broadcastTelemetry()
   }
 
-  bool handleCustomCommand(uint32_t sender_timestamp, char* command, char* reply) override {
-    if (sender_timestamp == 0 && strcmp(command, "exit") == 0) {
-      if (current_state_ptr && *current_state_ptr == INTERACTIVE_MODE) {
-        *current_state_ptr = READY_TO_SLEEP;
-        strcpy(reply, "Exiting interactive mode, going to sleep...");
-      } else {
-        strcpy(reply, "Not in interactive mode");
-      }
-      return true;
-    }
-    return false;
-  }
+  bool handleCustomCommand(uint32_t sender_timestamp, char* command, char* reply) override;
+  void prepareRadio() override;
 
 private:
   SensorNodeState* current_state_ptr = nullptr;
 };
 
 StdRNG fast_rng;
-SimpleMeshTables tables;
+ArduinoMillis ms_clock;
+SensorMeshTables<SENSOR_SEEN_HASHES, SENSOR_SEEN_ACKS> tables;   // see MemoryProfile.h
 
 static char command[160];
 static const size_t MAX_SERIAL_WAIT_MS = 5000;
 
-LowPowerSensorMesh the_mesh(board, radio_driver, *new ArduinoMillis(),
+LowPowerSensorMesh the_mesh(board, radio_driver, ms_clock,
                             fast_rng, rtc_clock, tables);
 
 // ============================================================
-// APPLICATION TELEMETRY BROADCAST FUNCTION
-// CUSTOMIZE THIS SECTION TO ADD YOUR SENSOR DATA
+// RADIO BRING-UP
 // ============================================================
+static uint32_t radio_ready_latency_ms = 0;   // SX126X_POWER_EN high -> dispatcher in RX
+static WakeProfiler profiler;
+
+// Power the SX1262 and initialise the driver; a radio that fails to init halts with a blinking LED
+static void initRadioHardware() {
+  LOG_DEBUG("Initializing radio...");
+  board.powerUpRadio();
+  board.waitRadioPowerReady();
+  if (!radio_init()) {
+    while(1) {
+      digitalWrite(LED_BUILTIN, HIGH);
+      delay(100);
+      digitalWrite(LED_BUILTIN, LOW);
+      delay(100);
+    }
+  }
 
-void broadcastApplicationTelemetry() {
-  // Create telemetry buffer
-  CayenneLPP telemetry(MAX_PACKET_PAYLOAD - 5);
-  telemetry.reset();
+  LOG_DEBUG("Radio initialized successfully");
+  fast_rng.begin(radio_get_rng_seed());
+}
 
-  // === STANDARD TELEMETRY (Always included) ===
-  telemetry.addVoltage(TELEM_CHANNEL_BATTERY,
-                      board.getBattMilliVolts() / 1000.0f);
+// Lazy radio: called before anything is queued for TX (or a CLI session starts), no-op once up
+static void bringUpRadio() {
+  if (the_mesh.isRadioReady()) return;
 
-  // === APPLICATION TELEMETRY ===
-  // CUSTOMIZE THIS SECTION - Add your sensor readings here
+  if (!board.isRadioPowered()) {
+    initRadioHardware();
+  }
+  the_mesh.beginRadio();
+  radio_ready_latency_ms = millis() - board.getRadioPowerOnMillis();
+  profiler.add(WAKE_PHASE_RADIO_INIT, radio_ready_latency_ms);
+  LOG_DEBUG("Radio ready %lu ms after power-on", radio_ready_latency_ms);
+}
 
-  // EXAMPLE
-  // as an example this will add any data from currently supported sensors (EnvironmentSensorManager) to the CayenneLPP packet.
-  // since this is a push bashed sensor the permissions byte is irrelevant so enable all permissions
-  MESH_DEBUG_PRINTLN("About to call querySensors");
-  sensors.querySensors(0xFF, telemetry);
+void LowPowerSensorMesh::prepareRadio() {
+  bringUpRadio();
+}
 
-  // Example 1: I2C Temperature/Humidity Sensor (BME280, SHT31, etc.)
-  // if (bme_initialized) {
-  //   float temp = bme.readTemperature();
-  //   float humidity = bme.readHumidity();
-  //   telemetry.addTemperature(APP_CHANNEL_TEMPERATURE, temp);
-  //   telemetry.addRelativeHumidity(APP_CHANNEL_HUMIDITY, humidity);
-  //   MESH_DEBUG_PRINTLN("BME280: %.2fC, %.1f%%", temp, humidity);
-  // }
+// ============================================================
+// APPLICATION TELEMETRY SOURCES
+// CUSTOMIZE THIS SECTION TO ADD YOUR SENSOR DATA
+// Each source adds its values to the wake's CayenneLPP reading. SensorMesh::broadcastTelemetry()
+// calls them in registration order (see setup()) and handles stats, logging, send-on-delta,
+// batching and encoding.
+// ============================================================
+static SampleScheduler sampler;
 
-  // Example 2: Analog Sensor (soil moisture, light sensor, etc.)
-  // int raw_value = analogRead(A0);
-  // float analog_value = raw_value * (3.3 / 4095.0);  // For 12-bit ADC
-  // telemetry.addAnalogInput(APP_CHANNEL_SENSOR_1, analog_value);
-  // MESH_DEBUG_PRINTLN("Analog: %.3fV", analog_value);
-
-  // Example 3: Digital Sensor (door switch, motion detector, etc.)
-  // bool digital_state = digitalRead(SENSOR_PIN);
-  // telemetry.addDigitalInput(APP_CHANNEL_SENSOR_2, digital_state ? 1 : 0);
-  // MESH_DEBUG_PRINTLN("Digital: %s", digital_state ? "HIGH" : "LOW");
-
-  // Example 4: Averaged sensor values from SAMPLING state
-  // float avg_sensor = 0;
-  // for (int i = 0; i < sample_count; i++) {
-  //   avg_sensor += app_sensor_samples[i];
-  // }
-  // avg_sensor /= sample_count;
-  // telemetry.addTemperature(APP_CHANNEL_TEMPERATURE, avg_sensor);
-  // MESH_DEBUG_PRINTLN("Avg sensor: %.2f", avg_sensor);
-
-  // === BROADCAST THE TELEMETRY ===
-  uint8_t telem_len = telemetry.getSize();
-  if (telem_len == 0) {
-    MESH_DEBUG_PRINTLN("No telemetry data to broadcast");
-    return;
+// === SAMPLED CHANNELS ===
+// Read during SAMPLING on their own schedule (see setup()), reported reduced (mean/median/min/max)
+static float readBatteryVolts(void* ctx) {
+  return board.getBattMilliVolts() / 1000.0f;
+}
+
+// Example: distance sensor burst (VL53L0X)
+// static float readDistance(void* ctx) {
+//   return tof.readRangeSingleMillimeters() / 1000.0f;
+// }
+
+// === EVENT WAKE SOURCES ===
+// Pins that wake the node between its RTC slots (sensor INT lines, switches, the user button),
+// declared in declareEventSources(). An event wake samples only the channels of the sources that
+// fired, sends at once (no batching, no deadband) and sleeps until the slot it interrupted.
+// A source on a sampled channel takes that channel's samples, any other is reported as an LPP
+// digital input: 1 when it fired, on periodic wakes its current pin level.
+static uint8_t event_channels[WAKE_MAX_SOURCES];   // LPP channel of each board wake source
+static bool event_wake = false;                    // this wake was started by a wake source
+
+static void addEventSource(uint8_t pin, bool active_low, uint8_t channel) {
+  int i = board.addWakeSource(pin, active_low);
+  if (i >= 0) event_channels[i] = channel;
+}
+
+// Called first in setup(): board.begin() needs the sources to tell an event wake from an RTC one
+static void declareEventSources() {
+  // addEventSource(WB_IO6, true, APP_CHANNEL_DOOR);       // reed switch to GND
+  // addEventSource(WB_IO3, false, APP_CHANNEL_DISTANCE);  // threshold INT of a sampled sensor
+}
+
+static bool isEventSource(int i) {
+  return (board.getWakeEvents() >> i) & 1;
+}
+
+static void addEventTelemetry(void* ctx, CayenneLPP& telemetry) {
+  for (int i = 0; i < board.getNumWakeSources(); i++) {
+    if (sampler.hasChannel(event_channels[i])) continue;   // reported by addSampledTelemetry
+    if (event_wake && !isEventSource(i)) continue;
+    telemetry.addDigitalInput(event_channels[i], (event_wake || board.isWakeSourceActive(i)) ? 1 : 0);
   }
+}
 
-  int offset = 0;
-
-  // Create packet with timestamp + telemetry
-  uint8_t temp[5 + MAX_PACKET_PAYLOAD];
-  uint32_t timestamp = the_mesh.getRTCClock()->getCurrentTime();
-  memcpy(temp, &timestamp, 4);
-  offset += 4;
-
-  // Flags byte (reserved for future use)
-  // Note: Padding is handled by encryption layer. CayenneLPP channel 0 marks end of data.
-  uint8_t flags = 0x00;
-  temp[offset++] = flags;
-
-  // add CayenneLPP data
-  memcpy(&temp[offset], telemetry.getBuffer(), telem_len);
-  offset += telemetry.getSize();
-
-  // Select channel: private if configured, otherwise public
-  mesh::GroupChannel* channel;
-  const char* channel_type;
-  if (the_mesh.hasPrivateChannel()) {
-    channel = (mesh::GroupChannel*)&the_mesh.getPrivateChannel();
-    channel_type = "ENCRYPTED";
-  } else {
-    // Use public channel (all zeros)
-    static mesh::GroupChannel public_channel;
-    memset(public_channel.hash, 0, sizeof(public_channel.hash));
-    memset(public_channel.secret, 0, sizeof(public_channel.secret));
-    channel = &public_channel;
-    channel_type = "PUBLIC";
+// === GPS (ENV_INCLUDE_GPS) ===
+// Duty-cycled: searches every gps_fix_wakes wakes ("gps cycle"), other wakes report the stored
+// fix through sensors.node_lat/lon (querySensors, getGPS). A motion sensor can force a search:
+// static void onMotion() { gps.requestFix(); }   // eg. RAK1904 INT1, polled or from its wake pin
+#if ENV_INCLUDE_GPS
+static GpsDutyCycle gps;
+
+static void startGps() {
+  if (!sensors.isGpsDetected()) return;
+  const SensorExtendedPrefs* prefs = the_mesh.getExtendedPrefs();
+  bool enabled = the_mesh.getNodePrefs()->gps_enabled && !event_wake;   // event wakes keep it in backup
+  gps.begin(nmea, Serial1, enabled, prefs->gps_fix_wakes, prefs->gps_fix_secs);
+  float lat, lon, alt;
+  if (gps.getFix(lat, lon, alt)) {
+    sensors.node_lat = lat;
+    sensors.node_lon = lon;
+    sensors.node_altitude = alt;
   }
+}
+#endif
 
-  auto pkt = the_mesh.createGroupDatagram(PAYLOAD_TYPE_GRP_DATA,
-                                          *channel, temp, offset);
+// === STANDARD TELEMETRY (Always included) ===
+static void addSampledTelemetry(void* ctx, CayenneLPP& telemetry) {
+  sampler.addTelemetry(telemetry);   // battery + any other sampled channels
+}
 
-  if (pkt) {
-    // Use broadcast zone if configured, otherwise standard flood
-    const char* zone = the_mesh.getBroadcastZoneName();
-    if (zone == NULL) {
-      the_mesh.sendFlood(pkt);
-      MESH_DEBUG_PRINTLN("Telemetry broadcast (%d bytes, %s) - standard flood", telem_len, channel_type);
-    } else {
-      uint16_t codes[2];
-      codes[0] = the_mesh.getBroadcastZone().calcTransportCode(pkt);
-      codes[1] = 0;
-      the_mesh.sendFlood(pkt, codes);
-      MESH_DEBUG_PRINTLN("Telemetry broadcast (%d bytes, %s) - zone: %s", telem_len, channel_type, zone);
-    }
-  } else {
-    MESH_DEBUG_PRINTLN("ERROR: unable to create telemetry packet!");
+// as an example this will add any data from currently supported sensors (EnvironmentSensorManager) to the CayenneLPP packet.
+// since this is a push bashed sensor the permissions byte is irrelevant so enable all permissions
+static void addSensorTelemetry(void* ctx, CayenneLPP& telemetry) {
+  if (event_wake) return;   // only the triggering channels
+  LOG_DEBUG("About to call querySensors");
+  profiler.start(WAKE_PHASE_QUERY_SENSORS);
+  sensors.querySensors(0xFF, telemetry);
+  profiler.stop(WAKE_PHASE_QUERY_SENSORS);
+}
+
+// Previous wake's timing/energy (this wake is not finished yet)
+static void addEnergyTelemetry(void* ctx, CayenneLPP& telemetry) {
+  if (the_mesh.getExtendedPrefs()->energy_telemetry && !event_wake) {
+    telemetry.addGenericSensor(TELEM_CHANNEL_WAKE_MS, profiler.getLastAwakeMillis());
+    telemetry.addAnalogInput(TELEM_CHANNEL_WAKE_UAH, profiler.getLastWakeMicroAh());
   }
 }
 
+// === APPLICATION TELEMETRY ===
+// Example 1: I2C Temperature/Humidity Sensor (BME280, SHT31, etc.)
+// static void addBmeTelemetry(void* ctx, CayenneLPP& telemetry) {
+//   if (bme_initialized) {
+//     float temp = bme.readTemperature();
+//     float humidity = bme.readHumidity();
+//     telemetry.addTemperature(APP_CHANNEL_TEMPERATURE, temp);
+//     telemetry.addRelativeHumidity(APP_CHANNEL_HUMIDITY, humidity);
+//     LOG_DEBUG("BME280: %.2fC, %.1f%%", temp, humidity);
+//   }
+// }
+
+// Examples 2-3 go in the body of a source like the one above
+// Example 2: Analog Sensor (soil moisture, light sensor, etc.)
+// int raw_value = analogRead(A0);
+// float analog_value = raw_value * (3.3 / 4095.0);  // For 12-bit ADC
+// telemetry.addAnalogInput(APP_CHANNEL_SENSOR_1, analog_value);
+// LOG_DEBUG("Analog: %.3fV", analog_value);
+
+// Example 3: Digital Sensor (door switch, motion detector, etc.)
+// bool digital_state = digitalRead(SENSOR_PIN);
+// telemetry.addDigitalInput(APP_CHANNEL_SENSOR_2, digital_state ? 1 : 0);
+// LOG_DEBUG("Digital: %s", digital_state ? "HIGH" : "LOW");
+
 // ============================================================
 
-// Configuration constants (can be moved to preferences later)
-static const uint32_t SAMPLE_INTERVAL_MS = 1000;           // 1 second between samples
-static const uint8_t NUM_SAMPLES = 5;                      // Number of samples to collect
-static const uint32_t MAX_AWAKE_TIME_MS = 1 * 60 * 1000;  // 5 minutes max
-static const uint8_t DEFAULT_SLEEP_TIME_SECONDS = 60 * 15; // 15 min default sleep time
+// Configuration constants (sampling schedules are in the prefs, see "sample status"; wake limits in WakeCycle.h)
+static const uint32_t DEFAULT_SLEEP_TIME_SECONDS = 60 * 15; // 15 min default sleep time
+static const uint32_t IDLE_SLICE_MS = 20;                  // max core sleep before re-checking radio/serial
 
 static SensorNodeState current_state = SAMPLING;
 static uint32_t state_start_time = 0;
@@ -205,106 +240,278 @@ static uint32_t awake_start_time = 0;
 static uint8_t wakeup_count = 0;
 static uint32_t last_interactive_activity = 0;  // Track last command received
 static const uint32_t INTERACTIVE_TIMEOUT_MS = 5 * 60 * 1000;  // Exit interactive mode after 300s of inactivity
+static const uint32_t REMOTE_SESSION_TIMEOUT_MS = 60 * 1000;   // ... or 60s when entered from a listen window
+static bool remote_session = false;             // interactive mode entered by a downlink, not serial
+static uint32_t downlink_count_seen = 0;        // the_mesh.getDownlinkCount() at the last check
+
+// Sampling idle accounting
+static uint32_t idle_ms_total = 0;            // time the core spent in WFE this wake
+static int packets_dropped = 0;               // packets still queued when the TX drain timed out
+
+// Boot metrics
+static bool fast_wake = false;                // true when woken by RTC alarm or a wake source (minimal init path)
+static uint32_t time_to_first_sample_ms = 0;  // ms from reset (or System ON wake) to the first sample
+static bool system_on_wake = false;           // this cycle resumed from System ON sleep, no reset
+static uint32_t airtime_base = 0;             // Dispatcher airtime at the start of this cycle
 
 // Sampling state variables
-static float sensor_samples[NUM_SAMPLES];
-static int sample_count = 0;
-static uint32_t last_sample_time = 0;
+static int samples_taken = 0;                 // over all sampled channels this wake
 
-// ============================================================
-// APPLICATION SENSOR SAMPLING STORAGE (Optional)
-// If you want to average multiple samples, declare storage here
-// ============================================================
-// Example:
-// static float app_sensor_samples[NUM_SAMPLES];
-// ============================================================
+bool LowPowerSensorMesh::handleCustomCommand(uint32_t sender_timestamp, char* command, char* reply) {
+  if (sender_timestamp == 0 && strcmp(command, "exit") == 0) {
+    if (current_state_ptr && *current_state_ptr == INTERACTIVE_MODE) {
+      *current_state_ptr = WAITING_FOR_TX;   // let the CLI reply go out first
+      strcpy(reply, "Exiting interactive mode, going to sleep...");
+    } else {
+      strcpy(reply, "Not in interactive mode");
+    }
+    return true;
+  }
+  if (memcmp(command, "stats energy", 12) == 0 && (command[12] == 0 || command[12] == ' ')) {
+    const char* subcmd = command[12] ? &command[13] : "";
+    if (strcmp(subcmd, "clear") == 0) {
+      profiler.clear();
+      strcpy(reply, "OK");
+    } else if (strcmp(subcmd, "lpp on") == 0 || strcmp(subcmd, "lpp off") == 0) {
+      getExtendedPrefs()->energy_telemetry = (strcmp(subcmd, "lpp on") == 0) ? 1 : 0;
+      savePrefs();
+      sprintf(reply, "Energy telemetry (ch%d/ch%d): %s", TELEM_CHANNEL_WAKE_MS, TELEM_CHANNEL_WAKE_UAH,
+              getExtendedPrefs()->energy_telemetry ? "on" : "off");
+    } else if (subcmd[0] == 0) {
+      if (sender_timestamp == 0) profiler.print(Serial);   // full histograms on the serial console
+      profiler.formatSummary(reply);
+    } else {
+      strcpy(reply, "Usage: stats energy [clear | lpp on | lpp off]");
+    }
+    return true;
+  }
+  if (memcmp(command, "event ", 6) == 0) {
+    const char* subcmd = &command[6];
+    if (strcmp(subcmd, "on") == 0 || strcmp(subcmd, "off") == 0) {
+      getExtendedPrefs()->event_wake = strcmp(subcmd, "on") == 0 ? 1 : 0;
+      savePrefs();
+      sprintf(reply, "Event wake: %s (%d sources)", getExtendedPrefs()->event_wake ? "on" : "off", board.getNumWakeSources());
+    } else if (strcmp(subcmd, "status") == 0) {
+      char* dp = reply;
+      dp += sprintf(dp, "Event wake: %s, this wake: %s", getExtendedPrefs()->event_wake ? "on" : "off",
+                    event_wake ? "event" : "periodic");
+      for (int i = 0; i < board.getNumWakeSources(); i++) {
+        dp += sprintf(dp, ", GPIO%d=ch%d%s%s", board.getWakeSourcePin(i), event_channels[i],
+                      board.isWakeSourceActive(i) ? " active" : "", isEventSource(i) ? " fired" : "");
+      }
+    } else {
+      strcpy(reply, "Usage: event on | event off | event status");
+    }
+    return true;
+  }
+#if ENV_INCLUDE_GPS
+  if (memcmp(command, "gps cycle", 9) == 0 && (command[9] == 0 || command[9] == ' ')) {
+    // gps cycle [<wakes> [<hold_secs>] | fix]
+    const char* subcmd = command[9] ? &command[10] : "";
+    if (!sensors.isGpsDetected()) {
+      strcpy(reply, "Err - no GPS receiver detected");
+    } else if (strcmp(subcmd, "fix") == 0) {
+      gps.requestFix();
+      strcpy(reply, "OK - GPS search requested");
+    } else if (subcmd[0] >= '0' && subcmd[0] <= '9') {
+      uint32_t wakes = atoi(subcmd);
+      const char* sp = strchr(subcmd, ' ');
+      uint32_t secs = sp ? atoi(sp + 1) : getExtendedPrefs()->gps_fix_secs;
+      if (wakes > 255 || secs < 1 || secs > GPS_FIX_MAX_SECS) {
+        sprintf(reply, "Err - wakes 0-255 (0 = every wake), hold 1-%d s", GPS_FIX_MAX_SECS);
+      } else {
+        getExtendedPrefs()->gps_fix_wakes = wakes;
+        getExtendedPrefs()->gps_fix_secs = secs;
+        savePrefs();
+        sprintf(reply, "GPS fix every %lu wakes, up to %lu s (from the next wake)", (unsigned long)wakes, (unsigned long)secs);
+      }
+    } else if (subcmd[0] == 0) {
+      gps.formatStatus(reply, rtc_clock.getCurrentTime());
+    } else {
+      strcpy(reply, "Usage: gps cycle [<wakes> [<hold_secs>] | fix]");
+    }
+    return true;
+  }
+#endif
+  if (strcmp(command, "wake status") == 0) {
+    sprintf(reply, "Wake: %s, first sample at %lu ms, radio ready in %lu ms, batt %u mV (%u after TX)",
+            event_wake ? (system_on_wake ? "event (System ON)" : "event (GPIO sense)") :
+            system_on_wake ? "System ON (RTC2)" : fast_wake ? "fast boot (RTC alarm)" : "cold boot",
+            time_to_first_sample_ms, radio_ready_latency_ms,
+            board.getBattMilliVolts(), board.getLoadedBattMilliVolts());
+    return true;
+  }
+  return false;
+}
+
+// Resolve this wake's schedules from the prefs and start every sampled channel
+static void startSampling(uint32_t now) {
+  const SensorExtendedPrefs* prefs = the_mesh.getExtendedPrefs();
+  sampler.configure(prefs->samples_per_wake, prefs->sample_spacing_ms, prefs->sample_schedules, SAMPLE_MAX_OVERRIDES);
+  if (event_wake) {
+    uint8_t channels[WAKE_MAX_SOURCES];
+    int n = 0;
+    for (int i = 0; i < board.getNumWakeSources(); i++) {
+      if (isEventSource(i)) channels[n++] = event_channels[i];
+    }
+    sampler.restrictTo(channels, n);
+  }
+  sampler.start(now);
+  LOG_DEBUG("Sampling window: %lu ms", sampler.getWindowMillis());
+}
 
 void setup() {
+  profiler.begin();
+  profiler.start(WAKE_PHASE_BOOT);
+  declareEventSources();
+
   // Basic initialization
   pinMode(LED_BUILTIN, OUTPUT);
   digitalWrite(LED_BUILTIN, LOW);
 
+  // Fast-boot path: a headless node woken by its RTC alarm skips the serial wait and
+  // settle delays entirely. USB serial is only attached when VBUS is present or the
+  // user button is held, so a bench/debug session still gets the full boot log.
+  fast_wake = board.wokeFromSystemOff();
+  bool attach_serial = !fast_wake || board.isUsbPowered() || board.isUserButtonPressed();
+
   // Serial
-  size_t begin_serial_wait_ms = ::millis();
-  while (!Serial && (MAX_SERIAL_WAIT_MS > (::millis() - begin_serial_wait_ms))) {
-    ;
+  if (attach_serial) {
+    size_t begin_serial_wait_ms = ::millis();
+    while (!Serial && (MAX_SERIAL_WAIT_MS > (::millis() - begin_serial_wait_ms))) {
+      ;
+    }
+    Serial.begin(115200);
+    if (!fast_wake) {
+      delay(1000);
+    }
   }
-  Serial.begin(115200);
-  delay(1000);
-  MESH_DEBUG_PRINTLN("Setup");
+  LOG_DEBUG("Setup (%s boot, serial %s)", fast_wake ? "fast" : "cold", attach_serial ? "attached" : "skipped");
 
   // Board init
-  MESH_DEBUG_PRINTLN("Calling board.begin()...");
+  LOG_DEBUG("Calling board.begin()...");
   board.begin();
-  MESH_DEBUG_PRINTLN("board.begin() completed");
+  LOG_DEBUG("board.begin() completed");
+  profiler.stop(WAKE_PHASE_BOOT);
+
+  // An OFF-reset without the RTC alarm flag or a wake source (eg. spurious sense wake) is treated as a normal boot
+  event_wake = (board.getStartupReason() == BD_STARTUP_EVENT);
+  fast_wake = (board.getStartupReason() == BD_STARTUP_RTC_ALARM) || event_wake;
 
   // Load wakeup counter from GPREGRET2 (persists across sleep, resets on power cycle)
-  MESH_DEBUG_PRINTLN("Loading wakeup counter...");
+  // Event wakes are not periodic and do not count towards the next advert
+  LOG_DEBUG("Loading wakeup counter...");
   wakeup_count = NRF_POWER->GPREGRET2;
-  MESH_DEBUG_PRINTLN("=== WAKEUP #%d at %lu ms ===", wakeup_count, millis());
-  wakeup_count++;
-
-  // Initialize radio and mesh
-  MESH_DEBUG_PRINTLN("Initializing radio...");
-  if (!radio_init()) {
-    while(1) {
-      digitalWrite(LED_BUILTIN, HIGH);
-      delay(100);
-      digitalWrite(LED_BUILTIN, LOW);
-      delay(100);
-    }
+  LOG_INFO("=== WAKEUP #%d at %lu ms%s ===", wakeup_count, millis(), event_wake ? " (event)" : "");
+  if (!event_wake) wakeup_count++;
+  EventTrace::beginWake();
+  TRACE(TRACE_BOOT, board.getStartupReason(), NRF_POWER->RESETREAS);
+  TRACE(TRACE_WAKE, 0, wakeup_count);
+  if (event_wake) TRACE(TRACE_EVENT_WAKE, board.getWakeEvents(), 0);
+
+  rtc_init();
+
+  profiler.start(WAKE_PHASE_FS_LOAD);
+  // Warm wake: prefs, ACL, identity and derived keys come from the retained-RAM snapshot,
+  // InternalFS is not even mounted unless something needs to be written
+  bool warm_boot = the_mesh.restoreBootSnapshot();
+
+  // Lazy radio (warm wakes only): the SX1262 stays unpowered through sampling and processing,
+  // bringUpRadio() runs when a packet is about to be queued. Cold boots always start the radio,
+  // prefs are not known yet and a new identity needs radio noise for entropy.
+  bool lazy_radio = warm_boot && the_mesh.getExtendedPrefs()->lazy_radio;
+  if (lazy_radio) {
+    LOG_DEBUG("Lazy radio: SX1262 left powered off");
+  } else {
+    initRadioHardware();
   }
 
-  MESH_DEBUG_PRINTLN("Radio initialized successfully");
-  fast_rng.begin(radio_get_rng_seed());
-
-  MESH_DEBUG_PRINTLN("Initializing filesystem...");
+  LOG_DEBUG("Initializing filesystem...");
   FILESYSTEM* fs;
 #if defined(NRF52_PLATFORM) || defined(STM32_PLATFORM)
-  InternalFS.begin();
+  if (!warm_boot) InternalFS.begin();
   fs = &InternalFS;
   IdentityStore store(InternalFS, "");
 #elif defined(ESP32)
-  SPIFFS.begin(true);
+  if (!warm_boot) SPIFFS.begin(true);
   fs = &SPIFFS;
   IdentityStore store(SPIFFS, "/identity");
 #elif defined(RP2040_PLATFORM)
-  LittleFS.begin();
+  if (!warm_boot) LittleFS.begin();
   fs = &LittleFS;
   IdentityStore store(LittleFS, "/identity");
-  store.begin();
+  if (!warm_boot) store.begin();
 #else
   #error "need to define filesystem"
 #endif
-  MESH_DEBUG_PRINTLN("Loading identity...");
-  if (!store.load("_main", the_mesh.self_id)) {
-    MESH_DEBUG_PRINTLN("Generating new keypair");
-    the_mesh.self_id = radio_new_identity();   // create new random identity
-    int count = 0;
-    while (count < 10 && (the_mesh.self_id.pub_key[0] == 0x00 || the_mesh.self_id.pub_key[0] == 0xFF)) {  // reserved id hashes
-      the_mesh.self_id = radio_new_identity(); count++;
+  if (warm_boot) {
+    LOG_DEBUG("Identity restored from boot snapshot");
+  } else {
+    LOG_DEBUG("Loading identity...");
+    if (!store.load("_main", the_mesh.self_id)) {
+      LOG_DEBUG("Generating new keypair");
+      the_mesh.self_id = radio_new_identity();   // create new random identity
+      int count = 0;
+      while (count < 10 && (the_mesh.self_id.pub_key[0] == 0x00 || the_mesh.self_id.pub_key[0] == 0xFF)) {  // reserved id hashes
+        the_mesh.self_id = radio_new_identity(); count++;
+      }
+      store.save("_main", the_mesh.self_id);
     }
-    store.save("_main", the_mesh.self_id);
+    LOG_DEBUG("Identity loaded");
   }
-  MESH_DEBUG_PRINTLN("Identity loaded");
+  profiler.stop(WAKE_PHASE_FS_LOAD);
 
   // Initialize state machine
-  MESH_DEBUG_PRINTLN("Initializing state machine...");
+  LOG_DEBUG("Initializing state machine...");
   current_state = SAMPLING;
   awake_start_time = millis();
   state_start_time = awake_start_time;
-  sample_count = 0;
-  last_sample_time = 0;
-
-  MESH_DEBUG_PRINTLN("Setup complete, entering main loop");
+  samples_taken = 0;
+  sampler.reset();
+
+  LOG_DEBUG("Setup complete, entering main loop");
+
+  LOG_DEBUG("Calling sensors.begin()...");
+  profiler.start(WAKE_PHASE_SENSORS_BEGIN);
+  // Warm wakes trust the presence map from the last full probe: with no sensor fitted the I2C
+  // probe of every driver (and the rail settle wait) is skipped and 3V3_S is switched back off.
+  // Cold boots always probe, so newly fitted modules are found after a reset.
+  if (warm_boot && sensors.beginCached(the_mesh.getExtendedPrefs()->sensor_presence)) {
+    board.setSensorPower(false);
+  } else {
+    board.waitSensorPowerReady();
+    sensors.begin();
+  }
+  profiler.stop(WAKE_PHASE_SENSORS_BEGIN);
+  LOG_DEBUG("sensors.begin() completed");
+
+  LOG_DEBUG("Calling the_mesh.begin()...");
+  profiler.start(WAKE_PHASE_FS_LOAD);
+  the_mesh.begin(fs, !warm_boot);
+  if (!sensors.wasProbeSkipped() && the_mesh.getExtendedPrefs()->sensor_presence != sensors.getPresenceMap()) {
+    the_mesh.getExtendedPrefs()->sensor_presence = sensors.getPresenceMap();
+    the_mesh.savePrefs();   // only written when the fitted hardware changed
+  }
+  profiler.stop(WAKE_PHASE_FS_LOAD);
+  if (!lazy_radio) {
+    bringUpRadio();
+  }
+  LOG_DEBUG("the_mesh.begin() completed");
+#if ENV_INCLUDE_GPS
+  startGps();   // searches in the background from here, alongside sampling and TX
+#endif
 
-  MESH_DEBUG_PRINTLN("Calling sensors.begin()...");
-  sensors.begin();
-  MESH_DEBUG_PRINTLN("sensors.begin() completed");
+  // Sampled channels: LPP channel, type, reader, then count/spacing/warm-up/reducer
+  // (count 0 = the default schedule from the prefs, "sample set")
+  sampler.addChannel(TELEM_CHANNEL_BATTERY, LPP_VOLTAGE, readBatteryVolts);
+  // sampler.addChannel(APP_CHANNEL_DISTANCE, LPP_DISTANCE, readDistance, NULL, 8, 50, 30, REDUCE_MEDIAN);
 
-  MESH_DEBUG_PRINTLN("Calling the_mesh.begin()...");
-  the_mesh.begin(fs);
-  MESH_DEBUG_PRINTLN("the_mesh.begin() completed");
+  // Telemetry sources, in the order their values appear in the reading
+  the_mesh.addTelemetrySource(addSampledTelemetry);
+  the_mesh.addTelemetrySource(addEventTelemetry);
+  the_mesh.addTelemetrySource(addSensorTelemetry);
+  the_mesh.addTelemetrySource(addEnergyTelemetry);
+  // the_mesh.addTelemetrySource(addBmeTelemetry);
 
   // ============================================================
   // APPLICATION SENSOR INITIALIZATION
@@ -315,9 +522,9 @@ void setup() {
   // Wire.begin();
   // if (bme.begin(0x76)) {
   //   bme_initialized = true;
-  //   MESH_DEBUG_PRINTLN("BME280 initialized");
+  //   LOG_DEBUG("BME280 initialized");
   // } else {
-  //   MESH_DEBUG_PRINTLN("BME280 initialization failed!");
+  //   LOG_DEBUG("BME280 initialization failed!");
   // }
 
   // Example 2: Analog Sensor
@@ -335,7 +542,7 @@ void setup() {
   // Set state pointer for exit command
   the_mesh.setStatePointer(&current_state);
 
-  MESH_DEBUG_PRINTLN("===== SETUP COMPLETE - ENTERING LOOP() =====");
+  LOG_DEBUG("===== SETUP COMPLETE - ENTERING LOOP() =====");
   // Fall through to loop()
 }
 
@@ -359,6 +566,9 @@ void handleSerialCommands(uint32_t now) {
   if (len > 0 && command[len - 1] == '\r') {
     command[len - 1] = 0;
 
+    // A CLI session implies interactive/remote admin, which needs the radio listening
+    bringUpRadio();
+
     char reply[160];
     the_mesh.handleCommand(0, command, reply);
     if (reply[0]) {
@@ -367,15 +577,69 @@ void handleSerialCommands(uint32_t now) {
     command[0] = 0;
 
     // Enter interactive mode when a command is received (unless explicitly exiting)
-    if (current_state != INTERACTIVE_MODE && current_state != READY_TO_SLEEP) {
-      MESH_DEBUG_PRINTLN("Command received, entering interactive mode, the sleep mode will resume after 60s of inactivity");
+    if (current_state != INTERACTIVE_MODE && current_state != WAITING_FOR_TX && current_state != READY_TO_SLEEP) {
+      LOG_DEBUG("Command received, entering interactive mode, the sleep mode will resume after 60s of inactivity");
       current_state = INTERACTIVE_MODE;
       state_start_time = now;
     }
     // Update last activity time (only if not exiting)
     if (current_state == INTERACTIVE_MODE) {
       last_interactive_activity = now;
+      remote_session = false;   // someone is on the console, use the serial timeout
+    }
+  }
+}
+
+// ============================================================
+// SYSTEM-ON IDLE BETWEEN SAMPLES
+// ============================================================
+// Sleeps the core until the deadline, in IDLE_SLICE_MS steps so a pending radio
+// IRQ (DIO1) or serial input is serviced within one slice.
+static void idleUntil(uint32_t deadline) {
+  while ((int32_t)(deadline - millis()) > 0) {
+    if (board.isRadioIrqPending() || the_mesh.hasPendingWork() || Serial.available()) {
+      return;
     }
+    uint32_t remaining = deadline - millis();
+    uint32_t slice = remaining < IDLE_SLICE_MS ? remaining : IDLE_SLICE_MS;
+    uint32_t start = millis();
+    board.idleCore(slice);
+    idle_ms_total += millis() - start;
+  }
+}
+
+// ============================================================
+// SYSTEM ON WAKE
+// ============================================================
+// Start a new cycle after System ON sleep: RAM, sensors and mesh state are intact, only the
+// per-wake state is reset. The radio was powered down and comes back like a lazy warm wake.
+static void beginSystemOnWake() {
+  system_on_wake = true;
+  fast_wake = true;
+  event_wake = (board.getStartupReason() == BD_STARTUP_EVENT);
+  if (!event_wake) wakeup_count++;
+  LOG_INFO("=== WAKEUP #%d (System ON%s) ===", wakeup_count, event_wake ? ", event" : "");
+  EventTrace::beginWake();
+  TRACE(TRACE_WAKE, 1, wakeup_count);
+  if (event_wake) TRACE(TRACE_EVENT_WAKE, board.getWakeEvents(), 1);
+
+  profiler.beginWake();
+  the_mesh.beginWake();
+  awake_start_time = millis();
+  state_start_time = awake_start_time;
+  current_state = SAMPLING;
+  samples_taken = 0;
+  sampler.reset();
+  idle_ms_total = 0;
+  packets_dropped = 0;
+  remote_session = false;
+  airtime_base = the_mesh.getTotalAirTime();
+#if ENV_INCLUDE_GPS
+  startGps();
+#endif
+
+  if (!the_mesh.getExtendedPrefs()->lazy_radio) {
+    bringUpRadio();
   }
 }
 
@@ -386,59 +650,71 @@ void loop() {
   uint32_t now = millis();
 
   // Safety timeout: force sleep if awake too long (except in interactive mode)
-  if (current_state != INTERACTIVE_MODE && now - awake_start_time >= MAX_AWAKE_TIME_MS) {
-    MESH_DEBUG_PRINTLN("WARNING: Max awake time (%lu ms) reached, forcing sleep", MAX_AWAKE_TIME_MS);
+  if (current_state != INTERACTIVE_MODE && isAwakeTooLong(now, awake_start_time)) {
+    LOG_WARN("Max awake time (%lu ms) reached, forcing sleep", MAX_AWAKE_TIME_MS);
+    TRACE(TRACE_MAX_AWAKE, 0, now - awake_start_time);
     current_state = READY_TO_SLEEP;
   }
 
   switch (current_state) {
     case SAMPLING: {
-      // Take samples at configured intervals
-      if (now - last_sample_time >= SAMPLE_INTERVAL_MS) {
-        sensor_samples[sample_count] = board.getBattMilliVolts() / 1000.0f;
-
-        // === APPLICATION SENSOR SAMPLING (Optional) ===
-        // If you want to average multiple sensor readings, sample them here
-        // Example:
-        // app_sensor_samples[sample_count] = analogRead(A0) * (3.3 / 4095.0);
-
-        MESH_DEBUG_PRINTLN("Sample %d/%d: %.2fV", sample_count + 1, NUM_SAMPLES, sensor_samples[sample_count]);
-        sample_count++;
-        last_sample_time = now;
-
-        if (sample_count >= NUM_SAMPLES) {
-          current_state = PROCESSING;
-          state_start_time = now;
-          MESH_DEBUG_PRINTLN("Sampling complete, processing...");
-        }
+      // Every channel runs on its own schedule; the window ends with the slowest one
+      if (!sampler.isRunning()) {
+        startSampling(now);
+      }
+      profiler.start(WAKE_PHASE_SAMPLE);
+      int n = sampler.poll(now);
+      profiler.stop(WAKE_PHASE_SAMPLE);
+      if (n > 0 && samples_taken == 0) {
+        time_to_first_sample_ms = now - (system_on_wake ? awake_start_time : 0);   // millis() counts from reset
+        LOG_DEBUG("Time to first sample: %lu ms (%s boot)", time_to_first_sample_ms, fast_wake ? "fast" : "cold");
+      }
+      samples_taken += n;
+
+      if (sampler.isDone()) {
+        current_state = PROCESSING;
+        state_start_time = now;
+        LOG_DEBUG("Sampling complete: %d samples (%lu ms idle), processing...", samples_taken, idle_ms_total);
       }
       break;
     }
 
     case PROCESSING: {
-      // Average samples
-      float avg = 0;
-      for (int i = 0; i < sample_count; i++) {
-        avg += sensor_samples[i];
+#if LOG_ENABLED(LOG_LEVEL_DEBUG)
+      float battery;
+      if (sampler.getValue(TELEM_CHANNEL_BATTERY, battery)) {
+        LOG_DEBUG("Average battery: %.2fV", battery);
       }
-      avg /= sample_count;
+#endif
 
-      MESH_DEBUG_PRINTLN("Average battery: %.2fV", avg);
+      // Event wake: only the triggering channels, sent straight away, no advert
+      if (event_wake) {
+        bool sent = the_mesh.sendEventTelemetry();
+        LOG_DEBUG("Event telemetry %s (sources 0x%02x)", sent ? "sent" : "not sent", board.getWakeEvents());
+        current_state = sent ? WAITING_FOR_TX : READY_TO_SLEEP;
+        state_start_time = now;
+        break;
+      }
 
-      // Broadcast application telemetry (includes battery + custom sensors)
-      broadcastApplicationTelemetry();
-      MESH_DEBUG_PRINTLN("Telemetry broadcast sent");
+      // Broadcast application telemetry (reduced samples + custom sensors)
+      bool telemetry_sent = the_mesh.broadcastTelemetry();
+      if (telemetry_sent) {
+        LOG_DEBUG("Telemetry broadcast sent");
+      }
 
       // Decide if we should also advertise (periodic, based on wakeup counter)
       uint8_t wakeups_per_advert = the_mesh.getExtendedPrefs()->wakeups_per_advert;
+      bool advert_due = isAdvertDue(wakeup_count, wakeups_per_advert);
+      current_state = stateAfterProcessing(advert_due, telemetry_sent);
 
-      if (wakeup_count >= wakeups_per_advert) {
-        MESH_DEBUG_PRINTLN("Wakeup #%d - Time for advertisement!", wakeup_count);
+      if (advert_due) {
+        LOG_DEBUG("Wakeup #%d - Time for advertisement!", wakeup_count);
         wakeup_count = 0;
-        current_state = ADVERTISING;
+      } else if (telemetry_sent) {
+        LOG_DEBUG("Wakeup #%d/%d - Skipping advert", wakeup_count, wakeups_per_advert);
       } else {
-        MESH_DEBUG_PRINTLN("Wakeup #%d/%d - Skipping advert", wakeup_count, wakeups_per_advert);
-        current_state = READY_TO_SLEEP;
+        // Nothing to transmit this wake
+        LOG_DEBUG("Wakeup #%d/%d - Nothing to send, skipping radio", wakeup_count, wakeups_per_advert);
       }
 
       state_start_time = now;
@@ -446,39 +722,128 @@ void loop() {
     }
 
     case ADVERTISING: {
-      the_mesh.sendSelfAdvertisement(16000);
-      MESH_DEBUG_PRINTLN("Self-advertisement sent");
-
-      // Wait a bit for TX to complete
-      delay(300);
+      bringUpRadio();
+      the_mesh.sendSelfAdvertisement(ADVERT_TX_DELAY_MS);
+      LOG_DEBUG("Self-advertisement queued");
+      TRACE(TRACE_ADVERT_TX);
 
-      current_state = READY_TO_SLEEP;
+      current_state = WAITING_FOR_TX;
       state_start_time = now;
       break;
     }
 
+    case WAITING_FOR_TX: {
+      // Sleep as soon as the outbound queue is empty and the radio has finished transmitting
+      if (!the_mesh.hasPendingWork()) {
+        LOG_DEBUG("TX queue drained after %lu ms", now - state_start_time);
+        profiler.add(WAKE_PHASE_TX_QUEUE, now - state_start_time);
+        if (the_mesh.getTotalAirTime() != airtime_base) {
+          board.measureLoadedBattery();   // right after TX, the battery still shows the radio's load
+          LOG_DEBUG("Battery after TX: %d mV", board.getLoadedBattMilliVolts());
+        }
+        bool listen = the_mesh.takeListenWindow();
+        if (listen) {
+          downlink_count_seen = the_mesh.getDownlinkCount();
+          LOG_DEBUG("Listening for downlink (%d ms)", the_mesh.getExtendedPrefs()->listen_window_ms);
+        }
+        current_state = stateAfterTx(listen);
+        state_start_time = now;
+      } else if (isTxDrainTimedOut(now, state_start_time)) {
+        profiler.add(WAKE_PHASE_TX_QUEUE, now - state_start_time);
+        packets_dropped = the_mesh.getPendingTxCount();
+        LOG_WARN("TX drain timeout, %d packet(s) still queued", packets_dropped);
+        TRACE(TRACE_TX_TIMEOUT, packets_dropped);
+        current_state = READY_TO_SLEEP;
+        state_start_time = now;
+      }
+      break;
+    }
+
     case READY_TO_SLEEP: {
+#if ENV_INCLUDE_GPS
+      // A GPS search still running holds the wake up to its fix budget, never past MAX_AWAKE_TIME_MS;
+      // the radio is not needed for it
+      if (gps.isSearching() && !isAwakeTooLong(now, awake_start_time)) {
+        if (board.isRadioPowered() && !the_mesh.hasPendingWork()) {
+          the_mesh.endRadio();
+          board.powerDownRadio();
+        }
+        break;
+      }
+      gps.sleep();   // receiver into backup before the rail (or the core) goes down
+#endif
       // Save wakeup counter to GPREGRET2 (persists across sleep cycles)
       NRF_POWER->GPREGRET2 = wakeup_count;
-      MESH_DEBUG_PRINTLN("Saved wakeup counter: %d", wakeup_count);
+      LOG_DEBUG("Saved wakeup counter: %d", wakeup_count);
 
       uint32_t awake_duration = now - awake_start_time;
-      MESH_DEBUG_PRINTLN("Awake for %lu ms, entering sleep", awake_duration);
+      LOG_INFO("Awake for %lu ms, %d packet(s) dropped unsent, entering sleep", awake_duration, packets_dropped);
+      TRACE(TRACE_SLEEP, packets_dropped, awake_duration);
 
       digitalWrite(LED_BUILTIN, LOW);
-      delay(100);
 
-      board.enterLowPowerSleep(the_mesh.getSleepInterval(DEFAULT_SLEEP_TIME_SECONDS));
+      // Config changes made this wake go to flash once, here rather than on the RX path
+      the_mesh.flushConfig();
+
+      // Phase accounting ends here: everything after this is board sleep entry
+      profiler.add(WAKE_PHASE_SLEEP_ENTRY, millis() - now);
+      uint32_t airtime = the_mesh.getTotalAirTime();
+      uint32_t air_ms = airtime >= airtime_base ? airtime - airtime_base : airtime;
+      profiler.add(WAKE_PHASE_TX_AIRTIME, air_ms);
+      the_mesh.recordTxAirtime(air_ms);
+      profiler.endWake(board.isRadioPowered() ? millis() - board.getRadioPowerOnMillis() : 0);
+
+      // Wake on the next wall-clock slot (multiple of the interval) rather than now + interval,
+      // so the time spent awake does not push every later wake back
+      uint32_t interval = the_mesh.getSleepInterval(DEFAULT_SLEEP_TIME_SECONDS);
+      uint32_t rtc_now = rtc_clock.getCurrentTime();
+      uint32_t woke_at = wakeStartTime(rtc_now, millis() - awake_start_time);
+      uint32_t wake_time = the_mesh.getNextWakeSlot(rtc_now, woke_at, interval, event_wake);
+      board.setWakeSourcesArmed(the_mesh.getExtendedPrefs()->event_wake);
+
+      // Short intervals: System ON on the nRF52 RTC2 is cheaper than a reset + setup() every cycle
+      if (board.prefersSystemOn(interval, profiler.getRebootMicroAh())) {
+        the_mesh.endRadio();
+        if (board.sleepSystemOn(wake_time, rtc_now)) {
+          beginSystemOnWake();
+          break;
+        }
+      }
+      board.enterLowPowerSleepUntil(wake_time, rtc_now);
+      board.enterLowPowerSleep(interval);   // only reached if the absolute alarm could not be set
       // Never returns
       break;
     }
 
+    case LISTENING: {
+      // A login/request/CLI packet from an admin extends the wake into a remote session
+      if (the_mesh.getDownlinkCount() != downlink_count_seen) {
+        LOG_DEBUG("Downlink received, entering interactive mode");
+        downlink_count_seen = the_mesh.getDownlinkCount();
+        remote_session = true;
+        last_interactive_activity = now;
+        current_state = INTERACTIVE_MODE;
+        state_start_time = now;
+      } else if (isListenWindowOver(now, state_start_time, the_mesh.getExtendedPrefs()->listen_window_ms)) {
+        current_state = READY_TO_SLEEP;
+        state_start_time = now;
+      }
+      break;
+    }
+
     case INTERACTIVE_MODE: {
       // Stay awake and responsive - don't sleep
+      // Remote admin traffic counts as activity like serial commands do
+      if (the_mesh.getDownlinkCount() != downlink_count_seen) {
+        downlink_count_seen = the_mesh.getDownlinkCount();
+        last_interactive_activity = now;
+      }
       // Check for inactivity timeout
-      if (now - last_interactive_activity >= INTERACTIVE_TIMEOUT_MS) {
-        MESH_DEBUG_PRINTLN("Interactive mode timeout, resuming normal operation");
-        current_state = READY_TO_SLEEP;
+      uint32_t timeout = remote_session ? REMOTE_SESSION_TIMEOUT_MS : INTERACTIVE_TIMEOUT_MS;
+      if (now - last_interactive_activity >= timeout) {
+        LOG_DEBUG("Interactive mode timeout, resuming normal operation");
+        remote_session = false;
+        current_state = WAITING_FOR_TX;
         state_start_time = now;
       }
       break;
@@ -488,6 +853,9 @@ void loop() {
   // Keep mesh responsive throughout all states
   the_mesh.loop();
   sensors.loop();
+#if ENV_INCLUDE_GPS
+  gps.loop(rtc_clock.getCurrentTime());
+#endif
 #ifdef DISPLAY_CLASS
   ui_task.loop();
 #endif
@@ -495,4 +863,17 @@ void loop() {
 
   // Handle serial commands (supports interactive mode)
   handleSerialCommands(now);
+
+  // Nothing to do until the next sample is due: idle the core instead of spinning
+  if (current_state == SAMPLING && sampler.isRunning() && !sampler.isDone()) {
+    idleUntil(sampler.getNextDue());
+  } else if (current_state == WAITING_FOR_TX && !the_mesh.isTxDue()) {
+    board.idleCore(IDLE_SLICE_MS);   // queued packets are still in their retransmit delay
+  } else if (current_state == LISTENING) {
+    idleUntil(state_start_time + the_mesh.getExtendedPrefs()->listen_window_ms);   // returns on DIO1
+#if ENV_INCLUDE_GPS
+  } else if (current_state == READY_TO_SLEEP && gps.isSearching()) {
+    board.idleCore(IDLE_SLICE_MS);   // held for a GPS fix, NMEA arrives in the UART buffer meanwhile
+#endif
+  }
 }
\ No newline at end of file
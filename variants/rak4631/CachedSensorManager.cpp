@@ -0,0 +1,69 @@
+#include "CachedSensorManager.h"
+#include <MeshCore.h>
+#include "LogLevel.h"
+
+bool CachedSensorManager::begin() {
+  _probe_skipped = false;
+  return EnvironmentSensorManager::begin();
+}
+
+bool CachedSensorManager::beginCached(uint32_t presence) {
+  if ((presence & SENSOR_PRESENCE_VALID) && (presence & ~SENSOR_PRESENCE_VALID) == 0) {
+    LOG_DEBUG("Sensor presence cached: none fitted, probe skipped");
+    _probe_skipped = true;
+    return true;
+  }
+  return false;
+}
+
+uint32_t CachedSensorManager::getPresenceMap() const {
+  if (_probe_skipped) return SENSOR_PRESENCE_VALID;
+
+  uint32_t map = SENSOR_PRESENCE_VALID;
+#if ENV_INCLUDE_AHTX0
+  if (AHTX0_initialized) map |= SENSOR_PRESENT_AHTX0;
+#endif
+#if ENV_INCLUDE_BME280
+  if (BME280_initialized) map |= SENSOR_PRESENT_BME280;
+#endif
+#if ENV_INCLUDE_BMP280
+  if (BMP280_initialized) map |= SENSOR_PRESENT_BMP280;
+#endif
+#if ENV_INCLUDE_SHTC3
+  if (SHTC3_initialized) map |= SENSOR_PRESENT_SHTC3;
+#endif
+#if ENV_INCLUDE_SHT4X
+  if (SHT4X_initialized) map |= SENSOR_PRESENT_SHT4X;
+#endif
+#if ENV_INCLUDE_LPS22HB
+  if (LPS22HB_initialized) map |= SENSOR_PRESENT_LPS22HB;
+#endif
+#if ENV_INCLUDE_INA3221
+  if (INA3221_initialized) map |= SENSOR_PRESENT_INA3221;
+#endif
+#if ENV_INCLUDE_INA219
+  if (INA219_initialized) map |= SENSOR_PRESENT_INA219;
+#endif
+#if ENV_INCLUDE_INA226
+  if (INA226_initialized) map |= SENSOR_PRESENT_INA226;
+#endif
+#if ENV_INCLUDE_INA260
+  if (INA260_initialized) map |= SENSOR_PRESENT_INA260;
+#endif
+#if ENV_INCLUDE_MLX90614
+  if (MLX90614_initialized) map |= SENSOR_PRESENT_MLX90614;
+#endif
+#if ENV_INCLUDE_VL53L0X
+  if (VL53L0X_initialized) map |= SENSOR_PRESENT_VL53L0X;
+#endif
+#if ENV_INCLUDE_BME680
+  if (BME680_initialized) map |= SENSOR_PRESENT_BME680;
+#endif
+#if ENV_INCLUDE_BMP085
+  if (BMP085_initialized) map |= SENSOR_PRESENT_BMP085;
+#endif
+#if ENV_INCLUDE_GPS
+  if (gps_detected) map |= SENSOR_PRESENT_GPS;
+#endif
+  return map;
+}
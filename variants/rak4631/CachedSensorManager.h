@@ -0,0 +1,55 @@
+#pragma once
+
+#include <helpers/sensors/EnvironmentSensorManager.h>
+
+// Presence map bits (one per EnvironmentSensorManager driver)
+#define SENSOR_PRESENT_AHTX0      (1UL << 0)
+#define SENSOR_PRESENT_BME280     (1UL << 1)
+#define SENSOR_PRESENT_BMP280     (1UL << 2)
+#define SENSOR_PRESENT_SHTC3      (1UL << 3)
+#define SENSOR_PRESENT_SHT4X      (1UL << 4)
+#define SENSOR_PRESENT_LPS22HB    (1UL << 5)
+#define SENSOR_PRESENT_INA3221    (1UL << 6)
+#define SENSOR_PRESENT_INA219     (1UL << 7)
+#define SENSOR_PRESENT_INA226     (1UL << 8)
+#define SENSOR_PRESENT_INA260     (1UL << 9)
+#define SENSOR_PRESENT_MLX90614   (1UL << 10)
+#define SENSOR_PRESENT_VL53L0X    (1UL << 11)
+#define SENSOR_PRESENT_BME680     (1UL << 12)
+#define SENSOR_PRESENT_BMP085     (1UL << 13)
+#define SENSOR_PRESENT_GPS        (1UL << 14)
+#define SENSOR_PRESENCE_VALID     (1UL << 31)   // map holds a real scan result
+
+/**
+ * EnvironmentSensorManager that remembers which drivers found hardware
+ *
+ * begin() runs the full probe of every compiled-in driver; getPresenceMap() reports the result
+ * so it can be persisted. On warm wakes beginCached() takes the stored map: when it says nothing
+ * is fitted the whole probe is skipped. The library keeps its driver objects private to its
+ * translation unit, so a subset cannot be initialised on its own - if anything is fitted the
+ * caller still runs the full begin().
+ */
+class CachedSensorManager : public EnvironmentSensorManager {
+public:
+  CachedSensorManager() { }
+#if ENV_INCLUDE_GPS
+  CachedSensorManager(LocationProvider& location) : EnvironmentSensorManager(location) { }
+#endif
+
+  bool begin() override;
+
+  /**
+   * Skip the probe if a previous scan found no hardware
+   * @return true if skipped, false if the caller must run begin()
+   */
+  bool beginCached(uint32_t presence);
+
+  uint32_t getPresenceMap() const;          // result of the last probe, always has SENSOR_PRESENCE_VALID
+  bool wasProbeSkipped() const { return _probe_skipped; }
+#if ENV_INCLUDE_GPS
+  bool isGpsDetected() const { return gps_detected; }
+#endif
+
+private:
+  bool _probe_skipped = false;
+};
@@ -1,5 +1,6 @@
 #include "DS3231Wakeup.h"
 #include <Arduino.h>
+#include "LogLevel.h"
 
 DS3231Wakeup::DS3231Wakeup(TwoWire* wire, uint8_t int_pin)
     : _wire(wire), _int_pin(int_pin) {
@@ -20,14 +21,14 @@ void DS3231Wakeup::begin() {
 
 bool DS3231Wakeup::checkWakeup() {
   // Check DS3231 status register for alarm flag
-  MESH_DEBUG_PRINTLN("\n=== Checking RTC Wakeup ===");
+  LOG_DEBUG("\n=== Checking RTC Wakeup ===");
 
   _wire->beginTransmission(DS3231_I2C_ADDRESS);
   _wire->write(DS3231_STATUS_REG);
   uint8_t i2c_result = _wire->endTransmission();
 
   if (i2c_result != 0) {
-    MESH_DEBUG_PRINTLN("I2C read from RTC failed: %d", i2c_result);
+    LOG_WARN("I2C read from RTC failed: %d", i2c_result);
     return false;
   }
 
@@ -41,46 +42,45 @@ bool DS3231Wakeup::checkWakeup() {
 
   if (_wire->available()) {
     uint8_t status = _wire->read();
-    MESH_DEBUG_PRINTLN("RTC Status register: 0x%02X", status);
-    MESH_DEBUG_PRINTLN("  A1F (Alarm 1 Flag): %d", (status & 0x01) ? 1 : 0);
-    MESH_DEBUG_PRINTLN("  A2F (Alarm 2 Flag): %d", (status & 0x02) ? 1 : 0);
+    LOG_DEBUG("RTC Status register: 0x%02X", status);
+    LOG_DEBUG("  A1F (Alarm 1 Flag): %d", (status & 0x01) ? 1 : 0);
+    LOG_DEBUG("  A2F (Alarm 2 Flag): %d", (status & 0x02) ? 1 : 0);
 
     // Clear the alarm flag
     if (status & 0x01) {  // A1F (Alarm 1 Flag) bit
-      MESH_DEBUG_PRINTLN("Alarm 1 triggered! Clearing flag...");
+      LOG_DEBUG("Alarm 1 triggered! Clearing flag...");
       _wire->beginTransmission(DS3231_I2C_ADDRESS);
       _wire->write(DS3231_STATUS_REG);
       _wire->write(status & ~0x01); // Clear alarm 1 flag
       _wire->endTransmission();
       return true;
     } else {
-      MESH_DEBUG_PRINTLN("Alarm 1 not triggered");
+      LOG_DEBUG("Alarm 1 not triggered");
     }
   } else {
-    MESH_DEBUG_PRINTLN("No data available from RTC");
+    LOG_DEBUG("No data available from RTC");
   }
   return false;
 }
 
-bool DS3231Wakeup::setAlarm(uint16_t seconds) {
-  MESH_DEBUG_PRINTLN("\n=== DS3231 Alarm Setup ===");
+bool DS3231Wakeup::setAlarm(uint32_t seconds) {
+  LOG_DEBUG("\n=== DS3231 Alarm Setup ===");
 
-  // Convert seconds to minutes (round up)
-  uint32_t minutes = (seconds + 59) / 60;
-  MESH_DEBUG_PRINTLN("Sleep duration: %d seconds (%d minutes)", seconds, minutes);
+  if (seconds == 0 || seconds >= DS3231_MAX_ALARM_SECS) {
+    LOG_ERROR("sleep of %lu seconds out of range", (unsigned long)seconds);
+    return false;
+  }
 
-  // Read current time from DS3231
+  // Read current date and time from DS3231 (registers 0x00-0x06 in one burst)
   _wire->beginTransmission(DS3231_I2C_ADDRESS);
   _wire->write(0x00); // Start at seconds register
   if (_wire->endTransmission() != 0) {
-    MESH_DEBUG_PRINTLN("ERROR: I2C write to RTC failed");
+    LOG_ERROR("I2C write to RTC failed");
     return false;
   }
 
-  _wire->requestFrom(DS3231_I2C_ADDRESS, 4);
-
-  if (_wire->available() < 4) {
-    MESH_DEBUG_PRINTLN("ERROR: Only %d bytes available from RTC (expected 4)", _wire->available());
+  if (_wire->requestFrom(DS3231_I2C_ADDRESS, 7) < 7) {
+    LOG_ERROR("Only %d bytes available from RTC (expected 7)", _wire->available());
     return false;
   }
 
@@ -92,76 +92,52 @@ bool DS3231Wakeup::setAlarm(uint16_t seconds) {
   uint8_t current_sec = bcdToDec(_wire->read() & 0x7F);
   uint8_t current_min = bcdToDec(_wire->read() & 0x7F);
   uint8_t current_hour = bcdToDec(_wire->read() & 0x3F);
-  uint8_t current_day = bcdToDec(_wire->read() & 0x07);
-
-  MESH_DEBUG_PRINTLN("Current time: Day %d, %02d:%02d:%02d",
-                    current_day, current_hour, current_min, current_sec);
+  _wire->read();  // day of week
+  uint8_t current_date = bcdToDec(_wire->read() & 0x3F);
+  uint8_t current_month = bcdToDec(_wire->read() & 0x1F);
+  uint8_t current_year = bcdToDec(_wire->read());
 
-  // Calculate wake-up time
-  uint32_t wake_min = current_min + minutes;
-  uint32_t wake_hour = current_hour;
-  uint32_t wake_day = current_day;
+  DateTime now(2000 + current_year, current_month, current_date, current_hour, current_min, current_sec);
+  LOG_DEBUG("Current time: %04d-%02d-%02d %02d:%02d:%02d, sleep %lu seconds",
+                     now.year(), now.month(), now.day(), current_hour, current_min, current_sec, (unsigned long)seconds);
 
-  // Handle overflow
-  if (wake_min >= 60) {
-    wake_hour += wake_min / 60;
-    wake_min = wake_min % 60;
-  }
-
-  if (wake_hour >= 24) {
-    wake_day += wake_hour / 24;
-    wake_hour = wake_hour % 24;
-  }
+  return writeAlarm(DateTime(now.unixtime() + seconds), seconds >= 86400UL);
+}
 
-  if (wake_day > 7) {
-    wake_day = ((wake_day - 1) % 7) + 1;
+bool DS3231Wakeup::setAlarmAt(uint32_t wake_time, uint32_t now) {
+  LOG_DEBUG("\n=== DS3231 Alarm Setup (absolute) ===");
+  if (wake_time <= now || wake_time - now >= DS3231_MAX_ALARM_SECS) {
+    LOG_ERROR("wake time %lu out of range (now %lu)", (unsigned long)wake_time, (unsigned long)now);
+    return false;
   }
 
-  MESH_DEBUG_PRINTLN("Wake time: Day %d, %02d:%02d:00", wake_day, wake_hour, wake_min);
+  // The DS3231 holds UTC broken down from the same UNIX time, so no need to read it back
+  LOG_DEBUG("Sleep duration: %lu seconds", (unsigned long)(wake_time - now));
+  return writeAlarm(DateTime(wake_time), wake_time - now >= 86400UL);
+}
 
-  // Determine alarm mode based on sleep duration
-  // For short sleeps (< 60 min): match minutes and seconds only
-  // For longer sleeps: match hours, minutes, and seconds
-  bool use_hours = (minutes >= 60);
-  MESH_DEBUG_PRINTLN("Alarm mode: %s", use_hours ? "LONG (hrs+mins+secs)" : "SHORT (mins+secs)");
+bool DS3231Wakeup::writeAlarm(const DateTime& when, bool match_date) {
+  LOG_DEBUG("Wake time: %s%02d %02d:%02d:%02d", match_date ? "date " : "", match_date ? when.day() : 0,
+                     when.hour(), when.minute(), when.second());
 
-  // Set Alarm 1 registers
-  // Seconds = 0 (wake at top of minute)
   _wire->beginTransmission(DS3231_I2C_ADDRESS);
   _wire->write(DS3231_ALARM1_BASE);
-  _wire->write(0x00); // A1M1=0 (match seconds), value=0
-  _wire->endTransmission();
-
-  // Minutes
-  _wire->beginTransmission(DS3231_I2C_ADDRESS);
-  _wire->write(DS3231_ALARM1_BASE + 1);
-  _wire->write(decToBcd(wake_min)); // A1M2=0 (match minutes)
-  _wire->endTransmission();
-
-  // Hours
-  _wire->beginTransmission(DS3231_I2C_ADDRESS);
-  _wire->write(DS3231_ALARM1_BASE + 2);
-  if (use_hours) {
-    _wire->write(decToBcd(wake_hour)); // A1M3=0 (match hours)
-  } else {
-    _wire->write(0x80); // A1M3=1 (ignore hours)
+  _wire->write(decToBcd(when.second()));   // 0x07: A1M1=0 (match seconds)
+  _wire->write(decToBcd(when.minute()));   // 0x08: A1M2=0 (match minutes)
+  _wire->write(decToBcd(when.hour()));     // 0x09: A1M3=0 (match hours)
+  // 0x0A: A1M4=0, DY/DT=0 (match date) for sleeps of a day or more, else A1M4=1 (ignore)
+  _wire->write(match_date ? decToBcd(when.day()) : 0x80);
+  _wire->write(0x80);             // 0x0B-0x0D: Alarm 2 unused (A2IE=0)
+  _wire->write(0x80);
+  _wire->write(0x80);
+  _wire->write(0x05);             // 0x0E control: A1IE=1, INTCN=1
+  _wire->write(0x00);             // 0x0F status: clear A1F/A2F (and OSF), 32kHz output off
+  if (_wire->endTransmission() != 0) {
+    LOG_ERROR("I2C write to RTC failed");
+    return false;
   }
-  _wire->endTransmission();
-
-  // Day/Date (always ignore)
-  _wire->beginTransmission(DS3231_I2C_ADDRESS);
-  _wire->write(DS3231_ALARM1_BASE + 3);
-  _wire->write(0x80); // A1M4=1 (ignore day/date)
-  _wire->endTransmission();
-
-  // Clear alarm flags in status register
-  uint8_t status = readRegister(DS3231_STATUS_REG);
-  writeRegister(DS3231_STATUS_REG, status & 0xFC); // Clear A1F and A2F
-
-  // Enable Alarm 1 interrupt
-  writeRegister(DS3231_CONTROL_REG, 0x05); // A1IE=1, INTCN=1
 
-  MESH_DEBUG_PRINTLN("=== Alarm Setup Complete ===\n");
+  LOG_DEBUG("=== Alarm Setup Complete ===\n");
   return true;
 }
 
@@ -3,6 +3,10 @@
 #include "RTCWakeup.h"
 #include <Wire.h>
 #include <MeshCore.h>
+#include <RTClib.h>   // DateTime
+
+// Longest sleep Alarm 1 can express: date match, so less than the shortest month
+#define DS3231_MAX_ALARM_SECS  (28 * 86400UL)
 
 // DS3231 I2C address and register definitions
 #define DS3231_I2C_ADDRESS 0x68
@@ -44,6 +48,12 @@ private:
    */
   uint8_t decToBcd(uint8_t val);
 
+  /**
+   * Program Alarm 1 for hh:mm:ss (and the date when match_date), clear flags and enable
+   * the interrupt. Registers 0x07-0x0F are written in a single I2C transaction
+   */
+  bool writeAlarm(const DateTime& when, bool match_date);
+
 public:
   /**
    * Constructor
@@ -61,5 +71,6 @@ public:
 
   // RTCWakeup interface implementation
   bool checkWakeup() override;
-  bool setAlarm(uint16_t seconds) override;
+  bool setAlarm(uint32_t seconds) override;
+  bool setAlarmAt(uint32_t wake_time, uint32_t now) override;
 };
@@ -0,0 +1,85 @@
+#include "EventTrace.h"
+#include "RetainedRAM.h"
+
+#define TRACE_MAGIC   0x45435254   // 'TRCE'
+
+struct TraceRecord {
+  uint16_t wake;    // low 16 bits of the wake number
+  uint16_t ms;      // ms into the wake, saturates at 65535
+  uint8_t id;       // TraceEvent
+  uint8_t reserved;
+  uint16_t a;
+  uint32_t b;
+};
+
+struct TraceState {
+  uint16_t wake;
+  uint16_t head;    // next slot
+  uint16_t count;
+};
+
+// only the ring indices are CRC-guarded: a record costs a 12-byte copy and a CRC of 6 bytes,
+// and after a power cycle 'count' is 0 so the garbage records are never read
+static RETAINED_RAM RetainedBlock<TraceState, TRACE_MAGIC> trace;
+static RETAINED_RAM TraceRecord records[TRACE_DEPTH];
+static bool trace_ready = false;
+static uint32_t wake_start_ms = 0;
+
+static const char* const event_names[TRACE_NUM_EVENTS] = {
+  "-", "boot", "wake", "sleep", "max_awake", "telem_tx", "advert_tx", "tx_timeout",
+  "login", "discover_drop", "config_flush", "tx_power", "rtc_error", "fs_error", "gps",
+  "event_wake"
+};
+
+static TraceState& state() {
+  if (!trace_ready) {
+    trace.retain();
+    RetainedRAM::retain(records, sizeof(records));
+    if (!trace.isValid()) {
+      memset(&trace.data, 0, sizeof(trace.data));
+      trace.commit();
+    }
+    trace_ready = true;
+  }
+  return trace.data;
+}
+
+void EventTrace::beginWake() {
+  state().wake++;
+  trace.commit();
+  wake_start_ms = millis();
+}
+
+void EventTrace::record(TraceEvent id, uint16_t a, uint32_t b) {
+  TraceState& st = state();
+  uint32_t ms = millis() - wake_start_ms;
+
+  TraceRecord& r = records[st.head];
+  r.wake = st.wake;
+  r.ms = ms > 0xFFFF ? 0xFFFF : ms;
+  r.id = id;
+  r.reserved = 0;
+  r.a = a;
+  r.b = b;
+  st.head = (st.head + 1) % TRACE_DEPTH;
+  if (st.count < TRACE_DEPTH) st.count++;
+  trace.commit();
+}
+
+void EventTrace::dump(Stream& out) {
+  TraceState& st = state();
+  out.printf("trace: %d events\n", st.count);
+  uint16_t i = (st.head + TRACE_DEPTH - st.count) % TRACE_DEPTH;
+  for (uint16_t n = 0; n < st.count; n++) {
+    const TraceRecord& r = records[i];
+    out.printf("%u %u.%03u %s %u %lu\n", r.wake, r.ms / 1000, r.ms % 1000,
+               r.id < TRACE_NUM_EVENTS ? event_names[r.id] : "?", r.a, (unsigned long)r.b);
+    i = (i + 1) % TRACE_DEPTH;
+  }
+}
+
+void EventTrace::clear() {
+  TraceState& st = state();
+  st.head = st.count = 0;
+  trace.commit();
+}
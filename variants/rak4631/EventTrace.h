@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Binary event trace in a retained-RAM ring, survives system-off and resets
+ *
+ * The production replacement for serial logging: an event is 12 bytes (wake number, ms into
+ * the wake, event id, two arguments) written to RAM, with no formatting and no UART. The ring
+ * keeps the last TRACE_DEPTH events and is printed on demand (CLI "log", after the telemetry
+ * log). TRACE() compiles to nothing with -D SENSOR_TRACE=0.
+ */
+#ifndef SENSOR_TRACE
+  #define SENSOR_TRACE   1
+#endif
+#ifndef TRACE_DEPTH
+  #define TRACE_DEPTH    64
+#endif
+
+enum TraceEvent : uint8_t {
+  TRACE_NONE,
+  TRACE_BOOT,             // a: board startup reason, b: NRF_POWER->RESETREAS
+  TRACE_WAKE,             // a: 1 = System ON wake, b: wakeup counter
+  TRACE_SLEEP,            // a: packets left unsent, b: awake ms
+  TRACE_MAX_AWAKE,        // b: awake ms when the safety timeout forced sleep
+  TRACE_TELEM_TX,         // a: body bytes, b: TELEM_FLAG_* flags
+  TRACE_ADVERT_TX,
+  TRACE_TX_TIMEOUT,       // a: packets still queued
+  TRACE_LOGIN,            // a: 1 = accepted, b: permissions
+  TRACE_DISCOVER_DROP,    // a: 0 = repeated tag, 1 = wake budget, 2 = rate, b: tag
+  TRACE_CONFIG_FLUSH,     // a: 1 = journaled, 2 = compacted, b: journal bytes
+  TRACE_TX_POWER,         // a: new TX power dBm
+  TRACE_RTC_ERROR,        // a: 1 = no RTC, 2 = alarm not set
+  TRACE_FS_ERROR,         // a: 1 = telemetry log write failed
+  TRACE_GPS,              // a: 1 = fix, 0 = search timed out, b: search ms
+  TRACE_EVENT_WAKE,       // a: wake sources that fired (bit per source), b: 1 = System ON wake
+  TRACE_NUM_EVENTS
+};
+
+class EventTrace {
+public:
+  static void beginWake();   // new wake: bump the wake number, restart the ms clock
+  static void record(TraceEvent id, uint16_t a = 0, uint32_t b = 0);
+  static void dump(Stream& out);
+  static void clear();
+};
+
+#if SENSOR_TRACE
+  #define TRACE(...)   EventTrace::record(__VA_ARGS__)
+#else
+  #define TRACE(...)   do { } while (0)
+#endif
@@ -0,0 +1,206 @@
+#include "GpsDutyCycle.h"
+#include <MeshCore.h>
+#include <RTClib.h>
+#include "RetainedRAM.h"
+#include "EventTrace.h"
+#include "LogLevel.h"
+
+#if ENV_INCLUDE_GPS
+
+#define GPS_FIX_MAGIC        0x46535047   // 'GPSF'
+#define GPS_AID_MIN_TIME     1700000000   // RTC earlier than this has not been set, no time aiding
+#define GPS_AID_POS_ACC_CM   100000       // stored fix as position aiding: 1 km (the node may have moved)
+#define GPS_AID_TIME_ACC_S   2            // RTC accuracy claimed for the time aiding
+
+struct GpsFixState {
+  int32_t lat;              // 1e-6 degrees (LocationProvider units)
+  int32_t lon;
+  int32_t alt_mm;
+  uint32_t fix_time;        // RTC time of the fix, 0 = none stored
+  uint32_t ttff_ms;         // time to fix of the last successful search
+  uint16_t wakes_since_fix; // wakes started since the last fix (or failed search)
+  uint8_t fix_requested;    // requestFix() since the last search
+  uint8_t misses;           // searches that timed out since the last fix, saturates at 255
+};
+
+static RETAINED_RAM RetainedBlock<GpsFixState, GPS_FIX_MAGIC> gps_fix;
+
+void GpsDutyCycle::begin(LocationProvider& location, Stream& ubx, bool enabled, uint8_t fix_wakes, uint8_t fix_secs) {
+  _location = &location;
+  _ubx = &ubx;
+  _fix_wakes = fix_wakes;
+  _fix_secs = fix_secs < GPS_FIX_MAX_SECS ? fix_secs : GPS_FIX_MAX_SECS;
+
+  gps_fix.retain();
+  if (!gps_fix.isValid()) {
+    memset(&gps_fix.data, 0, sizeof(gps_fix.data));
+  }
+  GpsFixState& st = gps_fix.data;
+  if (st.wakes_since_fix < 0xFFFF) st.wakes_since_fix++;
+  gps_fix.commit();
+
+  if (!enabled) {
+    sendBackup();
+    _state = GPS_OFF;
+    return;
+  }
+
+  bool due = fix_wakes == 0 || st.fix_time == 0 || st.fix_requested || st.wakes_since_fix >= fix_wakes;
+  if (due) {
+    startSearch(_fix_secs * 1000UL);
+  } else {
+    sendBackup();   // powered from the rail anyway, stop it searching
+    _state = GPS_IDLE;
+    LOG_DEBUG("GPS: using stored fix (%d/%d wakes)", st.wakes_since_fix, fix_wakes);
+  }
+}
+
+void GpsDutyCycle::startSearch(uint32_t budget_ms) {
+  static const uint8_t wake_bytes[] = { 0xFF, 0xFF, 0xFF, 0xFF };   // UART RX activity ends backup mode
+  _ubx->write(wake_bytes, sizeof(wake_bytes));
+
+  _search_start = millis();
+  _deadline = _search_start + budget_ms;
+  _stale_time = _location->getTimestamp();
+  _state = GPS_WAKING;
+  LOG_DEBUG("GPS: searching, %lu ms budget", (unsigned long)(_deadline - _search_start));
+}
+
+void GpsDutyCycle::loop(uint32_t rtc_now) {
+  if (!isSearching()) return;
+
+  uint32_t now = millis();
+  if (_state == GPS_WAKING && now - _search_start >= GPS_WAKE_MS) {
+    sendAiding(rtc_now);
+    _state = GPS_SEARCHING;
+  }
+
+  GpsFixState& st = gps_fix.data;
+  if (_location->isValid() && _location->getTimestamp() != _stale_time) {
+    st.lat = _location->getLatitude();
+    st.lon = _location->getLongitude();
+    st.alt_mm = _location->getAltitude();
+    st.fix_time = rtc_now;
+    st.ttff_ms = now - _search_start;
+    st.wakes_since_fix = 0;
+    st.fix_requested = 0;
+    st.misses = 0;
+    gps_fix.commit();
+    LOG_INFO("GPS fix after %lu ms: %.6f, %.6f", (unsigned long)st.ttff_ms, st.lat / 1000000.0, st.lon / 1000000.0);
+    TRACE(TRACE_GPS, 1, st.ttff_ms);
+    sendBackup();
+    _state = GPS_IDLE;
+  } else if ((int32_t)(now - _deadline) >= 0) {
+    // keep the old fix and retry after another fix_wakes wakes, not on every wake
+    st.wakes_since_fix = 0;
+    st.fix_requested = 0;
+    if (st.misses < 0xFF) st.misses++;
+    gps_fix.commit();
+    LOG_WARN("GPS: no fix within %lu ms (%d missed)", (unsigned long)(now - _search_start), st.misses);
+    TRACE(TRACE_GPS, 0, now - _search_start);
+    sendBackup();
+    _state = GPS_IDLE;
+  }
+}
+
+void GpsDutyCycle::sleep() {
+  if (!isSearching()) return;
+  sendBackup();
+  _state = GPS_IDLE;
+}
+
+void GpsDutyCycle::requestFix() {
+  gps_fix.data.fix_requested = 1;
+  gps_fix.commit();
+  if (_state == GPS_IDLE) {
+    startSearch(GPS_FIX_MAX_SECS * 1000UL);   // the wake hold in main.cpp still caps it
+  }
+}
+
+bool GpsDutyCycle::hasFix() const {
+  return gps_fix.isValid() && gps_fix.data.fix_time != 0;
+}
+
+bool GpsDutyCycle::getFix(float& lat, float& lon, float& alt) const {
+  if (!hasFix()) return false;
+  lat = gps_fix.data.lat / 1000000.0f;
+  lon = gps_fix.data.lon / 1000000.0f;
+  alt = gps_fix.data.alt_mm / 1000.0f;
+  return true;
+}
+
+uint32_t GpsDutyCycle::getFixTime() const {
+  return hasFix() ? gps_fix.data.fix_time : 0;
+}
+
+void GpsDutyCycle::formatStatus(char* reply, uint32_t rtc_now) const {
+  const char* state = _state == GPS_OFF ? "off" : isSearching() ? "searching" : "backup";
+  char* dp = reply;
+  dp += sprintf(dp, "GPS: %s, every %d wakes (%d s)", state, _fix_wakes, _fix_secs);
+  if (!hasFix()) {
+    strcpy(dp, ", no fix stored");
+    return;
+  }
+  const GpsFixState& st = gps_fix.data;
+  sprintf(dp, ", fix %.5f,%.5f %lu s ago (ttff %lu ms), %d wakes since, %d missed",
+          st.lat / 1000000.0, st.lon / 1000000.0, (unsigned long)(rtc_now - st.fix_time),
+          (unsigned long)st.ttff_ms, st.wakes_since_fix, st.misses);
+}
+
+// UBX frame: sync, class, id, length (LE), payload, 8-bit Fletcher checksum over class..payload
+void GpsDutyCycle::sendUbx(uint8_t cls, uint8_t id, const uint8_t* payload, uint16_t len) {
+  uint8_t hdr[6] = { 0xB5, 0x62, cls, id, (uint8_t)(len & 0xFF), (uint8_t)(len >> 8) };
+  uint8_t ck_a = 0, ck_b = 0;
+  for (int i = 2; i < 6; i++) { ck_a += hdr[i]; ck_b += ck_a; }
+  for (int i = 0; i < len; i++) { ck_a += payload[i]; ck_b += ck_a; }
+
+  _ubx->write(hdr, sizeof(hdr));
+  _ubx->write(payload, len);
+  _ubx->write(ck_a);
+  _ubx->write(ck_b);
+}
+
+static void putU16(uint8_t* p, uint16_t v) { p[0] = v & 0xFF; p[1] = v >> 8; }
+static void putU32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = (v >> (8 * i)) & 0xFF; }
+
+// UBX-RXM-PMREQ v1: indefinite backup, forced, woken by UART RX
+void GpsDutyCycle::sendBackup() {
+  uint8_t p[16];
+  memset(p, 0, sizeof(p));
+  // version 0x00, duration 0: until woken
+  putU32(&p[8], 0x06);      // flags: backup | force
+  putU32(&p[12], 0x08);     // wakeupSources: uartrx
+  sendUbx(0x02, 0x41, p, sizeof(p));
+  _ubx->flush();            // all of it on the wire before the rail or the core goes down
+}
+
+// UBX-MGA-INI-POS_LLH from the stored fix and UBX-MGA-INI-TIME_UTC from the RTC
+void GpsDutyCycle::sendAiding(uint32_t rtc_now) {
+  if (hasFix()) {
+    uint8_t p[20];
+    memset(p, 0, sizeof(p));
+    p[0] = 0x01;                                            // type: POS_LLH
+    putU32(&p[4], (uint32_t)(gps_fix.data.lat * 10));       // 1e-7 degrees
+    putU32(&p[8], (uint32_t)(gps_fix.data.lon * 10));
+    putU32(&p[12], (uint32_t)(gps_fix.data.alt_mm / 10));   // cm
+    putU32(&p[16], GPS_AID_POS_ACC_CM);
+    sendUbx(0x13, 0x40, p, sizeof(p));
+  }
+  if (rtc_now >= GPS_AID_MIN_TIME) {
+    DateTime t(rtc_now);
+    uint8_t p[24];
+    memset(p, 0, sizeof(p));
+    p[0] = 0x10;                  // type: TIME_UTC
+    p[3] = 0x80;                  // leapSecs: unknown (-128)
+    putU16(&p[4], t.year());
+    p[6] = t.month();
+    p[7] = t.day();
+    p[8] = t.hour();
+    p[9] = t.minute();
+    p[10] = t.second();
+    putU16(&p[16], GPS_AID_TIME_ACC_S);
+    sendUbx(0x13, 0x40, p, sizeof(p));
+  }
+}
+
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Arduino.h>
+#include <helpers/sensors/LocationProvider.h>
+
+/**
+ * GPS duty cycling across sleep cycles, last fix kept in retained RAM
+ *
+ * A fix is only searched for every gps_fix_wakes wakes, after requestFix() (eg. from a motion
+ * sensor) or when no fix is stored yet. Other wakes report the retained fix and put a u-blox
+ * receiver straight into backup mode (UBX-RXM-PMREQ), which keeps its ephemeris and RTC while
+ * the backup supply holds, so the next search is a hot start. A search also gets the stored
+ * position and the RTC time as aiding (UBX-MGA-INI), which helps when the backup was lost.
+ *
+ * The search runs in the background of the normal wake (loop() is polled from the main loop);
+ * the wake is only held for it up to the fix budget, which is capped below MAX_AWAKE_TIME_MS.
+ * Receivers that do not speak UBX ignore the commands and simply run during search wakes.
+ */
+#define GPS_FIX_MAX_SECS     45     // fix budget cap, counted from the start of the search
+#define GPS_WAKE_MS          100    // receiver wake-up (UART RX) before the aiding is sent
+
+class GpsDutyCycle {
+public:
+  GpsDutyCycle() : _location(NULL), _ubx(NULL), _state(GPS_OFF), _fix_wakes(0), _fix_secs(0) { }
+
+  /**
+   * Start of a wake (reset or System ON) with a receiver detected: decide whether this wake searches
+   * @param enabled    GPS on in the node prefs, a disabled receiver is kept in backup
+   * @param fix_wakes  search every N wakes (0 = every wake, no duty cycling)
+   * @param fix_secs   fix budget of a search wake (capped at GPS_FIX_MAX_SECS)
+   */
+  void begin(LocationProvider& location, Stream& ubx, bool enabled, uint8_t fix_wakes, uint8_t fix_secs);
+
+  void loop(uint32_t rtc_now);   // store a new fix, time out a search, send the aiding
+  void sleep();                  // before sleep: receiver into backup if still running
+
+  void requestFix();             // search this wake (if idle) or the next one, eg. on motion
+  bool isSearching() const { return _state == GPS_WAKING || _state == GPS_SEARCHING; }
+
+  bool hasFix() const;
+  bool getFix(float& lat, float& lon, float& alt) const;   // degrees, metres
+  uint32_t getFixTime() const;   // RTC time of the stored fix, 0 = none
+
+  void formatStatus(char* reply, uint32_t rtc_now) const;   // one line, fits a CLI reply
+
+private:
+  enum State : uint8_t { GPS_OFF, GPS_WAKING, GPS_SEARCHING, GPS_IDLE };
+
+  void startSearch(uint32_t budget_ms);
+  void sendUbx(uint8_t cls, uint8_t id, const uint8_t* payload, uint16_t len);
+  void sendBackup();
+  void sendAiding(uint32_t rtc_now);
+
+  LocationProvider* _location;
+  Stream* _ubx;
+  State _state;
+  uint8_t _fix_wakes;
+  uint8_t _fix_secs;
+  uint32_t _search_start;   // millis()
+  uint32_t _deadline;       // millis() the search gives up
+  long _stale_time;         // provider's fix time at the start of the search (not a new fix)
+};
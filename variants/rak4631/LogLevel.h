@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Compile-time log levels
+ *
+ * LOG_ERROR/LOG_WARN/LOG_INFO/LOG_DEBUG calls above SENSOR_LOG_LEVEL expand to nothing, so
+ * neither the call nor its format string is linked into flash. Without an explicit level,
+ * MESH_DEBUG builds log everything and other builds log nothing. Production builds pick a
+ * level (e.g. -D SENSOR_LOG_LEVEL=LOG_LEVEL_WARN) and rely on EventTrace for what happened
+ * during a wake.
+ */
+#define LOG_LEVEL_NONE    0
+#define LOG_LEVEL_ERROR   1
+#define LOG_LEVEL_WARN    2
+#define LOG_LEVEL_INFO    3    // about one line per wake: wake, telemetry TX, sleep
+#define LOG_LEVEL_DEBUG   4
+
+#ifndef SENSOR_LOG_LEVEL
+  #if MESH_DEBUG
+    #define SENSOR_LOG_LEVEL   LOG_LEVEL_DEBUG
+  #else
+    #define SENSOR_LOG_LEVEL   LOG_LEVEL_NONE
+  #endif
+#endif
+
+#define LOG_ENABLED(level)   (SENSOR_LOG_LEVEL >= (level))   // usable in #if
+
+#if LOG_ENABLED(LOG_LEVEL_ERROR)
+  #define LOG_ERROR(F, ...)  Serial.printf("ERROR: " F "\n", ##__VA_ARGS__)
+#else
+  #define LOG_ERROR(...)     do { } while (0)
+#endif
+
+#if LOG_ENABLED(LOG_LEVEL_WARN)
+  #define LOG_WARN(F, ...)   Serial.printf("WARN: " F "\n", ##__VA_ARGS__)
+#else
+  #define LOG_WARN(...)      do { } while (0)
+#endif
+
+#if LOG_ENABLED(LOG_LEVEL_INFO)
+  #define LOG_INFO(F, ...)   Serial.printf("INFO: " F "\n", ##__VA_ARGS__)
+#else
+  #define LOG_INFO(...)      do { } while (0)
+#endif
+
+#if LOG_ENABLED(LOG_LEVEL_DEBUG)
+  #define LOG_DEBUG(F, ...)  Serial.printf("DEBUG: " F "\n", ##__VA_ARGS__)
+#else
+  #define LOG_DEBUG(...)     do { } while (0)
+#endif
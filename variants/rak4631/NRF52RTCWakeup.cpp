@@ -0,0 +1,79 @@
+#include "NRF52RTCWakeup.h"
+#include <MeshCore.h>
+#include "LogLevel.h"
+
+static SemaphoreHandle_t alarm_sem = NULL;
+static volatile bool alarm_fired = false;
+static volatile bool signalled = false;
+
+extern "C" void RTC2_IRQHandler(void) {
+  if (NRF_RTC2->EVENTS_COMPARE[0]) {
+    NRF_RTC2->EVENTS_COMPARE[0] = 0;
+    NRF_RTC2->INTENCLR = RTC_INTENCLR_COMPARE0_Msk;
+    alarm_fired = true;
+
+    BaseType_t woken = pdFALSE;
+    if (alarm_sem) xSemaphoreGiveFromISR(alarm_sem, &woken);
+    portYIELD_FROM_ISR(woken);
+  }
+}
+
+void NRF52RTCWakeup::begin() {
+  if (_sem) return;
+  _sem = alarm_sem = xSemaphoreCreateBinary();
+
+  NRF_RTC2->TASKS_STOP = 1;
+  NRF_RTC2->PRESCALER = NRF52_RTC_PRESCALER;
+  NRF_RTC2->EVTENCLR = RTC_EVTEN_COMPARE0_Msk;
+  NRF_RTC2->INTENCLR = 0xFFFFFFFF;
+  NRF_RTC2->EVENTS_COMPARE[0] = 0;
+  NRF_RTC2->TASKS_CLEAR = 1;
+  NRF_RTC2->TASKS_START = 1;
+
+  NVIC_SetPriority(RTC2_IRQn, 6);   // below the SoftDevice/USB levels, FreeRTOS-safe
+  NVIC_ClearPendingIRQ(RTC2_IRQn);
+  NVIC_EnableIRQ(RTC2_IRQn);
+  LOG_DEBUG("nRF52 RTC2 wakeup started (%d Hz)", NRF52_RTC_TICK_HZ);
+}
+
+bool NRF52RTCWakeup::checkWakeup() {
+  bool fired = alarm_fired;
+  alarm_fired = false;
+  return fired;
+}
+
+bool NRF52RTCWakeup::setAlarm(uint32_t seconds) {
+  if (seconds == 0 || seconds > NRF52_RTC_MAX_SECS) {
+    LOG_ERROR("sleep of %lu seconds out of range", seconds);
+    return false;
+  }
+  begin();
+
+  alarm_fired = false;
+  signalled = false;
+  xSemaphoreTake(_sem, 0);   // drop a stale give
+  NRF_RTC2->INTENCLR = RTC_INTENCLR_COMPARE0_Msk;
+  NRF_RTC2->EVENTS_COMPARE[0] = 0;
+  NRF_RTC2->CC[0] = (NRF_RTC2->COUNTER + seconds * NRF52_RTC_TICK_HZ) & 0xFFFFFF;
+  NRF_RTC2->INTENSET = RTC_INTENSET_COMPARE0_Msk;
+  LOG_DEBUG("RTC2 alarm in %lu seconds", seconds);
+  return true;
+}
+
+bool NRF52RTCWakeup::setAlarmAt(uint32_t wake_time, uint32_t now) {
+  if (wake_time <= now) return false;
+  return setAlarm(wake_time - now);
+}
+
+void NRF52RTCWakeup::sleep() {
+  while (!alarm_fired && !signalled) {
+    xSemaphoreTake(_sem, portMAX_DELAY);
+  }
+}
+
+void NRF52RTCWakeup::signal() {
+  signalled = true;
+  BaseType_t woken = pdFALSE;
+  if (alarm_sem) xSemaphoreGiveFromISR(alarm_sem, &woken);
+  portYIELD_FROM_ISR(woken);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "RTCWakeup.h"
+#include <Arduino.h>
+#include "SleepMode.h"   // NRF52_RTC_*
+
+/**
+ * nRF52 internal RTC wakeup for System ON sleep
+ *
+ * Unlike the external DS3231/RV-3028 path (System OFF, wake = reset), the core keeps RAM,
+ * peripheral and driver state: sleep() blocks the calling task on the RTC2 compare event, so
+ * FreeRTOS tickless idle parks the core until the alarm. Worth it for short intervals, where
+ * re-running setup() each cycle costs more than the higher System ON sleep current.
+ */
+class NRF52RTCWakeup : public RTCWakeup {
+public:
+  NRF52RTCWakeup() : _sem(NULL) { }
+
+  void begin();
+
+  bool checkWakeup() override;   // compare event fired since the alarm was set
+  bool setAlarm(uint32_t seconds) override;
+  bool setAlarmAt(uint32_t wake_time, uint32_t now) override;
+
+  /**
+   * Block until the alarm fires or signal() is called (System ON, core in WFE via the idle task)
+   */
+  void sleep();
+  void signal();   // end sleep() early, eg. from a wake pin ISR (checkWakeup() stays false)
+
+private:
+  SemaphoreHandle_t _sem;
+};
@@ -2,6 +2,8 @@
 #include "RAK4631Board.h"
 #include "DS3231Wakeup.h"
 #include "RV3028Wakeup.h"
+#include "LogLevel.h"
+#include "EventTrace.h"
 
 #include <bluefruit.h>
 #include <Wire.h>
@@ -10,18 +12,18 @@ static BLEDfu bledfu;
 
 static void connect_callback(uint16_t conn_handle) {
   (void)conn_handle;
-  MESH_DEBUG_PRINTLN("BLE client connected");
+  LOG_DEBUG("BLE client connected");
 }
 
 static void disconnect_callback(uint16_t conn_handle, uint8_t reason) {
   (void)conn_handle;
   (void)reason;
 
-  MESH_DEBUG_PRINTLN("BLE client disconnected");
+  LOG_DEBUG("BLE client disconnected");
 }
 
 void RAK4631Board::begin() {
-  MESH_DEBUG_PRINTLN("\n=== Board Startup Debug ===");
+  LOG_DEBUG("\n=== Board Startup Debug ===");
 
 #if defined(PIN_BOARD_SDA) && defined(PIN_BOARD_SCL)
   Wire.setPins(PIN_BOARD_SDA, PIN_BOARD_SCL);
@@ -32,35 +34,35 @@ void RAK4631Board::begin() {
 
   // Now initialize RTC for future use
   if (!rtc_wakeup) {
-    MESH_DEBUG_PRINTLN("Initializing RTC wakeup...");
+    LOG_DEBUG("Initializing RTC wakeup...");
 
     #ifdef FORCE_RTC_DS3231
       // Compile-time forced DS3231
-      MESH_DEBUG_PRINTLN("Using DS3231 (compile-time forced)");
+      LOG_DEBUG("Using DS3231 (compile-time forced)");
       rtc_wakeup = new DS3231Wakeup(&Wire, PIN_RTC_INT);
       static_cast<DS3231Wakeup*>(rtc_wakeup)->begin();
 
     #elif defined(FORCE_RTC_RV3028)
       // Compile-time forced RV-3028
-      MESH_DEBUG_PRINTLN("Using RV-3028 (compile-time forced)");
+      LOG_DEBUG("Using RV-3028 (compile-time forced)");
       rtc_wakeup = new RV3028Wakeup(&Wire, PIN_RTC_INT);
       if (!static_cast<RV3028Wakeup*>(rtc_wakeup)->begin()) {
-        MESH_DEBUG_PRINTLN("ERROR: RV-3028 initialization failed!");
+        LOG_ERROR("RV-3028 initialization failed!");
         delete rtc_wakeup;
         rtc_wakeup = nullptr;
       }
 
     #else
       // Runtime auto-detection (default)
-      MESH_DEBUG_PRINTLN("Auto-detecting RTC type...");
+      LOG_DEBUG("Auto-detecting RTC type...");
 
       // Try RV-3028 first (address 0x52)
       Wire.beginTransmission(0x52);
       if (Wire.endTransmission() == 0) {
-        MESH_DEBUG_PRINTLN("RV-3028 detected at 0x52");
+        LOG_DEBUG("RV-3028 detected at 0x52");
         rtc_wakeup = new RV3028Wakeup(&Wire, PIN_RTC_INT);
         if (!static_cast<RV3028Wakeup*>(rtc_wakeup)->begin()) {
-          MESH_DEBUG_PRINTLN("RV-3028 init failed, trying DS3231...");
+          LOG_WARN("RV-3028 init failed, trying DS3231...");
           delete rtc_wakeup;
           rtc_wakeup = nullptr;
         }
@@ -70,20 +72,35 @@ void RAK4631Board::begin() {
       if (!rtc_wakeup) {
         Wire.beginTransmission(0x68);
         if (Wire.endTransmission() == 0) {
-          MESH_DEBUG_PRINTLN("DS3231 detected at 0x68");
+          LOG_DEBUG("DS3231 detected at 0x68");
           rtc_wakeup = new DS3231Wakeup(&Wire, PIN_RTC_INT);
           static_cast<DS3231Wakeup*>(rtc_wakeup)->begin();
         } else {
-          MESH_DEBUG_PRINTLN("ERROR: No RTC detected!");
+          LOG_ERROR("No RTC detected!");
         }
       }
     #endif
 
     if (!rtc_wakeup) {
-      MESH_DEBUG_PRINTLN("FATAL: RTC wakeup initialization failed!");
+      LOG_ERROR("RTC wakeup initialization failed!");
+      TRACE(TRACE_RTC_ERROR, 1);
     }
   }
 
+  // Only a GPIO sense wake from system-off with the RTC alarm flag set counts as an RTC wake,
+  // checkWakeup() also clears the alarm flag so the INT line is released. A wake source latched
+  // without it is an event wake; with both, the periodic wake covers the event.
+  wake_events = wokeFromSystemOff() ? readWakeLatch() : 0;
+  if (wokeFromSystemOff() && rtc_wakeup && rtc_wakeup->checkWakeup()) {
+    startup_reason = BD_STARTUP_RTC_ALARM;
+  } else if (wake_events) {
+    startup_reason = BD_STARTUP_EVENT;
+  } else {
+    startup_reason = BD_STARTUP_NORMAL;
+  }
+  LOG_INFO("Startup reason: %s", startup_reason == BD_STARTUP_RTC_ALARM ? "RTC alarm" :
+                                 startup_reason == BD_STARTUP_EVENT ? "event" : "normal");
+
   pinMode(PIN_VBAT_READ, INPUT);
 #ifdef PIN_USER_BTN
   pinMode(PIN_USER_BTN, INPUT_PULLUP);
@@ -92,29 +109,140 @@ void RAK4631Board::begin() {
 #ifdef PIN_USER_BTN_ANA
   pinMode(PIN_USER_BTN_ANA, INPUT_PULLUP);
 #endif
+  // plain inputs again: the sense setting survives System OFF and would keep DETECT raised
+  for (int i = 0; i < num_wake_sources; i++) {
+    pinMode(wake_sources[i].pin, wake_sources[i].active_low ? INPUT_PULLUP : INPUT_PULLDOWN);
+  }
 
+  // Radio supply stays off until powerUpRadio(); the sensor rail is switched on here but not
+  // waited for: its settle time overlaps with filesystem/identity loading and is only enforced
+  // by waitSensorPowerReady()
   pinMode(SX126X_POWER_EN, OUTPUT);
-  digitalWrite(SX126X_POWER_EN, HIGH);
-  delay(10);   // give sx1262 some time to power up
+  digitalWrite(SX126X_POWER_EN, LOW);
+  radio_power_on_ms = 0;
 
   // Enable 3V3_S power rail for WisBlock sensor modules
   // LOW = 3V3_S OFF 
-  MESH_DEBUG_PRINTLN("Enabling switched 3V3 for sensor slots");
+  LOG_DEBUG("Enabling switched 3V3 for sensor slots");
   pinMode(PIN_3V3_S_EN, OUTPUT);
   digitalWrite(PIN_3V3_S_EN, HIGH);
-  delay(50);
+  sensor_power_on_ms = millis();
+
+  LOG_DEBUG("=== Board Startup Complete ===\n");
+}
+
+void RAK4631Board::powerUpRadio() {
+  if (isRadioPowered()) return;
+  digitalWrite(SX126X_POWER_EN, HIGH);
+  radio_power_on_ms = millis();
+  if (radio_power_on_ms == 0) radio_power_on_ms = 1;   // 0 means "off"
+}
+
+void RAK4631Board::waitSettled(uint32_t since_ms, uint32_t settle_ms) {
+  uint32_t elapsed = millis() - since_ms;
+  if (elapsed < settle_ms) {
+    delay(settle_ms - elapsed);
+  }
+}
 
-  MESH_DEBUG_PRINTLN("=== Board Startup Complete ===\n");
+// One SAADC scan instead of analogRead(): BURST runs all the oversampled conversions on a
+// single SAMPLE task, about 8 x 42 us, and the peripheral is disabled again straight after
+uint16_t RAK4631Board::scanBattMilliVolts() {
+  volatile int16_t result = 0;
+
+  NRF_SAADC->RESOLUTION = SAADC_RESOLUTION_VAL_12bit;
+  NRF_SAADC->OVERSAMPLE = BATTERY_OVERSAMPLE;
+  NRF_SAADC->CH[0].PSELP = VBAT_SAADC_INPUT;
+  NRF_SAADC->CH[0].PSELN = SAADC_CH_PSELN_PSELN_NC;
+  NRF_SAADC->CH[0].CONFIG = (SAADC_CH_CONFIG_RESP_Bypass << SAADC_CH_CONFIG_RESP_Pos) |
+                            (SAADC_CH_CONFIG_RESN_Bypass << SAADC_CH_CONFIG_RESN_Pos) |
+                            (SAADC_CH_CONFIG_GAIN_Gain1_6 << SAADC_CH_CONFIG_GAIN_Pos) |       // 3.6 V full scale,
+                            (SAADC_CH_CONFIG_REFSEL_Internal << SAADC_CH_CONFIG_REFSEL_Pos) |  // as ADC_MULTIPLIER expects
+                            (BATTERY_TACQ << SAADC_CH_CONFIG_TACQ_Pos) |
+                            (SAADC_CH_CONFIG_MODE_SE << SAADC_CH_CONFIG_MODE_Pos) |
+                            (SAADC_CH_CONFIG_BURST_Enabled << SAADC_CH_CONFIG_BURST_Pos);
+  NRF_SAADC->RESULT.PTR = (uint32_t)&result;
+  NRF_SAADC->RESULT.MAXCNT = 1;
+  NRF_SAADC->ENABLE = SAADC_ENABLE_ENABLE_Enabled << SAADC_ENABLE_ENABLE_Pos;
+
+  NRF_SAADC->EVENTS_STARTED = 0;
+  NRF_SAADC->TASKS_START = 1;
+  while (!NRF_SAADC->EVENTS_STARTED);
+  NRF_SAADC->EVENTS_END = 0;
+  NRF_SAADC->TASKS_SAMPLE = 1;
+  while (!NRF_SAADC->EVENTS_END);
+  NRF_SAADC->EVENTS_STOPPED = 0;
+  NRF_SAADC->TASKS_STOP = 1;
+  while (!NRF_SAADC->EVENTS_STOPPED);
+
+  // leave the SAADC as analogRead() expects it: disabled, channel 0 unconnected, no oversampling
+  NRF_SAADC->ENABLE = SAADC_ENABLE_ENABLE_Disabled << SAADC_ENABLE_ENABLE_Pos;
+  NRF_SAADC->CH[0].PSELP = SAADC_CH_PSELP_PSELP_NC;
+  NRF_SAADC->CH[0].CONFIG &= ~SAADC_CH_CONFIG_BURST_Msk;
+  NRF_SAADC->OVERSAMPLE = SAADC_OVERSAMPLE_OVERSAMPLE_Bypass;
+
+  int16_t raw = result < 0 ? 0 : result;   // single-ended noise around 0 V reads slightly negative
+  return (ADC_MULTIPLIER * raw) / 4096;
+}
+
+uint16_t RAK4631Board::getBattMilliVolts() {
+  uint32_t now = millis();
+  if (batt_ms == 0 || now - batt_ms >= BATTERY_CACHE_MS) {
+    batt_mv = scanBattMilliVolts();
+    batt_ms = now ? now : 1;   // 0 means "never"
+  }
+  return batt_mv;
+}
+
+int RAK4631Board::addWakeSource(uint8_t pin, bool active_low) {
+  if (num_wake_sources >= WAKE_MAX_SOURCES) return -1;
+  wake_sources[num_wake_sources].pin = pin;
+  wake_sources[num_wake_sources].active_low = active_low;
+  return num_wake_sources++;
+}
+
+bool RAK4631Board::isWakeSourceActive(int i) const {
+  return digitalRead(wake_sources[i].pin) == (wake_sources[i].active_low ? LOW : HIGH);
+}
+
+// GPIO LATCH keeps the pins whose sense condition was met across the System OFF wake reset
+uint8_t RAK4631Board::readWakeLatch() {
+  uint32_t latch0 = NRF_P0->LATCH;
+  uint32_t latch1 = NRF_P1->LATCH;
+  uint8_t events = 0;
+  for (int i = 0; i < num_wake_sources; i++) {
+    uint8_t pin = wake_sources[i].pin;
+    if ((pin < 32 ? latch0 >> pin : latch1 >> (pin - 32)) & 1) events |= 1 << i;
+  }
+  NRF_P0->LATCH = latch0;   // write 1 to clear
+  NRF_P1->LATCH = latch1;
+  return events;
+}
+
+bool RAK4631Board::isUserButtonPressed() const {
+#ifdef PIN_USER_BTN
+  pinMode(PIN_USER_BTN, INPUT_PULLUP);
+  return digitalRead(PIN_USER_BTN) == LOW;   // active low
+#else
+  return false;
+#endif
+}
+
+void RAK4631Board::setSensorPower(bool on) {
+  if (on == (digitalRead(PIN_3V3_S_EN) == HIGH)) return;
+  digitalWrite(PIN_3V3_S_EN, on ? HIGH : LOW);
+  if (on) sensor_power_on_ms = millis();   // settle time restarts
 }
 
 void RAK4631Board::powerUpPeripherals() {
-  MESH_DEBUG_PRINTLN("Power on switched 3V3 for sensor slots (HIGH)");
+  LOG_DEBUG("Power on switched 3V3 for sensor slots (HIGH)");
   digitalWrite(PIN_3V3_S_EN, HIGH);
 }
 
 void RAK4631Board::powerDownPeripherals() {
   // Power down LoRa radio
   digitalWrite(SX126X_POWER_EN, LOW);
+  radio_power_on_ms = 0;
 
   // Disable LEDs
   #ifdef LED_BUILTIN
@@ -128,39 +256,135 @@ void RAK4631Board::powerDownPeripherals() {
   // LOW = 3V3_S OFF (P-channel MOSFET gate pulled high)
   // Note: RAK12002 RTC module is powered from main 3V3 rail, not 3V3_S,
   // so it continues to run and can generate wake-up interrupts  
-  MESH_DEBUG_PRINTLN("Power off switched 3V3 for sensor slots (LOW)");
+  LOG_DEBUG("Power off switched 3V3 for sensor slots (LOW)");
   digitalWrite(PIN_3V3_S_EN, LOW);
 
-  // Put GPS to sleep if present
-  // (handled by sensor manager)
+  // A u-blox GPS was put into backup mode first (GpsDutyCycle::sleep() in main.cpp),
+  // its backup supply keeps the ephemeris for a hot start if the module has one
 }
 
+// System ON event wake: one ISR per source, as attachInterrupt() callbacks get no argument
+static NRF52RTCWakeup* wake_timer = NULL;
+static volatile uint8_t wake_pin_events = 0;
+
+template<int N>
+static void onWakePin() {
+  wake_pin_events |= 1 << N;
+  if (wake_timer) wake_timer->signal();
+}
+
+static void (* const wake_isrs[WAKE_MAX_SOURCES])() = { onWakePin<0>, onWakePin<1>, onWakePin<2>, onWakePin<3> };
+
 void RAK4631Board::enterLowPowerSleep(uint32_t sleep_seconds) {
-  MESH_DEBUG_PRINTLN("Entering low-power sleep for %d seconds", sleep_seconds);
+  LOG_DEBUG("Entering low-power sleep for %lu seconds", (unsigned long)sleep_seconds);
 
   // Setup RTC alarm for wakeup
   if (rtc_wakeup) {
     if (!rtc_wakeup->setAlarm(sleep_seconds)) {
-      MESH_DEBUG_PRINTLN("ERROR: Failed to set RTC alarm!");
+      LOG_ERROR("Failed to set RTC alarm!");
+      TRACE(TRACE_RTC_ERROR, 2);
       return;  // Don't enter sleep if alarm setup failed
     }
   } else {
-    MESH_DEBUG_PRINTLN("ERROR: RTC wakeup not initialized!");
+    LOG_ERROR("RTC wakeup not initialized!");
     return;
   }
 
+  enterSystemOff();
+}
+
+void RAK4631Board::enterLowPowerSleepUntil(uint32_t wake_time, uint32_t now) {
+  LOG_DEBUG("Entering low-power sleep until %lu (%ld seconds)", wake_time, (long)(wake_time - now));
+
+  if (rtc_wakeup) {
+    if (!rtc_wakeup->setAlarmAt(wake_time, now)) {
+      LOG_ERROR("Failed to set RTC alarm!");
+      TRACE(TRACE_RTC_ERROR, 2);
+      return;  // Don't enter sleep if alarm setup failed
+    }
+  } else {
+    LOG_ERROR("RTC wakeup not initialized!");
+    return;
+  }
+
+  enterSystemOff();
+}
+
+bool RAK4631Board::prefersSystemOn(uint32_t interval_secs, float reboot_uah) const {
+  return prefersSystemOnSleep(interval_secs, reboot_uah);
+}
+
+bool RAK4631Board::sleepSystemOn(uint32_t wake_time, uint32_t now) {
+  LOG_DEBUG("Entering System ON sleep until %lu (%ld seconds)", wake_time, (long)(wake_time - now));
+  if (!system_on_wakeup.setAlarmAt(wake_time, now)) {
+    LOG_ERROR("Failed to set RTC2 alarm!");
+    TRACE(TRACE_RTC_ERROR, 2);
+    return false;
+  }
+
+  powerDownRadio();
+  #ifdef LED_BUILTIN
+  digitalWrite(LED_BUILTIN, LOW);
+  #endif
+
+  // Sources already at their active level would fire at once, they are armed again next sleep
+  wake_timer = &system_on_wakeup;
+  wake_pin_events = 0;
+  for (int i = 0; wake_sources_armed && i < num_wake_sources; i++) {
+    if (isWakeSourceActive(i)) continue;
+    attachInterrupt(wake_sources[i].pin, wake_isrs[i], wake_sources[i].active_low ? FALLING : RISING);
+  }
+  Serial.flush();
+
+  system_on_wakeup.sleep();
+
+  for (int i = 0; i < num_wake_sources; i++) {
+    detachInterrupt(wake_sources[i].pin);
+  }
+  wake_events = wake_pin_events;
+  if (system_on_wakeup.checkWakeup()) {
+    startup_reason = BD_STARTUP_RTC_ALARM;
+    return true;
+  }
+  if (wake_events == 0) return false;
+  startup_reason = BD_STARTUP_EVENT;
+  return true;
+}
+
+void RAK4631Board::powerDownRadio() {
+  digitalWrite(SX126X_POWER_EN, LOW);
+  radio_power_on_ms = 0;
+}
+
+void RAK4631Board::enterSystemOff() {
   // Configure nRF52 to wake on RTC interrupt (active LOW) on primary pin
   nrf_gpio_cfg_sense_input(PIN_RTC_INT, NRF_GPIO_PIN_PULLUP,
                            NRF_GPIO_PIN_SENSE_LOW);
-  MESH_DEBUG_PRINTLN("PIN_RTC_INT (GPIO %d) configured for wake", PIN_RTC_INT);
+  LOG_DEBUG("PIN_RTC_INT (GPIO %d) configured for wake", PIN_RTC_INT);
+
+  // Event sources: sense is level-triggered, so a pin already at its active level (door left
+  // open, button held) is not armed - it would wake the node straight back up
+  for (int i = 0; wake_sources_armed && i < num_wake_sources; i++) {
+    if (isWakeSourceActive(i)) {
+      LOG_DEBUG("Wake source %d (GPIO %d) active, not armed", i, wake_sources[i].pin);
+      continue;
+    }
+    bool low = wake_sources[i].active_low;
+    nrf_gpio_cfg_sense_input(wake_sources[i].pin, low ? NRF_GPIO_PIN_PULLUP : NRF_GPIO_PIN_PULLDOWN,
+                             low ? NRF_GPIO_PIN_SENSE_LOW : NRF_GPIO_PIN_SENSE_HIGH);
+  }
+  NRF_P0->LATCH = NRF_P0->LATCH;   // start from a clean latch, only this sleep's wake is recorded
+  NRF_P1->LATCH = NRF_P1->LATCH;
 
-  MESH_DEBUG_PRINTLN("Entering system-off mode...");
+  LOG_DEBUG("Entering system-off mode...");
   Serial.flush();  // Ensure all serial data is sent
-  delay(100);      // Give time for serial transmission
 
   // Power down peripherals (this will drive GPIO 34 LOW for 3V3_S control)
   powerDownPeripherals();
 
+  // Keep the RAM sections holding retained state (boot snapshot etc.) powered in system-off
+  RetainedRAM::applyRetention();
+
   // Enter system-off mode directly (no SoftDevice dependency)
   // The GPIO sense configuration will wake the system on RTC alarm
   NRF_POWER->SYSTEMOFF = 1;
@@ -3,6 +3,9 @@
 #include <MeshCore.h>
 #include <Arduino.h>
 #include "RTCWakeup.h"
+#include "NRF52RTCWakeup.h"
+#include "SleepMode.h"
+#include "RetainedRAM.h"
 
 // LoRa radio module pins for RAK4631
 #define  P_LORA_DIO_1   47
@@ -38,30 +41,96 @@
 #define  PIN_VBAT_READ    5
 #define  ADC_MULTIPLIER   (3 * 1.73 * 1.187 * 1000)
 
+// Battery scan: one SAADC burst (BATTERY_OVERSAMPLE conversions averaged in hardware) on
+// PIN_VBAT_READ = P0.05 = AIN3, behind a 1M/1.5M divider, hence the long acquisition time
+#define  VBAT_SAADC_INPUT     SAADC_CH_PSELP_PSELP_AnalogInput3
+#define  BATTERY_OVERSAMPLE   SAADC_OVERSAMPLE_OVERSAMPLE_Over8x
+#define  BATTERY_TACQ         SAADC_CH_CONFIG_TACQ_40us
+#ifndef BATTERY_CACHE_MS
+  #define BATTERY_CACHE_MS    250     // getBattMilliVolts() reuses a scan this recent
+#endif
+
+// Rail settle times (ms) - waited for lazily, just before first use of the rail
+#define  SX126X_POWER_SETTLE_MS   10
+#define  SENSOR_RAIL_SETTLE_MS    50
+
+// Sleep current estimates for choosing System ON vs System OFF: SLEEP_SYSTEM_*_UA in SleepMode.h
+
+// Startup reason reported when the wake was triggered by an RTC alarm from system-off
+// (MeshCore defines BD_STARTUP_NORMAL=0 and BD_STARTUP_RX_PACKET=1)
+#ifndef BD_STARTUP_RTC_ALARM
+  #define BD_STARTUP_RTC_ALARM  2
+#endif
+// ... and when a wake source pin (addWakeSource()) woke it instead, without the RTC alarm
+#ifndef BD_STARTUP_EVENT
+  #define BD_STARTUP_EVENT      3
+#endif
+
+// Event wake sources besides PIN_RTC_INT (GPIO sense in System OFF, pin interrupt in System ON)
+#define WAKE_MAX_SOURCES        4
+
 class RAK4631Board : public mesh::MainBoard {
 protected:
   uint8_t startup_reason;
   RTCWakeup* rtc_wakeup;
+  NRF52RTCWakeup system_on_wakeup;
+  uint32_t radio_power_on_ms;    // millis() when SX126X_POWER_EN was raised
+  uint32_t sensor_power_on_ms;   // millis() when 3V3_S was enabled
+  uint16_t batt_mv;              // last idle battery scan
+  uint32_t batt_ms;              // millis() of that scan (0 = none yet)
+  uint16_t batt_loaded_mv;       // last scan right after a TX (0 = none yet)
+  struct { uint8_t pin; bool active_low; } wake_sources[WAKE_MAX_SOURCES];
+  uint8_t num_wake_sources;
+  bool wake_sources_armed;
+  uint8_t wake_events;           // sources that fired for this wake, bit per addWakeSource() index
+
+  void waitSettled(uint32_t since_ms, uint32_t settle_ms);
+  uint16_t scanBattMilliVolts();
+  void enterSystemOff();
+  uint8_t readWakeLatch();       // sources latched by GPIO sense, clears their LATCH bits
 
 public:
-  RAK4631Board() : startup_reason(0), rtc_wakeup(nullptr) {}
+  RAK4631Board() : startup_reason(0), rtc_wakeup(nullptr), radio_power_on_ms(0), sensor_power_on_ms(0),
+                   batt_mv(0), batt_ms(0), batt_loaded_mv(0), num_wake_sources(0), wake_sources_armed(true),
+                   wake_events(0) {}
 
   void begin();
   uint8_t getStartupReason() const override { return startup_reason; }
 
-  #define BATTERY_SAMPLES 8
-
-  uint16_t getBattMilliVolts() override {
-    analogReadResolution(12);
-
-    uint32_t raw = 0;
-    for (int i = 0; i < BATTERY_SAMPLES; i++) {
-      raw += analogRead(PIN_VBAT_READ);
-    }
-    raw = raw / BATTERY_SAMPLES;
-
-    return (ADC_MULTIPLIER * raw) / 4096;
-  }
+  // Boot path selection (can be called before begin())
+  bool wokeFromSystemOff() const { return (readResetReason() & POWER_RESETREAS_OFF_Msk) != 0; }
+  bool isUsbPowered() const { return (NRF_POWER->USBREGSTATUS & POWER_USBREGSTATUS_VBUSDETECT_Msk) != 0; }
+  bool isUserButtonPressed() const;
+
+  /**
+   * Add a pin that wakes the node from either sleep mode, eg. a sensor INT line or the user button
+   * Register before begin(), which tells an event wake (BD_STARTUP_EVENT) from an RTC one.
+   * @return the source's bit in getWakeEvents(), -1 when all WAKE_MAX_SOURCES are used
+   */
+  int addWakeSource(uint8_t pin, bool active_low);
+  int getNumWakeSources() const { return num_wake_sources; }
+  uint8_t getWakeSourcePin(int i) const { return wake_sources[i].pin; }
+  bool isWakeSourceActive(int i) const;          // pin at its active level now
+  void setWakeSourcesArmed(bool armed) { wake_sources_armed = armed; }   // for the next sleep
+  uint8_t getWakeEvents() const { return wake_events; }
+
+  // SX1262 supply is left off by begin(), so RTC wakes with nothing to send never power the radio
+  void powerUpRadio();
+  bool isRadioPowered() const { return radio_power_on_ms != 0; }
+  uint32_t getRadioPowerOnMillis() const { return radio_power_on_ms; }
+
+  // Block only for whatever is left of the rail settle time after power-up
+  void waitRadioPowerReady() { waitSettled(radio_power_on_ms, SX126X_POWER_SETTLE_MS); }
+  void waitSensorPowerReady() { waitSettled(sensor_power_on_ms, SENSOR_RAIL_SETTLE_MS); }
+  void setSensorPower(bool on);   // 3V3_S rail, eg. off for the rest of a wake when no sensor is fitted
+
+  // Battery voltage from one SAADC scan, or the cached one if taken within BATTERY_CACHE_MS
+  uint16_t getBattMilliVolts() override;
+  uint32_t getBattMillis() const { return batt_ms; }   // when the cached value was measured (0 = never)
+
+  // Scan right after a TX, while the battery still shows the radio's load (kept apart from the cache)
+  uint16_t measureLoadedBattery() { return batt_loaded_mv = scanBattMilliVolts(); }
+  uint16_t getLoadedBattMilliVolts() const { return batt_loaded_mv; }
 
   const char* getManufacturerName() const override {
     return "RAK 4631";
@@ -71,7 +140,29 @@ public:
     NVIC_SystemReset();
   }
 
+  // System-ON idle: delay() blocks the Arduino loop task, so the FreeRTOS idle task
+  // (tickless, RTC1 as tick source) parks the core in WFE until the timeout expires.
+  // The SoftDevice is not enabled outside OTA, so no sd_app_evt_wait() is involved.
+  void idleCore(uint32_t ms) { delay(ms); }
+  // SX1262 holds DIO1 high until its IRQ status is cleared by the driver
+  bool isRadioIrqPending() const { return isRadioPowered() && digitalRead(P_LORA_DIO_1) == HIGH; }
+
   void enterLowPowerSleep(uint32_t sleep_seconds);
+  void enterLowPowerSleepUntil(uint32_t wake_time, uint32_t now);   // absolute RTC time (UNIX secs)
+
+  /**
+   * True when sleeping in System ON for this interval costs less than a System OFF cycle,
+   * ie. the extra sleep current over the interval is below the cost of a reboot + setup()
+   * @param reboot_uah  charge of the reset-to-ready part of a wake (measured by the caller)
+   */
+  bool prefersSystemOn(uint32_t interval_secs, float reboot_uah) const;
+
+  /**
+   * System ON sleep on the nRF52 RTC2 until wake_time: RAM and peripherals are kept, the SX1262
+   * supply is cut (re-initialise before use). Returns after the alarm, false if it could not be set.
+   */
+  bool sleepSystemOn(uint32_t wake_time, uint32_t now);
+  void powerDownRadio();
   void powerDownPeripherals();
   void powerUpPeripherals();
 
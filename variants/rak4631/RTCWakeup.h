@@ -7,7 +7,7 @@
  *
  * Provides minimal interface needed for low-power sleeping sensors:
  * - Check if wake was triggered by RTC alarm
- * - Set next alarm for timed wakeup
+ * - Set next alarm for timed wakeup (relative, or at an absolute wall-clock time)
  */
 class RTCWakeup {
 public:
@@ -23,10 +23,22 @@ public:
    * Set an alarm to trigger after the specified number of seconds
    * Used to schedule the next wakeup before entering low-power sleep
    *
-   * @param seconds Number of seconds until alarm should trigger
+   * @param seconds Number of seconds until alarm should trigger (multi-day sleeps are
+   *                allowed; long intervals may be rounded to the RTC's coarser resolution)
    * @return true if alarm was set successfully, false on error
    */
-  virtual bool setAlarm(uint16_t seconds) = 0;
+  virtual bool setAlarm(uint32_t seconds) = 0;
+
+  /**
+   * Set an alarm to trigger at an absolute time
+   * Lets the caller schedule fixed wall-clock slots, so time spent awake does not
+   * accumulate as drift from one cycle to the next
+   *
+   * @param wake_time  UNIX time (secs) the alarm should trigger at
+   * @param now        current UNIX time, as kept by the same RTC
+   * @return true if alarm was set successfully, false on error (eg. wake_time not in the future)
+   */
+  virtual bool setAlarmAt(uint32_t wake_time, uint32_t now) = 0;
 
   virtual ~RTCWakeup() {}
 };
@@ -1,5 +1,6 @@
 #include "RV3028Wakeup.h"
 #include <Arduino.h>
+#include "LogLevel.h"
 
 RV3028Wakeup::RV3028Wakeup(TwoWire* wire, uint8_t int_pin)
     : _wire(wire), _int_pin(int_pin) {
@@ -12,16 +13,16 @@ bool RV3028Wakeup::begin() {
   // Probe I2C to verify RTC presence
   _wire->beginTransmission(RV3028_I2C_ADDRESS);
   if (_wire->endTransmission() != 0) {
-    MESH_DEBUG_PRINTLN("RV-3028 not detected at 0x52");
+    LOG_WARN("RV-3028 not detected at 0x52");
     return false;
   }
 
-  MESH_DEBUG_PRINTLN("RV-3028 initialized successfully");
+  LOG_DEBUG("RV-3028 initialized successfully");
   return true;
 }
 
 bool RV3028Wakeup::checkWakeup() {
-  MESH_DEBUG_PRINTLN("\n=== Checking RTC Wakeup (RV-3028) ===");
+  LOG_DEBUG("\n=== Checking RTC Wakeup (RV-3028) ===");
 
   // Read timer countdown value to see if timer was running
   uint8_t timer_lsb = _rtc.readFromRegister(TIMER_VALUE_0_ADDRESS);
@@ -35,36 +36,82 @@ bool RV3028Wakeup::checkWakeup() {
   // Read status register to check for timer event flag
   uint8_t status = _rtc.readFromRegister(STATUS_REGISTER_ADDRESS);
 
-  MESH_DEBUG_PRINTLN("RV-3028 Status register: 0x%02X", status);
-  MESH_DEBUG_PRINTLN("  TF (Timer Flag): %d", (status & TIMER_EVENT_FLAG) ? 1 : 0);
-  MESH_DEBUG_PRINTLN("  AF (Alarm Flag): %d", (status & ALARM_FLAG) ? 1 : 0);
-  MESH_DEBUG_PRINTLN("Timer remaining: %d ticks", timer_remaining);
-  MESH_DEBUG_PRINTLN("Control1: 0x%02X (TE=%d)", control1, (control1 & TIMER_ENABLE_FLAG) ? 1 : 0);
-  MESH_DEBUG_PRINTLN("Control2: 0x%02X (TIE=%d)", control2, (control2 & TIMER_INTERRUPT_ENABLE_FLAG) ? 1 : 0);
+  LOG_DEBUG("RV-3028 Status register: 0x%02X", status);
+  LOG_DEBUG("  TF (Timer Flag): %d", (status & TIMER_EVENT_FLAG) ? 1 : 0);
+  LOG_DEBUG("  AF (Alarm Flag): %d", (status & ALARM_FLAG) ? 1 : 0);
+  LOG_DEBUG("Timer remaining: %d ticks", timer_remaining);
+  LOG_DEBUG("Control1: 0x%02X (TE=%d)", control1, (control1 & TIMER_ENABLE_FLAG) ? 1 : 0);
+  LOG_DEBUG("Control2: 0x%02X (TIE=%d)", control2, (control2 & TIMER_INTERRUPT_ENABLE_FLAG) ? 1 : 0);
 
-  // Check if timer event flag is set
-  bool timer_triggered = (status & TIMER_EVENT_FLAG) != 0;
+  // Check if timer event flag (or the calendar alarm flag, for long sleeps) is set
+  bool timer_triggered = (status & (TIMER_EVENT_FLAG | ALARM_FLAG)) != 0;
 
   if (timer_triggered) {
-    MESH_DEBUG_PRINTLN("Timer triggered! Clearing flags...");
-    // Clear the timer flag
-    _rtc.clearInterruptFlags(true, false, false);
+    LOG_DEBUG("Timer triggered! Clearing flags...");
+    // Clear the timer and alarm flags
+    _rtc.clearInterruptFlags(true, true, false);
+    if (status & ALARM_FLAG) _rtc.disableAlarm();
     return true;
   } else {
-    MESH_DEBUG_PRINTLN("Timer not triggered");
+    LOG_DEBUG("Timer not triggered");
   }
 
   return false;
 }
 
-bool RV3028Wakeup::setAlarm(uint16_t seconds) {
-  MESH_DEBUG_PRINTLN("\n=== RV-3028 Timer Setup ===");
-  MESH_DEBUG_PRINTLN("Sleep duration: %d seconds", seconds);
+bool RV3028Wakeup::setAlarm(uint32_t seconds) {
+  LOG_DEBUG("\n=== RV-3028 Timer Setup ===");
+  LOG_DEBUG("Sleep duration: %lu seconds", seconds);
+
+  if (seconds == 0 || seconds > RV3028_MAX_ALARM_SECS) {
+    LOG_ERROR("sleep of %lu seconds out of range", seconds);
+    return false;
+  }
+  if (seconds > RV3028_MAX_TIMER_MINS * 60UL) {
+    // beyond the countdown timer: calendar alarm relative to the RTC's own clock
+    DateTime now(2000 + _rtc.getYear() % 100, _rtc.getMonth(), _rtc.getDate(),
+                 _rtc.getHour(), _rtc.getMinute(), _rtc.getSecond());
+    return armCalendarAlarm(now.unixtime() + seconds);
+  }
 
   _rtc.disablePeriodicTimeUpdate();
   _rtc.disableAlarm();
-  _rtc.enablePeriodicTimer(seconds, TimerClockFrequency::Hz1, false, true);
+  if (seconds <= RV3028_MAX_TIMER_TICKS) {
+    _rtc.enablePeriodicTimer(seconds, TimerClockFrequency::Hz1, false, true);
+  } else {
+    // 1/60 Hz clock: minute ticks, the first one may be short by up to a minute
+    uint16_t minutes = (seconds + 30) / 60;
+    LOG_DEBUG("Long timer: %d minutes", minutes);
+    _rtc.enablePeriodicTimer(minutes, TimerClockFrequency::Hz1_60, false, true);
+  }
+
+  LOG_DEBUG("=== Timer Setup Complete ===\n");
+  return true;
+}
+
+bool RV3028Wakeup::setAlarmAt(uint32_t wake_time, uint32_t now) {
+  if (wake_time <= now || wake_time - now > RV3028_MAX_ALARM_SECS) {
+    LOG_ERROR("wake time %lu out of range (now %lu)", wake_time, now);
+    return false;
+  }
+  if (wake_time - now > RV3028_MAX_TIMER_MINS * 60UL) {
+    return armCalendarAlarm(wake_time);   // RTC keeps the same UTC time, no need to read it back
+  }
+  return setAlarm(wake_time - now);
+}
+
+bool RV3028Wakeup::armCalendarAlarm(uint32_t wake_time) {
+  // Alarm matches date/hour/minute and fires at second 0, so round to the nearest minute
+  DateTime when(wake_time + 30);
+  LOG_DEBUG("\n=== RV-3028 Alarm Setup ===");
+  LOG_DEBUG("Wake time: date %02d %02d:%02d", when.day(), when.hour(), when.minute());
+
+  _rtc.disablePeriodicTimeUpdate();
+  _rtc.disablePeriodicTimer();
+  _rtc.clearInterruptFlags(true, true, false);
+  _rtc.setDateModeForAlarm(true);
+  _rtc.enableAlarm(when.day(), when.hour(), when.minute(), true, true, true, true);
 
-  MESH_DEBUG_PRINTLN("=== Timer Setup Complete ===\n");
+  LOG_DEBUG("=== Alarm Setup Complete ===\n");
   return true;
 }
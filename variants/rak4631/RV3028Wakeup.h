@@ -4,10 +4,16 @@
 #include <Wire.h>
 #include <Melopero_RV3028.h>
 #include <MeshCore.h>
+#include <RTClib.h>   // DateTime
 
 // RV-3028 I2C address (already defined in library, but redefined for clarity)
 #define RV3028_I2C_ADDRESS 0x52
 
+// Countdown timer is 12 bits; beyond RV3028_MAX_TIMER_MINS the calendar alarm is used
+#define RV3028_MAX_TIMER_TICKS   4095
+#define RV3028_MAX_TIMER_MINS    4095                 // 1/60 Hz clock, ~68 hours
+#define RV3028_MAX_ALARM_SECS    (28 * 86400UL)       // date match, less than the shortest month
+
 /**
  * RV-3028 Real-Time Clock wakeup implementation
  *
@@ -15,8 +21,8 @@
  * Uses the countdown timer for timed wakeups and the INT pin for GPIO sense triggering.
  *
  * Key differences from DS3231:
- * - Uses countdown timer (relative) instead of alarm (absolute)
- * - Provides second-level precision instead of minute-level
+ * - Uses countdown timer (relative) instead of alarm (absolute), except for sleeps
+ *   beyond the timer range which fall back to the minute-resolution calendar alarm
  * - More power efficient
  * - I2C address: 0x52 (vs DS3231's 0x68)
  */
@@ -26,6 +32,11 @@ private:
   TwoWire* _wire;
   uint8_t _int_pin;  // GPIO pin connected to RV-3028 INT
 
+  /**
+   * Program the date/hour/minute alarm (nearest minute) and stop the countdown timer
+   */
+  bool armCalendarAlarm(uint32_t wake_time);
+
 public:
   /**
    * Constructor
@@ -54,12 +65,22 @@ public:
 
   /**
    * Set alarm to wake after specified number of seconds
-   * Uses RV-3028 countdown timer with automatic frequency selection:
-   * - Short durations (≤4095s): 1Hz timer for second-level precision
-   * - Long durations (>4095s): 1/60Hz timer (minute-level) to support longer sleep
+   * Automatic mode selection:
+   * - Short durations (≤4095s): 1Hz countdown timer for second-level precision
+   * - Up to 4095 minutes (~68h): 1/60Hz countdown timer (minute-level)
+   * - Longer (up to 28 days): calendar alarm on date/hour/minute
    *
-   * @param seconds Number of seconds until wakeup (max ~65535 minutes = 45.5 days)
+   * @param seconds Number of seconds until wakeup
    * @return true if alarm set successfully, false on error
    */
-  bool setAlarm(uint16_t seconds) override;
+  bool setAlarm(uint32_t seconds) override;
+
+  /**
+   * Set alarm for an absolute time
+   * The RV-3028 alarm only matches minutes, so this runs the countdown timer for wake_time - now
+   * where it reaches, and the calendar alarm beyond that
+   *
+   * @return true if alarm set successfully, false if wake_time is not in the future
+   */
+  bool setAlarmAt(uint32_t wake_time, uint32_t now) override;
 };
@@ -0,0 +1,70 @@
+#include "RetainedRAM.h"
+#include <Arduino.h>
+#include "LogLevel.h"
+
+struct RetainedRegion {
+  uintptr_t start;
+  uintptr_t end;  // exclusive
+};
+
+static RetainedRegion regions[RETAINED_RAM_MAX_REGIONS];
+static uint8_t num_regions = 0;
+
+// nRF52840 RAM layout: RAM0..RAM7 are 2 x 4KB sections each from 0x20000000,
+// RAM8 is 6 x 32KB sections from 0x20010000
+#define NRF_RAM_BASE          0x20000000UL
+#define NRF_RAM8_BASE         0x20010000UL
+#define NRF_RAM_END           0x20040000UL
+#define NRF_RAM_SMALL_SECT    0x1000UL
+#define NRF_RAM_LARGE_SECT    0x8000UL
+
+uint32_t RetainedRAM::crc32(const void* data, size_t len, uint32_t crc) {
+  const uint8_t* p = (const uint8_t*) data;
+  crc = ~crc;
+  while (len--) {
+    crc ^= *p++;
+    for (int k = 0; k < 8; k++) {
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+void RetainedRAM::retain(const void* addr, size_t len) {
+  uintptr_t start = (uintptr_t) addr;
+  for (int i = 0; i < num_regions; i++) {
+    if (regions[i].start == start) return;   // already registered
+  }
+  if (num_regions >= RETAINED_RAM_MAX_REGIONS) {
+    LOG_ERROR("RetainedRAM: too many regions, 0x%08lX not retained", start);
+    return;
+  }
+  regions[num_regions].start = start;
+  regions[num_regions].end = start + len;
+  num_regions++;
+}
+
+static void retainSection(uintptr_t addr) {
+  if (addr < NRF_RAM_BASE || addr >= NRF_RAM_END) return;
+
+  uint32_t block, section;
+  if (addr < NRF_RAM8_BASE) {
+    uint32_t idx = (addr - NRF_RAM_BASE) / NRF_RAM_SMALL_SECT;
+    block = idx / 2;
+    section = idx % 2;
+  } else {
+    block = 8;
+    section = (addr - NRF_RAM8_BASE) / NRF_RAM_LARGE_SECT;
+  }
+  NRF_POWER->RAM[block].POWERSET = (1UL << (POWER_RAM_POWER_S0RETENTION_Pos + section));
+}
+
+void RetainedRAM::applyRetention() {
+  for (int i = 0; i < num_regions; i++) {
+    // walk the region one small section at a time (large sections just get set repeatedly)
+    for (uintptr_t a = regions[i].start; a < regions[i].end; a += NRF_RAM_SMALL_SECT) {
+      retainSection(a);
+    }
+    retainSection(regions[i].end - 1);
+  }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <type_traits>
+
+/**
+ * Retained RAM support for system-off sleep
+ *
+ * Objects tagged RETAINED_RAM live in the .noinit section, so the C runtime neither zeroes
+ * nor initialises them on reset. The nRF52840 only keeps a RAM section powered in system-off
+ * if its SxRETENTION bit is set, so every retained object must be registered with
+ * RetainedRAM::retain() once per boot; the board applies the retention bits just before
+ * NRF_POWER->SYSTEMOFF. After a power cycle the contents are garbage, which is why all
+ * retained state is wrapped in a CRC-guarded RetainedBlock.
+ */
+#define RETAINED_RAM  __attribute__((section(".noinit")))
+
+#define RETAINED_RAM_MAX_REGIONS   16
+
+class RetainedRAM {
+public:
+  /**
+   * CRC-32 (IEEE 802.3, reflected) - small table-less implementation
+   */
+  static uint32_t crc32(const void* data, size_t len, uint32_t crc = 0);
+
+  /**
+   * Register a memory region which must survive system-off
+   */
+  static void retain(const void* addr, size_t len);
+
+  /**
+   * Set the RAM section retention bits for all registered regions
+   * Call immediately before entering system-off
+   */
+  static void applyRetention();
+};
+
+/**
+ * CRC-guarded block of retained state
+ *
+ * T must be trivial: a constructor would run at static-init time and wipe the retained data.
+ * The stored size doubles as a layout version, so a block written by firmware with a
+ * different struct layout is rejected instead of misread.
+ */
+template<typename T, uint32_t MAGIC>
+struct RetainedBlock {
+  static_assert(std::is_trivial<T>::value, "retained data must be a trivial type");
+
+  uint32_t magic;
+  uint32_t size;
+  uint32_t crc;
+  T data;
+
+  bool isValid() const {
+    return magic == MAGIC && size == sizeof(T) && crc == RetainedRAM::crc32(&data, sizeof(T));
+  }
+  void commit() {
+    magic = MAGIC;
+    size = sizeof(T);
+    crc = RetainedRAM::crc32(&data, sizeof(T));
+  }
+  void invalidate() { magic = 0; }
+  void retain() { RetainedRAM::retain(this, sizeof(*this)); }
+};
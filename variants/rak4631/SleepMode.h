@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * System ON vs System OFF sleep choice of the RAK4631 (RAK4631Board::prefersSystemOn)
+ *
+ * Hardware-free so the host simulation takes the same decision from the same numbers.
+ */
+
+// RTC2 runs from the 32.768 kHz LFCLK (already started for the FreeRTOS tick on RTC1)
+#define NRF52_RTC_PRESCALER     4095                               // 8 Hz tick, 125 ms resolution
+#define NRF52_RTC_TICK_HZ       (32768 / (NRF52_RTC_PRESCALER + 1))
+#define NRF52_RTC_MAX_SECS      ((0xFFFFFFUL / NRF52_RTC_TICK_HZ) - 1)   // 24-bit counter, ~24 days
+
+// Sleep current estimates for choosing System ON vs System OFF (override per build)
+#ifndef SLEEP_SYSTEM_OFF_UA
+  #define SLEEP_SYSTEM_OFF_UA     2.0f    // System OFF + external RTC
+#endif
+#ifndef SLEEP_SYSTEM_ON_UA
+  #define SLEEP_SYSTEM_ON_UA      15.0f   // System ON idle with RTC2 (~3 uA) + 3V3_S sensors left powered
+#endif
+
+// System ON when the interval fits RTC2 and its extra sleep current costs less than a reboot
+inline bool prefersSystemOnSleep(uint32_t interval_secs, float reboot_uah) {
+  float extra_uah = (SLEEP_SYSTEM_ON_UA - SLEEP_SYSTEM_OFF_UA) * interval_secs / 3600.0f;
+  return interval_secs <= NRF52_RTC_MAX_SECS && extra_uah < reboot_uah;
+}
@@ -25,15 +25,17 @@ VolatileRTCClock fallback_clock;
 AutoDiscoverRTCClock rtc_clock(fallback_clock);
 
 #if ENV_INCLUDE_GPS
-  #include <helpers/sensors/MicroNMEALocationProvider.h>
   MicroNMEALocationProvider nmea = MicroNMEALocationProvider(Serial1);
-  EnvironmentSensorManager sensors = EnvironmentSensorManager(nmea);
+  CachedSensorManager sensors = CachedSensorManager(nmea);
 #else
-  EnvironmentSensorManager sensors;
+  CachedSensorManager sensors;
 #endif
 
-bool radio_init() {
+void rtc_init() {
   rtc_clock.begin(Wire);
+}
+
+bool radio_init() {
   return radio.std_init(&SPI);
 }
 